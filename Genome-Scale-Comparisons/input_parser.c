@@ -1,11 +1,12 @@
 #include "input_parser.h"
+#include "input_stream.h"
 
 void print_usage() {
     printf("Usage: <executable> <input file containing sequence s> <input alphabet file>\n");
 }
 
 Sequence* read_single_sequence(const char *filename) {
-    FILE *file = fopen(filename, "r");
+    InputStream *file = open_input_stream(filename, 0); // gzip/BGZF inflated on the fly
     if (!file) {
         perror("Error opening file");
         return NULL;
@@ -13,7 +14,7 @@ Sequence* read_single_sequence(const char *filename) {
 
     Sequence *seq = malloc(sizeof(Sequence));
     if (!seq) {
-        fclose(file);
+        close_input_stream(file);
         return NULL;
     }
 
@@ -21,24 +22,25 @@ Sequence* read_single_sequence(const char *filename) {
     seq->sequence = malloc(INITIAL_MAX_SEQ_LEN);
     if (!seq->sequence) {
         free(seq);
-        fclose(file);
+        close_input_stream(file);
         return NULL;
     }
     seq->sequence[0] = '\0';
 
-    char line[600];
+    char *line = NULL; // whole lines, so a long header is never mistaken for sequence
+    size_t capacity = 0;
     size_t allocated = INITIAL_MAX_SEQ_LEN;
     size_t length = 0;
 
     // read name from first line
-    if (fgets(line, sizeof(line), file)) {
+    if (input_stream_getline(&line, &capacity, file) > 0) {
         if (line[0] == '>') {
             // use the filename (without path) as the sequence name
             const char *base = strrchr(filename, '/');
             base = base ? base + 1 : filename;
 
-            char *dot = strrchr(base, '.');
-            size_t name_len = dot ? (size_t)(dot - base) : strlen(base);
+            // drop a .gz/.bgz compression suffix, then the extension
+            size_t name_len = input_file_stem_length(base);
 
             seq->name = (char *)malloc(name_len + 1);
             if (seq->name) {
@@ -49,8 +51,8 @@ Sequence* read_single_sequence(const char *filename) {
     }
 
     // read sequence data
-    while (fgets(line, sizeof(line), file)) {
-        size_t line_len = strlen(line);
+    size_t line_len;
+    while ((line_len = input_stream_getline(&line, &capacity, file)) > 0) {
         if (line_len > 0 && line[line_len-1] == '\n') {
             line[line_len-1] = '\0';
             line_len--;
@@ -60,18 +62,20 @@ Sequence* read_single_sequence(const char *filename) {
             allocated = (length + line_len + 1) * 2;
             char *temp = realloc(seq->sequence, allocated);
             if (!temp) {
+                free(line);
                 free(seq->name);
                 free(seq->sequence);
                 free(seq);
-                fclose(file);
+                close_input_stream(file);
                 return NULL;
             }
             seq->sequence = temp;
         }
 
-        strcat(seq->sequence, line);
+        memcpy(seq->sequence + length, line, line_len + 1);
         length += line_len;
     }
+    free(line);
 
     // add $
     if (length + 2 > allocated) {
@@ -80,7 +84,7 @@ Sequence* read_single_sequence(const char *filename) {
             free(seq->name);
             free(seq->sequence);
             free(seq);
-            fclose(file);
+            close_input_stream(file);
             return NULL;
         }
         seq->sequence = temp;
@@ -88,7 +92,13 @@ Sequence* read_single_sequence(const char *filename) {
     seq->sequence[length] = '$';
     seq->sequence[length+1] = '\0';
 
-    fclose(file);
+    if (close_input_stream(file) != 0) {
+        fprintf(stderr, "Error: %s is corrupt or truncated\n", filename);
+        free(seq->name);
+        free(seq->sequence);
+        free(seq);
+        return NULL;
+    }
     return seq;
 }
 
@@ -13,7 +13,7 @@
 // Prints command prompt guide for inputting params and configs.
 void print_usage();
 
-// Reads a single string sequence
+// Reads a single string sequence (plain, gzip or BGZF compressed)
 Sequence* read_single_sequence(const char *filename);
 
 char* read_alphabet(const char* filename);
@@ -67,8 +67,8 @@ SimilarityCell compute_pair_similarity(const char *s1, const char *s2, const cha
     // START TIMER FOR SUFF TREE CONSTRUCTION
     time_t start_time = time(NULL);
     
-    Node *root = build_suffix_tree(concat, alphabet, false);
-    if (!root) {
+    SuffixTree *st = build_suffix_tree(concat, alphabet, false);
+    if (!st) {
         fprintf(stderr, "ERROR: Failed to build suffix tree\n");
         free(concat);
         return (SimilarityCell){0, 0};
@@ -87,12 +87,12 @@ SimilarityCell compute_pair_similarity(const char *s1, const char *s2, const cha
 
     // find LCS
     fprintf(stderr, "DEBUG: Finding longest common substring\n");
-    LongestRepeat lcs = find_longest_common_substring(root, s1, s2, alphabet);
+    LongestRepeat lcs = find_longest_common_substring(st, s1, s2);
 
     if (lcs.length == 0) {
         fprintf(stderr, "DEBUG: No common substring found\n");
         free(concat);
-        free_suffix_tree(root, alphabet);
+        free_suffix_tree(st);
         return (SimilarityCell){0, 0}; // Return default struct if no LCS
     }
 
@@ -115,7 +115,7 @@ SimilarityCell compute_pair_similarity(const char *s1, const char *s2, const cha
         free(prefix1);
         free(prefix2);
         free(concat);
-        free_suffix_tree(root, alphabet);
+        free_suffix_tree(st);
         free(lcs.positions);
         return (SimilarityCell){0, 0};
     }
@@ -135,7 +135,7 @@ SimilarityCell compute_pair_similarity(const char *s1, const char *s2, const cha
         free(prefix1_rev);
         free(prefix2_rev);
         free(concat);
-        free_suffix_tree(root, alphabet);
+        free_suffix_tree(st);
         free(lcs.positions);
         return (SimilarityCell){0, 0};
     }
@@ -168,6 +168,7 @@ SimilarityCell compute_pair_similarity(const char *s1, const char *s2, const cha
 
     // clean up memory
     free(concat);
+    free_suffix_tree(st);
     free(lcs.positions);
     free(prefix1);
     free(prefix2);
@@ -183,92 +184,92 @@ SimilarityCell compute_pair_similarity(const char *s1, const char *s2, const cha
     return (SimilarityCell){alignment_score, lcs.length};
 }
 
-// Finds the longest common substring between two strings using GST
-SubtreeColor dfs_lcs(Node *node, int len1, int len2, LongestRepeat *result) {
-    SubtreeColor color = {0, 0};
+// helper functions for the longest common substring: a leaf colors its parent by the string it comes from, and a
+// finished internal node passes its color up; a node colored by both strings spells a common substring (context: LcsWalk)
+bool lcs_enter(const SuffixTree *st, NodeId node, int level, void *context) {
+    const NodeTable *tree = &st->nodes;
+    LcsWalk *walk = (LcsWalk *)context;
 
-    // check if the current node is valid
-    if (!node) return color;
+    if (is_leaf(tree, node)) {
+        walk->color[node_parent(tree, node) - tree->str_len] |= ((int)node < walk->len1) ? COLOR_S1 : COLOR_S2;
+        return false;
+    }
+    walk->color[node - tree->str_len] = 0;
+    return true;
+}
 
-    int is_leaf_flag = 1;
+void lcs_leave(const SuffixTree *st, NodeId node, int level, void *context) {
+    const NodeTable *tree = &st->nodes;
+    LcsWalk *walk = (LcsWalk *)context;
+    LongestRepeat *result = walk->result;
+    int len1 = walk->len1;
+
+    if (is_leaf(tree, node) || is_root(tree, node)) return;
+
+    uint8_t color = walk->color[node - tree->str_len];
+    walk->color[node_parent(tree, node) - tree->str_len] |= color;
+
+    // if both strings are represented in the subtree, check if the current depth is greater than the recorded result length
+    int depth = node_depth(tree, node);
+    if (color == (COLOR_S1 | COLOR_S2) && depth > result->length) {
+        result->length = depth;
+        free(result->positions);
+        result->positions = NULL;
+        result->count = 0;
+
+        // find representative leaf under this node from both strings
+        int pos1 = -1, pos2 = -1;
+        for (NodeId child = first_child(tree, node); child != NO_NODE && (pos1 == -1 || pos2 == -1); child = next_sibling(tree, child)) {
+            // search to the leaf to find the representative
+            NodeId leaf = child;
+            while (!is_leaf(tree, leaf)) {
+                leaf = first_child(tree, leaf);
+            }
 
-    // loop through each child of the current node
-    for (int i = 0; i < DNA_ALPHABET_SIZE; i++) {
-        if (node->children[i]) {
-            is_leaf_flag = 0;
-            SubtreeColor child_color = dfs_lcs(node->children[i], len1, len2, result);
-            color.from_s1 |= child_color.from_s1;
-            color.from_s2 |= child_color.from_s2;
+            // reaching the leaf, calculate positions based on its ID
+            if ((int)leaf < len1 && pos1 == -1) {
+                pos1 = leaf;
+            } 
+            
+            else if ((int)leaf >= len1 && pos2 == -1) {
+                pos2 = leaf - len1;
+            }
         }
-    }
 
-    // if this node is a leaf, determine which string it belongs to
-    if (is_leaf_flag) {
-        if (node->id < len1) {
-            color.from_s1 = 1;
-        } 
-        
-        else {
-            color.from_s2 = 1;
+        // if both positions are found, update the result
+        if (pos1 != -1 && pos2 != -1) {
+            result->positions = (int *)malloc(2 * sizeof(int));
+            result->positions[0] = pos1;
+            result->positions[1] = pos2;
+            result->count = 2;
         }
-        return color;
     }
+}
 
-    // if this is an internal node and both strings are represented in the subtree
-    if (color.from_s1 && color.from_s2) {
-        // check if the current depth is greater than the recorded result length
-        if (node->depth > result->length) {
-            result->length = node->depth;
-            free(result->positions);
-            result->positions = NULL;
-            result->count = 0;
-
-            // find representative leaf under this node from both strings
-            int pos1 = -1, pos2 = -1;
-            for (int i = 0; i < DNA_ALPHABET_SIZE && (pos1 == -1 || pos2 == -1); i++) {
-                Node *child = node->children[i];
-                if (child) {
-                    // search to the leaf to find the representative
-                    Node *leaf = child;
-                    while (!is_leaf(leaf, len1 + len2)) {  // combined length of both strings
-                        for (int j = 0; j < DNA_ALPHABET_SIZE; j++) {
-                            if (leaf->children[j]) {
-                                leaf = leaf->children[j];
-                                break;
-                            }
-                        }
-                    }
-
-                    // reaching the leaf, calculate positions based on its ID
-                    if (leaf->id < len1 && pos1 == -1) {
-                        pos1 = leaf->id;
-                    } 
-                    
-                    else if (leaf->id >= len1 && pos2 == -1) {
-                        pos2 = leaf->id - len1;
-                    }
-                }
-            }
-
-            // if both positions are found, update the result
-            if (pos1 != -1 && pos2 != -1) {
-                result->positions = (int *)malloc(2 * sizeof(int));
-                result->positions[0] = pos1;
-                result->positions[1] = pos2;
-                result->count = 2;
-            }
-        }
+// Finds the longest common substring between two strings using GST
+void dfs_lcs(const SuffixTree *st, NodeId node, int len1, LongestRepeat *result) {
+    const NodeTable *tree = &st->nodes;
+    LcsWalk walk;
+
+    if (node == NO_NODE || is_leaf(tree, node)) return;
+
+    walk.len1 = len1;
+    walk.result = result;
+    walk.color = (uint8_t *)malloc(tree->internal_count * sizeof(uint8_t));
+    if (!walk.color) {
+        perror("Could not allocate memory for subtree colors");
+        exit(1);
     }
 
-    return color;
+    visit_tree(st, node, lcs_enter, lcs_leave, &walk);
+    free(walk.color);
 }
 
-LongestRepeat find_longest_common_substring(Node *root, const char *s1, const char *s2, const char *alphabet) {
+LongestRepeat find_longest_common_substring(const SuffixTree *st, const char *s1, const char *s2) {
     LongestRepeat result = {0, NULL, 0};
     int len1 = strlen(s1);
-    int len2 = strlen(s2); 
 
-    dfs_lcs(root, len1, len2, &result);
+    dfs_lcs(st, st->nodes.root, len1, &result);
 
     return result;
 }
@@ -416,16 +417,3 @@ void free_similarity_matrix(SimilarityCell **matrix, int size) {
     }
     free(matrix);
 }
-
-void free_suffix_tree(Node *node, const char *alphabet) {
-    if (!node) return;
-    
-    for (int i = 0; i < strlen(alphabet); i++) {
-        if (node->children[i]) {
-            free_suffix_tree(node->children[i], alphabet);
-        }
-    }
-    
-    free(node->children);
-    free(node);
-}
\ No newline at end of file
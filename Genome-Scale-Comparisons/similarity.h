@@ -7,7 +7,6 @@
 #include "types.h"
 #include "suffix_tree.h"
 
-#define DNA_ALPHABET_SIZE 4
 #define MATCH_SCORE 1
 #define MISMATCH_PENALTY -2
 #define GAP_OPEN -5
@@ -26,9 +25,9 @@ SimilarityCell** compute_similarity_matrix(Sequence *sequences, int count, const
 
 SimilarityCell compute_pair_similarity(const char *s1, const char *s2, const char *alphabet);
 
-SubtreeColor dfs_lcs(Node *node, int len1, int len2, LongestRepeat *result);
+void dfs_lcs(const SuffixTree *st, NodeId node, int len1, LongestRepeat *result);
 
-LongestRepeat find_longest_common_substring(Node *root, const char *s1, const char *s2, const char *alphabet);
+LongestRepeat find_longest_common_substring(const SuffixTree *st, const char *s1, const char *s2);
 
 AlignmentResult global_align(const char *s1, const char *s2);
 
@@ -36,6 +35,4 @@ void free_alignment_result(AlignmentResult result);
 
 void free_similarity_matrix(SimilarityCell **matrix, int size);
 
-void free_suffix_tree(Node *node, const char *alphabet);
-
 #endif
\ No newline at end of file
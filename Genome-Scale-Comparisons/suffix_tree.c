@@ -1,74 +1,302 @@
 #include "suffix_tree.h"
+#include "input_stream.h"
 
-// CreateNode
+// Node table
 /**
-* Initializes a generic node without unique data or information.
-* @alphabet_size: size of the alphabet (including $)
-* Returns a generic node with 
-*/
-Node* create_node(int alphabet_size) {
-    // allocate memory for new node
-    Node* new_node = (Node*)malloc(sizeof(Node));
-    if (!new_node) {
-        perror("Could not allocate memory for a new node");
+ * Allocates the arrays of a node table with room for every node of the suffix tree of a string of length n.
+ * A suffix tree has exactly n leaves and at most n - 1 internal nodes plus the root,
+ * so the arrays never need to grow. Untouched capacity is never written, so it costs no RSS.
+ * @str_len: length n of the sequence string (including $)
+ * @alphabet_size: size of the alphabet (including $)
+ */
+void init_node_table(NodeTable* tree, int str_len, int alphabet_size) {
+    size_t capacity = (str_len > 0) ? (size_t)str_len : 1;
+
+    tree->str_len = str_len;
+    tree->alphabet_size = alphabet_size;
+    tree->root = NO_NODE;
+    tree->internal_count = 0;
+    tree->internal_capacity = (int)capacity;
+
+    tree->leaf_parent = (NodeId*)malloc(capacity * sizeof(NodeId));
+    tree->leaf_next_sibling = (NodeId*)malloc(capacity * sizeof(NodeId));
+    tree->leaf_branch = (uint8_t*)malloc(capacity * sizeof(uint8_t));
+    tree->depth = (int*)malloc(capacity * sizeof(int));
+    tree->edge_start = (int*)malloc(capacity * sizeof(int));
+    tree->parent = (NodeId*)malloc(capacity * sizeof(NodeId));
+    tree->suff_link = (NodeId*)malloc(capacity * sizeof(NodeId));
+    tree->first_child = (NodeId*)malloc(capacity * sizeof(NodeId));
+    tree->next_sibling = (NodeId*)malloc(capacity * sizeof(NodeId));
+    tree->branch = (uint8_t*)malloc(capacity * sizeof(uint8_t));
+    tree->child_count = (uint32_t*)malloc(capacity * sizeof(uint32_t));
+    tree->dense_slot = (int*)malloc(capacity * sizeof(int));
+
+    // dense blocks are rare (only high-fanout nodes) -- pool grows on demand
+    tree->dense_children = NULL;
+    tree->dense_count = 0;
+    tree->dense_capacity = 0;
+
+    if (!tree->leaf_parent || !tree->leaf_next_sibling || !tree->leaf_branch || 
+        !tree->depth || !tree->edge_start || !tree->parent || !tree->suff_link || 
+        !tree->first_child || !tree->next_sibling || !tree->branch || 
+        !tree->child_count || !tree->dense_slot) {
+        perror("Could not allocate memory for node table arrays");
         exit(1);
     }
+}
+
+/**
+ * Frees the arrays of a node table, i.e., every node at once.
+ * @tree: node table to release
+ */
+void release_node_table(NodeTable* tree) {
+    free(tree->leaf_parent);
+    free(tree->leaf_next_sibling);
+    free(tree->leaf_branch);
+    free(tree->depth);
+    free(tree->edge_start);
+    free(tree->parent);
+    free(tree->suff_link);
+    free(tree->first_child);
+    free(tree->next_sibling);
+    free(tree->branch);
+    free(tree->child_count);
+    free(tree->dense_slot);
+    free(tree->dense_children);
+}
 
-    // allocate memory for array of node ptrs (children)
-    new_node->children = (Node**)calloc(alphabet_size, sizeof(Node*));
-    if (!new_node -> children) {
-        perror("Could not allocate memory for children ptrs of a node");
-        free(new_node);
+// CreateInternalNode
+/**
+ * Hands out the next internal node ID.
+ * IDs: 0...n-1 for leaves (suffix index), n...x for internal nodes in creation order
+ * @tree: node table to allocate from
+ * @returns: ID of the new internal node
+ */
+NodeId create_internal_node(NodeTable* tree) {
+    if (tree->internal_count >= tree->internal_capacity) {
+        fprintf(stderr, "Error: Node table is full (%d internal nodes)\n", tree->internal_capacity);
         exit(1);
     }
 
+    int i = tree->internal_count++;
+
     // init node members
-    new_node->id = 0;
-    new_node->parent = NULL;
-    new_node->suff_link = NULL;
-    new_node->depth = 0;
-    new_node->edge_label[0] = 0;
-    new_node->edge_label[1] = 0;
+    tree->depth[i] = 0;
+    tree->edge_start[i] = 0;
+    tree->parent[i] = NO_NODE;
+    tree->suff_link[i] = NO_NODE;
+    tree->first_child[i] = NO_NODE;
+    tree->next_sibling[i] = NO_NODE;
+    tree->branch[i] = 0;
+    tree->child_count[i] = 0;
+    tree->dense_slot[i] = -1;
+
+    return (NodeId)(tree->str_len + i);
+}
 
-    return new_node;
+// sets the sibling link of any node
+void set_next_sibling(NodeTable* tree, NodeId node, NodeId sibling) {
+    if (is_leaf(tree, node)) {
+        tree->leaf_next_sibling[node] = sibling;
+    } else {
+        tree->next_sibling[node - tree->str_len] = sibling;
+    }
 }
 
+// copies an internal node's sibling list into a newly handed out dense block
+void make_dense(NodeTable* tree, NodeId node) {
+    if (tree->dense_count >= tree->dense_capacity) {
+        int new_capacity = (tree->dense_capacity > 0) ? tree->dense_capacity * 2 : 64;
+        NodeId* temp = realloc(tree->dense_children, (size_t)new_capacity * tree->alphabet_size * sizeof(NodeId));
+        if (!temp) {
+            perror("Could not grow dense child pool");
+            exit(1);
+        }
+        tree->dense_children = temp;
+        tree->dense_capacity = new_capacity;
+    }
+
+    int slot = tree->dense_count++;
+    NodeId* block = tree->dense_children + (size_t)slot * tree->alphabet_size;
+    for (int c = 0; c < tree->alphabet_size; c++) {
+        block[c] = NO_NODE;
+    }
+    for (NodeId child = first_child(tree, node); child != NO_NODE; child = next_sibling(tree, child)) {
+        block[child_branch(tree, child)] = child;
+    }
+
+    tree->dense_slot[node - tree->str_len] = slot;
+}
 
-// GenerateNodeId
+// AddChild
 /**
- * Generates an ID for a node depending on if its a leaf or not
- * IDs: 0...n-1 for leaves (suffix index), n...x for internal nodes
- * 
+ * Links a child under an internal node, keeping the sibling list sorted by branch character.
+ * The list is kept even for dense nodes so children can always be walked in order.
  */
-int generate_id(bool is_leaf, int suff_index, int str_len) {
-    static int internal_node_counter = 0;
-    int id = suff_index;
+void add_child(NodeTable* tree, NodeId node, int branch, NodeId child) {
+    NodeId i = node - tree->str_len;
 
-    if (!is_leaf) {
-        id = str_len + internal_node_counter;
-        internal_node_counter++;
+    if (is_leaf(tree, child)) {
+        tree->leaf_branch[child] = (uint8_t)branch;
+    } else {
+        tree->branch[child - tree->str_len] = (uint8_t)branch;
+    }
+
+    // find the sibling the child goes after (NO_NODE if it becomes the first child). A dense block holds
+    // the child of every branch, so the walk starts from the nearest one below the new branch
+    NodeId prev = NO_NODE;
+    NodeId curr = tree->first_child[i];
+    if (tree->dense_slot[i] >= 0) {
+        const NodeId* block = tree->dense_children + (size_t)tree->dense_slot[i] * tree->alphabet_size;
+        for (int c = branch - 1; c >= 0 && prev == NO_NODE; c--) {
+            prev = block[c];
+        }
+        if (prev != NO_NODE) curr = next_sibling(tree, prev);
+    }
+    while (curr != NO_NODE && child_branch(tree, curr) < branch) {
+        prev = curr;
+        curr = next_sibling(tree, curr);
+    }
+
+    set_next_sibling(tree, child, curr);
+    if (prev == NO_NODE) {
+        tree->first_child[i] = child;
+    } else {
+        set_next_sibling(tree, prev, child);
+    }
+
+    tree->child_count[i]++;
+    if (tree->dense_slot[i] >= 0) {
+        tree->dense_children[(size_t)tree->dense_slot[i] * tree->alphabet_size + branch] = child;
+    } else if (tree->child_count[i] > DENSE_FANOUT) {
+        make_dense(tree, node);
     }
-    
-    return id;
 }
 
+// ReplaceChild
 /**
- * Given a character in an alphabet, gets the corresponding index in the children array of a node
- * @c: character in an alphabet
- * @alphabet: alphabet over which a sequence string is comrpised of
- * @returns: corresponding index in children array (in a node) of a character
+ * Puts new_child in the place of old_child among node's children (same branch character).
  */
-int get_char_child_index(const char c, const char* alphabet) {
-    int c_index = -1;
+void replace_child(NodeTable* tree, NodeId node, NodeId old_child, NodeId new_child) {
+    NodeId i = node - tree->str_len;
+    int branch = child_branch(tree, old_child);
 
-    for (int i = 0; i < strlen(alphabet); i++) {
-        if (c == alphabet[i]) {
-            c_index = i;
-            break;
+    if (is_leaf(tree, new_child)) {
+        tree->leaf_branch[new_child] = (uint8_t)branch;
+    } else {
+        tree->branch[new_child - tree->str_len] = (uint8_t)branch;
+    }
+    set_next_sibling(tree, new_child, next_sibling(tree, old_child));
+
+    if (tree->first_child[i] == old_child) {
+        tree->first_child[i] = new_child;
+    } else {
+        NodeId prev = tree->first_child[i];
+        while (next_sibling(tree, prev) != old_child) {
+            prev = next_sibling(tree, prev);
+        }
+        set_next_sibling(tree, prev, new_child);
+    }
+
+    if (tree->dense_slot[i] >= 0) {
+        tree->dense_children[(size_t)tree->dense_slot[i] * tree->alphabet_size + branch] = new_child;
+    }
+}
+
+// CreateSuffixTree
+/**
+ * Creates an empty suffix tree (just the root) that owns copies of the sequence and alphabet.
+ * Precomputes everything the insertion steps need so no step rescans the sequence or alphabet:
+ * the string and alphabet lengths and a 256-entry rank table mapping each character to its
+ * index in the alphabet (i.e., its branch in a node). Validates the sequence in the same pass.
+ * @sequence_string: full sequence string (ends with $)
+ * @alphabet: alphabet the sequence is comprised of (including $)
+ */
+SuffixTree* create_suffix_tree(const char* sequence_string, const char* alphabet) {
+    SuffixTree* st = (SuffixTree*)malloc(sizeof(SuffixTree));
+    if (!st) {
+        perror("Could not allocate memory for suffix tree");
+        exit(1);
+    }
+
+    st->sequence = strdup(sequence_string);
+    st->alphabet = strdup(alphabet);
+    if (!st->sequence || !st->alphabet) {
+        perror("Could not copy sequence/alphabet into suffix tree");
+        exit(1);
+    }
+    st->str_len = strlen(sequence_string);
+    st->alphabet_size = strlen(alphabet);
+
+    for (int c = 0; c < 256; c++) {
+        st->char_rank[c] = -1;
+    }
+    for (int i = 0; i < st->alphabet_size; i++) {
+        st->char_rank[(unsigned char)alphabet[i]] = (int16_t)i;
+    }
+
+    for (int i = 0; i < st->str_len; i++) {
+        if (st->char_rank[(unsigned char)sequence_string[i]] < 0) {
+            fprintf(stderr, "Error: Invalid character %c at position %d in sequence (not in alphabet)\n", 
+                    sequence_string[i], i);
+            exit(1);
         }
     }
 
-    return c_index;
+    // create root node
+    NodeTable* tree = &st->nodes;
+    init_node_table(tree, st->str_len, st->alphabet_size);
+    NodeId root = create_internal_node(tree);
+    tree->root = root;
+    tree->suff_link[0] = root;  // root's suffix link points to itself
+    tree->parent[0] = root;
+
+    return st;
+}
+
+// FreeSuffixTree
+/**
+ * Releases the tree and everything it owns.
+ * @st: tree to free (may be NULL)
+ */
+void free_suffix_tree(SuffixTree* st) {
+    if (!st) return;
+
+    release_node_table(&st->nodes);
+    free(st->sequence);
+    free(st->alphabet);
+    free(st);
+}
+
+// VisitTree
+void visit_tree(const SuffixTree* st, NodeId node, VisitEnter enter, VisitLeave leave, void* context) {
+    const NodeTable* tree = &st->nodes;
+    NodeId top = node;
+    int level = 0;
+
+    for (;;) {
+        bool descend = enter ? enter(st, node, level, context) : true;
+        NodeId child = descend ? first_child(tree, node) : NO_NODE;
+        if (child != NO_NODE) {
+            node = child;
+            level++;
+            continue;
+        }
+
+        // subtree done: leave it and every finished ancestor, then move on to the next sibling
+        for (;;) {
+            if (leave) leave(st, node, level, context);
+            if (node == top) return;
+
+            NodeId sibling = next_sibling(tree, node);
+            if (sibling != NO_NODE) {
+                node = sibling;
+                break;
+            }
+            node = node_parent(tree, node);
+            level--;
+        }
+    }
 }
 
 // FindPath 
@@ -77,119 +305,105 @@ int get_char_child_index(const char c, const char* alphabet) {
  * the longest possible prefix of the specified string arg,
  * and then inserts the next suffix.
  * i.e., inserts sufix S[i...] under some node u
+ * @st: tree being built (node table, sequence, lengths, rank table)
  * @root: root node of tree to find path from
- * @string: full string
  * @index: starting index of suffix string
  * @start_pos: index position to start comparing in sequence string
- * @alphabet: alphabet that string is comprised of
+ * @returns: parent of the newly inserted leaf (u for the next insertion)
  */
-Node* find_path(Node* root, const char* sequence_string, int suff_index, int start_pos, const char* alphabet) {
-    Node* v = root;
-    Node* last_internal = root;
+NodeId find_path(SuffixTree* st, NodeId root, int suff_index, int start_pos) {
+    NodeTable* tree = &st->nodes;
+    const char* sequence_string = st->sequence;
+    int str_len = st->str_len;
+    NodeId v = root;
     int curr_pos = start_pos;
-    int alphabet_len = strlen(alphabet);
-    int str_len = strlen(sequence_string);
-    bool leaf_inserted = false;
-
-    while (!leaf_inserted && curr_pos < str_len) {
-        int branch_i = get_char_child_index(sequence_string[curr_pos], alphabet);
-        Node* u = v->children[branch_i];
-
-        if (u == NULL) {
-            // no existing edge - create new leaf
-            Node* new_leaf = create_node(alphabet_len);
-            new_leaf->id = generate_id(true, suff_index, str_len);
-            new_leaf->edge_label[0] = curr_pos;
-            new_leaf->edge_label[1] = str_len - 1;
-            new_leaf->parent = v;
-            new_leaf->depth = v->depth + (new_leaf->edge_label[1] - new_leaf->edge_label[0] + 1);
-            v->children[branch_i] = new_leaf;
-
-            leaf_inserted = true;
+
+    while (curr_pos < str_len) {
+        int branch_i = get_char_child_index(st, sequence_string[curr_pos]);
+        NodeId u = get_child(tree, v, branch_i);
+
+        if (u == NO_NODE) {
+            // no existing edge - new leaf hangs off v
+            NodeId new_leaf = (NodeId)suff_index;
+            set_parent(tree, new_leaf, v);
+            add_child(tree, v, branch_i, new_leaf);
+
+            return v;
         } 
-        else {
-            // existing edge - compare characters
-            int edge_start = u->edge_label[0];
-            int edge_end = u->edge_label[1];
-            int edge_pos = edge_start;
-            
-            // Compare characters along the edge
-            while (edge_pos <= edge_end && curr_pos < str_len && 
-                   sequence_string[edge_pos] == sequence_string[curr_pos]) {
-                edge_pos++;
-                curr_pos++;
-            }
 
-            if (edge_pos > edge_end) {
-                // Entire edge matched - move to child node
-                v = u;
-            } else {
-                // mismatch -- split edge
-                Node* new_internal = create_node(alphabet_len);
-                new_internal->id = generate_id(false, suff_index, str_len);
-                
-                // set up the new internal node
-                new_internal->edge_label[0] = edge_start;
-                new_internal->edge_label[1] = edge_pos - 1;
-                new_internal->parent = v;
-                new_internal->depth = v->depth + (edge_pos - edge_start);
-                
-                // update the existing node
-                u->edge_label[0] = edge_pos;
-                u->parent = new_internal;
-                
-                // connect new internal node to existing node
-                int u_branch = get_char_child_index(sequence_string[edge_pos], alphabet);
-                new_internal->children[u_branch] = u;
-                
-                // update parent's child pointer to new internal
-                v->children[branch_i] = new_internal;
-                
-                // create new leaf for current suffix
-                Node* new_leaf = create_node(alphabet_len);
-                new_leaf->id = generate_id(true, suff_index, str_len);
-                new_leaf->edge_label[0] = curr_pos;
-                new_leaf->edge_label[1] = str_len - 1;
-                new_leaf->parent = new_internal;
-                new_leaf->depth = new_internal->depth + (str_len - curr_pos);
-                
-                // add leaf to new internal node
-                int leaf_branch = get_char_child_index(sequence_string[curr_pos], alphabet);
-                new_internal->children[leaf_branch] = new_leaf;
-                
-                last_internal = last_internal;
-                leaf_inserted = true;
-            }
+        // existing edge - compare characters
+        int edge_begin = edge_start(tree, u);
+        int edge_finish = edge_end(tree, u);
+        
+        // Compare characters along the edge, a word at a time
+        int max = edge_finish - edge_begin + 1;
+        if (str_len - curr_pos < max) max = str_len - curr_pos;
+        int matched = match_length(sequence_string + edge_begin, sequence_string + curr_pos, max);
+        int edge_pos = edge_begin + matched;
+        curr_pos += matched;
+
+        if (edge_pos > edge_finish) {
+            // Entire edge matched - move to child node
+            v = u;
+            continue;
+        }
+
+        // mismatch -- split edge
+        NodeId new_internal = create_internal_node(tree);
+        NodeId w = new_internal - tree->str_len;
+        
+        // set up the new internal node
+        tree->edge_start[w] = edge_begin;
+        tree->parent[w] = v;
+        tree->depth[w] = node_depth(tree, v) + (edge_pos - edge_begin);
+        
+        // update the existing node (a leaf's edge start follows from its new parent)
+        if (!is_leaf(tree, u)) {
+            tree->edge_start[u - tree->str_len] = edge_pos;
         }
+        set_parent(tree, u, new_internal);
+        
+        // new internal node takes u's place under v (before u's sibling link is reused)
+        replace_child(tree, v, u, new_internal);
+        
+        // connect new internal node to existing node
+        add_child(tree, new_internal, get_char_child_index(st, sequence_string[edge_pos]), u);
+        
+        // new leaf for current suffix
+        NodeId new_leaf = (NodeId)suff_index;
+        set_parent(tree, new_leaf, new_internal);
+        add_child(tree, new_internal, get_char_child_index(st, sequence_string[curr_pos]), new_leaf);
+        
+        return new_internal;
     }
 
-    return last_internal;
+    // the whole suffix was already spelled out (only possible without a unique $ terminator)
+    return v;
 }
 
-/**
- * Get beta for node hops
- */
-
 // NodeHops
 /**
  * Does node hopping child to child until
- * string Beta (or Beta') is exhausted, depending on the case
+ * string Beta (or Beta') is exhausted, depending on the case.
+ * Only the first character of each edge is looked at, since beta is known to be in the tree.
+ * @st: tree being built (node table, sequence, lengths, rank table)
  * @v_prime: node start node hopping from
- * @sequence_string: full sequence string
  * @suff_index: starting index of suffing string to insert
  * @beta_len: if u' is not root: beta = u.stringdepth. otherwise, beta = c + alpha between u and root.
  * @beta_start: starting index position in the string according to beta edge from u.
  * @returns: node v - node reached from node hopping
  */
-Node* node_hops(Node* v_prime, const char* sequence_string, int suff_index, const char* alphabet, int beta_len, int beta_start) {
-    if (v_prime == NULL) {
+NodeId node_hops(SuffixTree* st, NodeId v_prime, int suff_index, int beta_len, int beta_start) {
+    NodeTable* tree = &st->nodes;
+    const char* sequence_string = st->sequence;
+    int str_len = st->str_len;
+
+    if (v_prime == NO_NODE) {
         fprintf(stderr, "Error: NULL v_prime parameter\n");
         exit(1);
     }
 
-    Node* v = v_prime;
-    int str_len = strlen(sequence_string);
-    int alphabet_len = strlen(alphabet);
+    NodeId v = v_prime;
     int beta_counter = 0;
     int str_pos = beta_start;
 
@@ -202,61 +416,39 @@ Node* node_hops(Node* v_prime, const char* sequence_string, int suff_index, cons
     while (beta_counter < beta_len && str_pos < str_len) {
         // get next character
         char current_char = sequence_string[str_pos];
-        int next_branch_index = get_char_child_index(current_char, alphabet);
-        
-        // validate branch index
-        if (next_branch_index < 0 || next_branch_index >= alphabet_len) {
-            fprintf(stderr, "Error: Invalid character %c in sequence (not in alphabet)\n", current_char);
-            exit(1);
-        }
+        int next_branch_index = get_char_child_index(st, current_char);
 
         // get child node
-        Node* next = v->children[next_branch_index];
-        if (next == NULL) {
+        NodeId next = get_child(tree, v, next_branch_index);
+        if (next == NO_NODE) {
             fprintf(stderr, "Error in node_hops: No child for character '%c' at position %d\n", 
                     current_char, str_pos);
-            fprintf(stderr, "Current node ID: %d, depth: %d\n", v->id, v->depth);
+            fprintf(stderr, "Current node ID: %u, depth: %d\n", v, node_depth(tree, v));
             fprintf(stderr, "Beta: len=%d, start=%d, counter=%d\n", beta_len, beta_start, beta_counter);
             exit(1);
         }
 
-        // validate edge labels
-        if (next->edge_label[0] < 0 || next->edge_label[1] >= str_len || 
-            next->edge_label[0] > next->edge_label[1]) {
-            fprintf(stderr, "Error: Invalid edge labels [%d,%d] for node %d\n",
-                    next->edge_label[0], next->edge_label[1], next->id);
-            exit(1);
-        }
-
-        int edge_len = next->edge_label[1] - next->edge_label[0] + 1;
+        int next_start = edge_start(tree, next);
+        int edge_len = edge_end(tree, next) - next_start + 1;
         int remaining_beta = beta_len - beta_counter;
 
         if (edge_len > remaining_beta) {
-            // split edge - with additional validation
-            if (next->edge_label[0] + remaining_beta > next->edge_label[1]) {
-                fprintf(stderr, "Error: Invalid edge split position\n");
-                exit(1);
+            // split edge
+            NodeId new_internal = create_internal_node(tree);
+            NodeId w = new_internal - tree->str_len;
+            tree->edge_start[w] = next_start;
+            tree->parent[w] = v;
+            tree->depth[w] = node_depth(tree, v) + remaining_beta;
+
+            // update existing node (a leaf's edge start follows from its new parent)
+            if (!is_leaf(tree, next)) {
+                tree->edge_start[next - tree->str_len] += remaining_beta;
             }
-
-            Node* new_internal = create_node(alphabet_len);
-            new_internal->id = generate_id(false, suff_index, str_len);
-            new_internal->edge_label[0] = next->edge_label[0];
-            new_internal->edge_label[1] = next->edge_label[0] + remaining_beta - 1;
-            new_internal->parent = v;
-            new_internal->depth = v->depth + remaining_beta;
-
-            // update existing node
-            next->edge_label[0] += remaining_beta;
-            next->parent = new_internal;
+            set_parent(tree, next, new_internal);
 
             // connect nodes
-            int split_char_index = get_char_child_index(sequence_string[next->edge_label[0]], alphabet);
-            if (split_char_index < 0 || split_char_index >= alphabet_len) {
-                fprintf(stderr, "Error: Invalid split character\n");
-                exit(1);
-            }
-            new_internal->children[split_char_index] = next;
-            v->children[next_branch_index] = new_internal;
+            replace_child(tree, v, next, new_internal);
+            add_child(tree, new_internal, get_char_child_index(st, sequence_string[next_start + remaining_beta]), next);
 
             v = new_internal;
             break;
@@ -275,17 +467,15 @@ Node* node_hops(Node* v_prime, const char* sequence_string, int suff_index, cons
  * Case: SL(u) is known.
  * Inserts suffix string into ST.
  * @u: parent of leaf i-1 during suffix index iteration of building ST
- * @string: full sequence string 
  * @suff_index: starting index of suffing string to insert
- * @alphabet: alphabet that string is comprised of
  */
-Node* suff_link_known(Node* u, const char* sequence_string, int suff_index, const char* alphabet) {
-    Node* v = u->suff_link;
-    int str_len = strlen(sequence_string);
-    int k = v->depth;
+NodeId suff_link_known(SuffixTree* st, NodeId u, int suff_index) {
+    NodeTable* tree = &st->nodes;
+    NodeId v = tree->suff_link[u - tree->str_len];
+    int k = node_depth(tree, v);
 
-    if (suff_index + k <= str_len) {
-        return find_path(v, sequence_string, suff_index, suff_index + k, alphabet);
+    if (suff_index + k <= st->str_len) {
+        return find_path(st, v, suff_index, suff_index + k);
     }
 
     return v;
@@ -295,191 +485,157 @@ Node* suff_link_known(Node* u, const char* sequence_string, int suff_index, cons
  * Case: SL(u) is unknown and u' (grandparent of leaf i-1) is not the root.
  * Inserts suffix string into ST.
  * @u: parent of leaf i-1 during suffix index iteration of building ST
- * @string: full sequence string 
  * @suff_index: starting index of suffing string to insert
- * @alphabet: alphabet that string is comprised of
  */
-Node* suff_link_unknown_internal(Node* u, const char* sequence_string, int suff_index, const char* alphabet) {
-    Node* u_prime = u->parent;
-    Node* v_prime = u_prime->suff_link;
-    int u_start_edge = u->edge_label[0];
-    int beta_len = u->edge_label[1] - u->edge_label[0] + 1;
+NodeId suff_link_unknown_internal(SuffixTree* st, NodeId u, int suff_index) {
+    NodeTable* tree = &st->nodes;
+    NodeId u_prime = node_parent(tree, u);
+    NodeId v_prime = tree->suff_link[u_prime - tree->str_len];
+    int u_start_edge = edge_start(tree, u);
+    int beta_len = edge_end(tree, u) - u_start_edge + 1;
 
     // find v by hopping along beta path
-    if (v_prime == NULL) {
+    if (v_prime == NO_NODE) {
         printf("ERROR: V_prime is null @ suff_i %d\n", suff_index);
     }
-    Node* v = node_hops(v_prime, sequence_string, suff_index, alphabet, beta_len, u_start_edge);
+    NodeId v = node_hops(st, v_prime, suff_index, beta_len, u_start_edge);
     
     // set suffix link for u
-    u->suff_link = v;
+    tree->suff_link[u - tree->str_len] = v;
     
     // insert remaining suffix
-    int alpha = v->depth;
-    return find_path(v, sequence_string, suff_index, suff_index + alpha, alphabet);
+    int alpha = node_depth(tree, v);
+    return find_path(st, v, suff_index, suff_index + alpha);
 }
 
 /**
  * Case: SL(u) is unknown and u' (grandparent of leaf i-1) is the root.
  * Inserts suffix string into ST.
  * @u: parent of leaf i-1 during suffix index iteration of building ST
- * @sequence_string: full sequence string 
  * @suff_index: starting index of suffix string to insert
- * @alphabet: alphabet that string is comprised of
- * @returns: last internal node created during insertion
+ * @returns: parent of the newly inserted leaf
  */
-Node* suff_link_unknown_root(Node* u, const char* sequence_string, int suff_index, const char* alphabet) {
-    int str_len = strlen(sequence_string);
-    
+NodeId suff_link_unknown_root(SuffixTree* st, NodeId u, int suff_index) {
+    NodeTable* tree = &st->nodes;
+
     // Get u' (grandparent, which is root)
-    Node* u_prime = u->parent;
+    NodeId u_prime = node_parent(tree, u);
     
     // Calculate beta (u's edge label minus first character)
-    int beta_len = u->depth - 1;  // u.depth is length from root to u
-    int beta_start = u->edge_label[0] + 1;  // skip first character
+    int beta_len = node_depth(tree, u) - 1;  // u.depth is length from root to u
+    int beta_start = edge_start(tree, u) + 1;  // skip first character
     
     // Node hop from root following beta
-    if (u_prime == NULL) {
+    if (u_prime == NO_NODE) {
         printf("ERROR: u_prime is null @ suff_i %d\n", suff_index);
     }
-    Node* v = node_hops(u_prime, sequence_string, suff_index, alphabet, beta_len, beta_start);
+    NodeId v = node_hops(st, u_prime, suff_index, beta_len, beta_start);
     
     // Set u's suffix link to v
-    u->suff_link = v;
+    tree->suff_link[u - tree->str_len] = v;
     
     // Calculate remaining part to insert (alpha)
-    int alpha = v->depth;
+    int alpha = node_depth(tree, v);
     
     // Insert remaining suffix starting at suff_index + alpha
-    Node* last_internal = find_path(v, sequence_string, suff_index, suff_index + alpha, alphabet);
-    
-    return last_internal;
+    return find_path(st, v, suff_index, suff_index + alpha);
 }
 
 // ST Construction
 /**
  * @sequence_string: input string to build ST of
  * @alphabet: alphabet related to input string to build ST with
- * @returns - root node of tree
+ * @returns - suffix tree owning its nodes, sequence and alphabet; free_suffix_tree releases it
  */
-Node* build_suffix_tree(const char* sequence_string, const char* alphabet, bool is_naive) {
-    int seq_len = strlen(sequence_string);
-    int alphabet_size = strlen(alphabet);
-    
-    // create root node
-    Node* root = create_node(alphabet_size);
-    root->suff_link = root;  // root's suffix link points to itself
-    root->parent = root;
-    root->id = generate_id(false, 0, seq_len);
+SuffixTree* build_suffix_tree(const char* sequence_string, const char* alphabet, bool is_naive) {
+    SuffixTree* st = create_suffix_tree(sequence_string, alphabet);
+    NodeTable* tree = &st->nodes;
+    NodeId root = tree->root;
+    int seq_len = st->str_len;
 
     if (is_naive) {
         // naive construction - insert all suffixes independently
         for (int suff_ind = 0; suff_ind < seq_len; suff_ind++) {
-            find_path(root, sequence_string, suff_ind, suff_ind, alphabet);
+            find_path(st, root, suff_ind, suff_ind);
         }
     } 
     else {
-        // O(n) algorithm:
+        // O(n) algorithm (McCreight):
             // let u <- parent of leaf i-1
-        Node* last_internal = NULL;  // tracks last node created (leaf)
+        NodeId u = root;
         
         // insert suffixes
         for (int suff_ind = 0; suff_ind < seq_len; suff_ind++) {
-            Node* u = (last_internal != NULL) ? last_internal : root;
-            
-            if (u->suff_link != NULL) {
-                // case 1: SL(u) is known
-                last_internal = suff_link_known(u, sequence_string, suff_ind, alphabet);
+            if (tree->suff_link[u - tree->str_len] != NO_NODE) {
+                // case 1: SL(u) is known (always true for the root)
+                u = suff_link_known(st, u, suff_ind);
             } 
-            else if (u != root) {
-                // case 2: SL(u) is unknown and u is not root
-
-                last_internal = suff_link_unknown_internal(u, sequence_string, suff_ind, alphabet);
-                
-                // set suffix link for the previous internal node if needed
-                // if (last_internal != NULL && last_internal->suff_link == NULL) {
-                //     printf("we are doing this?\n");
-                //     last_internal->suff_link = u->suff_link;
-                // }
+            else if (node_parent(tree, u) != root) {
+                // case 2: SL(u) is unknown and u' is not root
+                u = suff_link_unknown_internal(st, u, suff_ind);
             } 
             else {
-                // case 3: SL(u) is unknown and u is root
-                last_internal = suff_link_unknown_root(u, sequence_string, suff_ind, alphabet);
+                // case 3: SL(u) is unknown and u' is root
+                u = suff_link_unknown_root(st, u, suff_ind);
             }
         }
     }
 
-    return root;
+    return st;
 }
 
 /***************
  * PRINTING / TESTING CONSTRUCTION OF TREE FUNCTIONS
  ****************/
 
-// Helper function to check if a node is a leaf
-// Assumes leaf IDs are 0...n-1
- bool is_leaf(Node* node, int str_len) {
-    return node->id < str_len; 
-}
-
-// Helper function to check if a node is the root
-/**
- * Assumes the root node initialized its suff_link to itself already
- * @node: node to check
- */
+// helper function for printing the tree: one line per node, indented by depth (context: base depth)
+bool print_node(const SuffixTree* st, NodeId node, int level, void* context) {
+    const NodeTable* tree = &st->nodes;
+    const char* sequence_string = st->sequence;
+    int depth = *(const int*)context + level;
 
-bool is_root(Node* node) {
-    return node->suff_link == node;
-}
-
-void print_suffix_tree(Node* node, const char* sequence_string, const char* alphabet, int str_len, int depth) {
     // indentation
     for (int i = 0; i < depth; i++) {
         printf("  ");
     }
 
     // print node information
-    if (is_root(node)) {
-        printf("[Root id=%d]", node->id);
+    if (is_root(tree, node)) {
+        printf("[Root id=%u]", node);
     } 
     else {
-        if (is_leaf(node, str_len)) {
-            printf("[Leaf id=%d, suffix=%d, edge='", node->id, node->id);
+        if (is_leaf(tree, node)) {
+            printf("[Leaf id=%u, suffix=%u, edge='", node, node);
         } 
         else {
-            printf("[Internal id=%d, edge='", node->id);
+            printf("[Internal id=%u, edge='", node);
         }
 
         // Print edge label
-        if (node->edge_label[0] <= node->edge_label[1]) {
-            for (int i = node->edge_label[0]; i <= node->edge_label[1]; i++) {
-                printf("%c", sequence_string[i]);
-            }
+        for (int i = edge_start(tree, node); i <= edge_end(tree, node); i++) {
+            printf("%c", sequence_string[i]);
         }
         printf("']");
     }
 
     // print suffix link 
-    if (node->suff_link != NULL) {
-        printf(" --> [id=%d]", node->suff_link->id);
+    if (!is_leaf(tree, node) && tree->suff_link[node - tree->str_len] != NO_NODE) {
+        printf(" --> [id=%u]", tree->suff_link[node - tree->str_len]);
     }
     printf("\n");
 
-    // recursively print children (only if they exist)
-    for (int i = 0; i < strlen(alphabet); i++) {
-        int branch_index = get_char_child_index(alphabet[i], alphabet);
-        if (node->children[branch_index] != NULL) {
-            print_suffix_tree(node->children[branch_index], sequence_string, alphabet, str_len, depth + 1);
-        }
-    }
+    return true;
+}
+
+void print_suffix_tree(const SuffixTree* st, NodeId node, int depth) {
+    visit_tree(st, node, print_node, NULL, &depth);
 }
 
-void print_tree(Node* root, const char* sequence_string, const char* alphabet) {
-    int str_len = strlen(sequence_string);
-    printf("\nSuffix Tree for: '%s' (length=%d)\n", sequence_string, str_len);
-    printf("Alphabet: '%s'\n", alphabet);
+void print_tree(const SuffixTree* st) {
+    printf("\nSuffix Tree for: '%s' (length=%d)\n", st->sequence, st->str_len);
+    printf("Alphabet: '%s'\n", st->alphabet);
     printf("Tree structure (L=Leaf, I=Internal):\n");
-    print_suffix_tree(root, sequence_string, alphabet, str_len, 0);
+    print_suffix_tree(st, st->nodes.root, 0);
     printf("\n");
 }
 
@@ -491,91 +647,64 @@ void print_tree(Node* root, const char* sequence_string, const char* alphabet) {
  * - Average string-depth of internal nodes
  * - String-depth of the deepest internal node
  */
-void print_tree_stats(Node* node, const char* sequence_string, const char* alphabet, int str_len, int depth) {
-    // Initialize statistics variables
-    int internal_nodes = 0;
-    int leaves = 0;
-    int total_nodes = 0;
-    int total_internal_depth = 0;
-    int max_depth = 0;
-    
-    // Stack for iterative DFS traversal
-    Node** stack = (Node**)malloc(str_len * 2 * sizeof(Node*)); // Worst case: 2n nodes
-    int stack_top = -1;
-    stack[++stack_top] = node;
-    
-    while (stack_top >= 0) {
-        Node* current = stack[stack_top--];
-        total_nodes++;
-        
-        // Check if node is leaf or internal
-        if (is_leaf(current, str_len)) {
-            leaves++;
-        } else {
-            // Only count as internal if it's not the root and has children
-            int child_count = 0;
-            for (int i = 0; i < strlen(alphabet); i++) {
-                if (current->children[i] != NULL) {
-                    child_count++;
-                }
-            }
-            
-            if (child_count > 0 || is_root(current)) {
-                if (!is_root(current)) {
-                    internal_nodes++;
-                    total_internal_depth += current->depth;
-                    if (current->depth > max_depth) {
-                        max_depth = current->depth;
-                    }
-                }
-            }
-        }
-        
-        // Push children in reverse order for DFS
-        for (int i = strlen(alphabet) - 1; i >= 0; i--) {
-            if (current->children[i] != NULL) {
-                stack[++stack_top] = current->children[i];
-            }
+// helper function for the statistics: counts every node (context: TreeStats)
+bool count_node(const SuffixTree* st, NodeId node, int level, void* context) {
+    const NodeTable* tree = &st->nodes;
+    TreeStats* stats = (TreeStats*)context;
+
+    stats->total_nodes++;
+    if (is_leaf(tree, node)) {
+        stats->leaves++;
+    } else if (!is_root(tree, node)) {
+        int depth = node_depth(tree, node);
+        stats->internal_nodes++;
+        stats->total_internal_depth += depth;
+        if (depth > stats->max_depth) {
+            stats->max_depth = depth;
         }
     }
+    return true;
+}
+
+void print_tree_stats(const SuffixTree* st) {
+    TreeStats stats = {0, 0, 0, 0, 0};
+    visit_tree(st, st->nodes.root, count_node, NULL, &stats);
     
     // Calculate average depth (avoid division by zero)
-    double avg_depth = (internal_nodes > 0) ? (double)total_internal_depth / internal_nodes : 0.0;
+    double avg_depth = (stats.internal_nodes > 0) ? (double)stats.total_internal_depth / stats.internal_nodes : 0.0;
     
     // Print the statistics
     printf("\nSuffix Tree Statistics:\n");
     printf("-----------------------\n");
-    printf("Internal nodes: %d\n", internal_nodes);
-    printf("Leaves: %d\n", leaves);
-    printf("Total nodes: %d\n", total_nodes);
+    printf("Internal nodes: %d\n", stats.internal_nodes);
+    printf("Leaves: %d\n", stats.leaves);
+    printf("Total nodes: %d\n", stats.total_nodes);
     printf("Average string-depth of internal nodes: %.2f\n", avg_depth);
-    printf("String-depth of deepest internal node: %d\n", max_depth);
-        
-    free(stack);
+    printf("String-depth of deepest internal node: %d\n", stats.max_depth);
 }
 
 // Display children left to right
 /**
- * Given a pointer to a specific node u in the tree, display u's children from left to right
- * @node_u: node whose children to display
+ * Given a specific node u in the tree, display u's children from left to right
+ * @u: node whose children to display
  */
-void display_children(Node* u, const char* alphabet) {
-    if (u == NULL) {
+void display_children(const SuffixTree* st, NodeId u) {
+    const NodeTable* tree = &st->nodes;
+    const char* alphabet = st->alphabet;
+
+    if (u == NO_NODE) {
         printf("Node is NULL\n");
         return;
     }
 
-    printf("Children of node %d: [", u->id);
+    printf("Children of node %u: [", u);
     
-    // Iterate through alphabet to maintain lexicographical order
-    for (int i = 0; i < strlen(alphabet); i++) {
-        int branch_index = get_char_child_index(alphabet[i], alphabet);
-        if (u->children[branch_index] != NULL) {
-            Node* child = u->children[branch_index];
-            printf(" %d(%c..%c)", child->id, 
-                   alphabet[i], 
-                   alphabet[i]); // All children start with their branch character
-        }
+    // sibling list is sorted by branch character, i.e., lexicographical order
+    for (NodeId child = first_child(tree, u); child != NO_NODE; child = next_sibling(tree, child)) {
+        int branch = child_branch(tree, child);
+        printf(" %u(%c..%c)", child, 
+               alphabet[branch], 
+               alphabet[branch]); // All children start with their branch character
     }
     
     printf(" ]\n");
@@ -587,28 +716,27 @@ void display_children(Node* u, const char* alphabet) {
 * As a result of this enumeration, displays STRING DEPTH info from each node.
 * @node_r: starting/root node to enumerate the tree
 */
-void dfs_enumerate(Node* node_r, const char* sequence_string, const char* alphabet) {
-    if (node_r == NULL) return;
- 
-    // print current node info
-    if (node_r->parent == node_r) {
-        printf("[Root id=%d, depth=%d]\n", node_r->id, node_r->depth);
+// helper function for enumerating: prints a node's string depth and incoming edge
+bool enumerate_node(const SuffixTree* st, NodeId node, int level, void* context) {
+    const NodeTable* tree = &st->nodes;
+    const char* sequence_string = st->sequence;
+
+    if (is_root(tree, node)) {
+        printf("[Root id=%u, depth=%d]\n", node, node_depth(tree, node));
     } else {
-        printf("[Node id=%d, depth=%d, edge='", node_r->id, node_r->depth);
-        for (int i = node_r->edge_label[0]; i <= node_r->edge_label[1]; i++) {
+        printf("[Node id=%u, depth=%d, edge='", node, node_depth(tree, node));
+        for (int i = edge_start(tree, node); i <= edge_end(tree, node); i++) {
             printf("%c", sequence_string[i]);
         }
         printf("']\n");
     }
- 
-    // recursively visit children in lexicographical order
-    for (int i = 0; i < strlen(alphabet); i++) {
-        int branch_index = get_char_child_index(alphabet[i], alphabet);
-        if (node_r->children[branch_index] != NULL) {
-            dfs_enumerate(node_r->children[branch_index], sequence_string, alphabet);
-        }
-    }
- }
+    return true;
+}
+
+void dfs_enumerate(const SuffixTree* st, NodeId node_r) {
+    if (node_r == NO_NODE) return;
+    visit_tree(st, node_r, enumerate_node, NULL, NULL);
+}
  
 /**
  * Uses DFS procedure to print the BWT index for input string s.
@@ -616,134 +744,134 @@ void dfs_enumerate(Node* node_r, const char* sequence_string, const char* alphab
  * where leaf(i) is the suffix ID of the ith leaf in lexicographical order.
  * If i = 0, then B[0] = $ (i.e., cycling around from the end of the string)
  */
-void compute_bwt_index(Node* root, const char* sequence_file, const char* sequence_string, const char* alphabet) {
-    int n = strlen(sequence_string);
-    char* BWT = (char*)malloc((n + 1) * sizeof(char)); // +1 for null terminator
-    int bwt_index = 0;
-
-    // stack for iterative DFS
-    Node** stack = (Node**)malloc(n * sizeof(Node*));
-    int stack_top = -1;
-    stack[++stack_top] = root; // init stack with
-
-    while (stack_top >= 0) {
-        Node* curr = stack[stack_top--];
-
-        // if leaf node, process it
-        if (is_leaf(curr, n)) {
-            int suffix_id = curr->id;
-            int bwt_pos = (suffix_id == 0) ? n - 1 : suffix_id - 1;
-            BWT[bwt_index++] = sequence_string[bwt_pos];
-        }
+// helper function for the BWT: leaves arrive in lexicographic order (context: BwtWalk)
+bool bwt_leaf(const SuffixTree* st, NodeId node, int level, void* context) {
+    if (is_leaf(&st->nodes, node)) {
+        BwtWalk* walk = (BwtWalk*)context;
+        int suffix_id = (int)node;
+        int bwt_pos = (suffix_id == 0) ? st->str_len - 1 : suffix_id - 1;
+        walk->bwt[walk->count++] = st->sequence[bwt_pos];
+    }
+    return true;
+}
 
-        // push children in reverse lexicographical order (to process left-to-right when POPPING OFF!)
-        for (int i = strlen(alphabet) - 1; i >= 0; i--) {
-            int branch_index = get_char_child_index(alphabet[i], alphabet);
-            if (curr->children[branch_index] != NULL) {
-                stack[++stack_top] = curr->children[branch_index];
-            }
-        }
+void compute_bwt_index(const SuffixTree* st, const char* sequence_file) {
+    int n = st->nodes.str_len;
+    BwtWalk walk;
+    walk.bwt = (char*)malloc((n + 1) * sizeof(char)); // +1 for null terminator
+    walk.count = 0;
+    if (!walk.bwt) {
+        perror("Could not allocate memory for BWT");
+        exit(1);
     }
 
+    visit_tree(st, st->nodes.root, bwt_leaf, NULL, &walk);
+
     // generate output filename by appending "_BWT.txt" to the sequence file name
     char output_filename[256];
     snprintf(output_filename, sizeof(output_filename), "%.*s_bwt.txt",
-             (int)(strrchr(sequence_file, '.') ? strrchr(sequence_file, '.') - sequence_file : strlen(sequence_file)),
+             (int)input_file_stem_length(sequence_file),
              sequence_file);
 
     // Write to file
     FILE* file = fopen(output_filename, "w");
     if (file == NULL) {
         perror("Error opening file");
-        free(BWT);
-        free(stack);
+        free(walk.bwt);
         return;
     }
 
     for (int i = 0; i < n; i++) {
-        fprintf(file, "%c\n", BWT[i]);
+        fprintf(file, "%c\n", walk.bwt[i]);
     }
 
     fclose(file);
     printf("BWT output written to: %s\n", output_filename);
-    free(BWT);
-    free(stack);
+    free(walk.bwt);
 }
 
-void report_space_usage(Node* root, const char* seq_str, const char* alphabet) {
-    size_t input_bytes = strlen(seq_str);
-    size_t alphabet_size = strlen(alphabet);
-    
-    size_t node_count = input_bytes * 2;
-    
-    size_t node_size = sizeof(Node) + (alphabet_size * sizeof(Node*));
+/**
+ * Reports the memory held by the node table: parent, sibling link and branch character per leaf,
+ * the core fields and sibling list links per internal node in use, and the dense child blocks.
+ */
+void report_space_usage(const SuffixTree* st) {
+    const NodeTable* tree = &st->nodes;
+    size_t input_bytes = tree->str_len;
+    size_t leaf_node_size = 2 * sizeof(NodeId) + sizeof(uint8_t);
+    size_t leaf_bytes = input_bytes * leaf_node_size;
+    size_t internal_node_size = 3 * sizeof(int) + 4 * sizeof(NodeId) + sizeof(uint8_t) + sizeof(uint32_t);
+    size_t internal_bytes = (size_t)tree->internal_count * internal_node_size;
+    size_t dense_bytes = (size_t)tree->dense_count * tree->alphabet_size * sizeof(NodeId);
+    size_t node_count = input_bytes + tree->internal_count;
     
-    // total estimated memory
-    size_t estimated_memory = node_count * node_size;
-    double space_constant = (double)estimated_memory / input_bytes;
+    // total memory in use
+    size_t tree_memory = leaf_bytes + internal_bytes + dense_bytes;
+    double space_constant = (double)tree_memory / input_bytes;
     
-    printf("Space Usage Estimate:\n");
+    printf("Space Usage:\n");
     printf("Input size: %zu bytes\n", input_bytes);
-    printf("Estimated tree memory: %zu bytes (~%.2f MB)\n", 
-           estimated_memory, estimated_memory/(1024.0*1024.0));
+    printf("Leaves: %zu bytes (%zu bytes each)\n", leaf_bytes, leaf_node_size);
+    printf("Internal nodes: %zu bytes (%zu bytes each)\n", internal_bytes, internal_node_size);
+    printf("Dense child tables: %zu bytes (%d nodes with more than %d children)\n", 
+           dense_bytes, tree->dense_count, DENSE_FANOUT);
+    printf("Tree memory: %zu bytes (~%.2f MB)\n", 
+           tree_memory, tree_memory/(1024.0*1024.0));
+    printf("Memory per node: ~%.1f bytes\n", (double)tree_memory / node_count);
     printf("Space constant: ~%.1f bytes per input byte\n", space_constant);
 }
 
-// helper function
-void find_longest_repeat(Node* node, const char* sequence, const char* alphabet, LongestRepeat* result, int current_depth) {
-    if (!node) return;
-
-    // update current depth with edge length
-    int edge_length = node->edge_label[1] - node->edge_label[0] + 1;
-    current_depth += edge_length;
-
-    // check if this is an internal node (>= 2 children)
-    int child_count = 0;
-    for (int i = 0; i < strlen(alphabet); i++) {
-        if (node->children[i]) child_count++;
-    }
+// helper function: deepest internal node (the first one in lexicographic order on ties) (context: deepest so far)
+bool deeper_node(const SuffixTree* st, NodeId node, int level, void* context) {
+    const NodeTable* tree = &st->nodes;
+    NodeId* deepest = (NodeId*)context;
 
-    if (child_count >= 2) {
-        if (current_depth > result->length) {
-            // found new longest repeat
-            result->length = current_depth;
-            free(result->positions);
-            result->positions = NULL;
-            result->count = 0;
-            
-            // collect all leaf positions under this node
-            collect_leaf_positions(node, sequence, alphabet, result);
-        }
-    }
+    if (is_leaf(tree, node)) return false;
 
-    // recurse check children
-    for (int i = 0; i < strlen(alphabet); i++) {
-        find_longest_repeat(node->children[i], sequence, alphabet, result, current_depth);
+    // every non-root internal node has >= 2 children, so its path label is a repeat
+    if (!is_root(tree, node) && node_depth(tree, node) > node_depth(tree, *deepest)) {
+        *deepest = node;
     }
+    return true;
 }
 
-// helper function for finding repeats
-void collect_leaf_positions(Node* node, const char* sequence, const char* alphabet, LongestRepeat* result) {
-    if (!node) return;
+void find_longest_repeat(const SuffixTree* st, NodeId node, NodeId* deepest) {
+    if (node == NO_NODE) return;
+    visit_tree(st, node, deeper_node, NULL, deepest);
+}
 
-    if (is_leaf(node, strlen(sequence))) {
-        // found a leaf - add its position to results
-        result->positions = realloc(result->positions, (result->count + 1) * sizeof(int));
-        result->positions[result->count] = node->id;
-        result->count++;
-    } 
-    else {
-        // internal node - check children
-        for (int i = 0; i < strlen(alphabet); i++) {
-            collect_leaf_positions(node->children[i], sequence, alphabet, result);
+// helper function for finding repeats: appends a leaf to the positions (context: LongestRepeat)
+bool repeat_leaf(const SuffixTree* st, NodeId node, int level, void* context) {
+    if (is_leaf(&st->nodes, node)) {
+        LongestRepeat* result = (LongestRepeat*)context;
+        int* temp = realloc(result->positions, (result->count + 1) * sizeof(int));
+        if (!temp) {
+            perror("Could not allocate memory for repeat positions");
+            exit(1);
         }
+        result->positions = temp;
+        result->positions[result->count++] = (int)node;
     }
+    return true;
+}
+
+// helper function for finding repeats: leaves below a node in lexicographic order
+void collect_leaf_positions(const SuffixTree* st, NodeId node, LongestRepeat* result) {
+    if (node == NO_NODE) return;
+    visit_tree(st, node, repeat_leaf, NULL, result);
 }
 
 // actual function to call to find repeats
-LongestRepeat find_repeats(Node* root, const char* sequence, const char* alphabet) {
+LongestRepeat find_repeats(const SuffixTree* st) {
+    const NodeTable* tree = &st->nodes;
     LongestRepeat result = {0, NULL, 0};
-    find_longest_repeat(root, sequence, alphabet,  &result, 0);
+
+    NodeId deepest = tree->root;
+    find_longest_repeat(st, tree->root, &deepest);
+    if (is_root(tree, deepest)) return result;
+
+    // positions are collected once, for the deepest node only
+    result.length = node_depth(tree, deepest);
+    collect_leaf_positions(st, deepest, &result);
     return result;
 }
 
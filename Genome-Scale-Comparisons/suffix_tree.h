@@ -7,29 +7,197 @@
 #include <stdio.h>
 #include <stddef.h>
 
-// CreateNode
+// Node table
 /**
-* Initializes a node.
-* @alphabet_size: size of the alphabet (including $)
-*/
-Node* create_node(int alphabet_size);
+ * Allocates the arrays of a node table with room for every node of the suffix tree of a string of length n:
+ * n leaves and at most n internal nodes (including the root).
+ * @tree: node table to initialize
+ * @str_len: length n of the sequence string (including $)
+ * @alphabet_size: size of the alphabet (including $)
+ */
+void init_node_table(NodeTable* tree, int str_len, int alphabet_size);
+
+/**
+ * Frees every node at once (a fixed number of array frees, independent of the node count).
+ * @tree: node table to release
+ */
+void release_node_table(NodeTable* tree);
 
-// GenerateNodeId
+// CreateInternalNode
 /**
- * Generates an ID for a node depending on if its a leaf or not.
- * @is_leaf: true if node whose ID being generated is a leaf, otherwise False.
- * @suff_order: starting index of current suffix being processed.
- * @str_len: length of the whole sequence string being processed; 
+ * Hands out the next internal node ID (n, n+1, ...) with no parent, suffix link or children.
+ * Leaves need no allocation: leaf i is node i.
+ * @tree: node table to allocate from
+ * @returns: ID of the new internal node
  */
-int generate_id(bool is_leaf, int suff_index, int str_len);
+NodeId create_internal_node(NodeTable* tree);
+
+// Node accessors -- inline since they sit on every hot path
+static inline bool is_leaf(const NodeTable* tree, NodeId node) {
+    return node < (NodeId)tree->str_len;
+}
+
+static inline bool is_root(const NodeTable* tree, NodeId node) {
+    return node == tree->root;
+}
+
+static inline NodeId node_parent(const NodeTable* tree, NodeId node) {
+    return is_leaf(tree, node) ? tree->leaf_parent[node] : tree->parent[node - tree->str_len];
+}
+
+static inline void set_parent(NodeTable* tree, NodeId node, NodeId parent) {
+    if (is_leaf(tree, node)) {
+        tree->leaf_parent[node] = parent;
+    } else {
+        tree->parent[node - tree->str_len] = parent;
+    }
+}
+
+static inline int node_depth(const NodeTable* tree, NodeId node) {
+    return is_leaf(tree, node) ? tree->str_len - (int)node : tree->depth[node - tree->str_len];
+}
+
+// start index of the node's incoming edge label
+static inline int edge_start(const NodeTable* tree, NodeId node) {
+    if (is_leaf(tree, node)) {
+        return (int)node + tree->depth[tree->leaf_parent[node] - tree->str_len];
+    }
+    return tree->edge_start[node - tree->str_len];
+}
+
+// end index (inclusive) of the node's incoming edge label
+static inline int edge_end(const NodeTable* tree, NodeId node) {
+    if (is_leaf(tree, node)) {
+        return tree->str_len - 1;
+    }
+    NodeId i = node - tree->str_len;
+    return tree->edge_start[i] + tree->depth[i] - tree->depth[tree->parent[i] - tree->str_len] - 1;
+}
+
+// children of a node in lexicographic order: first_child, then next_sibling until NO_NODE
+static inline NodeId first_child(const NodeTable* tree, NodeId node) {
+    return is_leaf(tree, node) ? NO_NODE : tree->first_child[node - tree->str_len];
+}
+
+static inline NodeId next_sibling(const NodeTable* tree, NodeId node) {
+    return is_leaf(tree, node) ? tree->leaf_next_sibling[node] : tree->next_sibling[node - tree->str_len];
+}
+
+// index in the alphabet of the first character on the node's incoming edge
+static inline int child_branch(const NodeTable* tree, NodeId node) {
+    return is_leaf(tree, node) ? tree->leaf_branch[node] : tree->branch[node - tree->str_len];
+}
+
+static inline NodeId get_child(const NodeTable* tree, NodeId node, int branch) {
+    if (is_leaf(tree, node)) {
+        return NO_NODE;
+    }
+
+    NodeId i = node - tree->str_len;
+    if (tree->dense_slot[i] >= 0) {
+        return tree->dense_children[(size_t)tree->dense_slot[i] * tree->alphabet_size + branch];
+    }
+
+    // small fanout -- scan the sorted sibling list
+    for (NodeId child = tree->first_child[i]; child != NO_NODE; child = next_sibling(tree, child)) {
+        int child_b = child_branch(tree, child);
+        if (child_b == branch) return child;
+        if (child_b > branch) break;
+    }
+    return NO_NODE;
+}
+
+// MatchLength
+/**
+ * Length of the common prefix of a[0...max-1] and b[0...max-1], compared 8 bytes at a time: the first
+ * differing byte is the lowest set byte of the XOR of two 64-bit words (little-endian hosts; others
+ * compare byte by byte). Only the first @max bytes of each side are read, so @max must stay inside
+ * the strings (e.g. up to $); the last max % 8 bytes are compared one at a time.
+ */
+static inline int match_length(const char* a, const char* b, int max) {
+    int k = 0;
+#if defined(__GNUC__) && defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    for (; k + 8 <= max; k += 8) {
+        uint64_t x, y;
+        memcpy(&x, a + k, sizeof(x));
+        memcpy(&y, b + k, sizeof(y));
+        uint64_t diff = x ^ y;
+        if (diff) return k + (__builtin_ctzll(diff) >> 3);
+    }
+#endif
+    while (k < max && a[k] == b[k]) k++;
+    return k;
+}
+
+// sets the sibling link of a leaf or internal node
+void set_next_sibling(NodeTable* tree, NodeId node, NodeId sibling);
+
+// gives a high-fanout internal node a dense child block mirroring its sibling list
+void make_dense(NodeTable* tree, NodeId node);
 
+// AddChild
 /**
- * Given a character in an alphabet, gets the corresponding index in the children array of a node
+ * Links a child under an internal node, keeping the sibling list sorted by branch character.
+ * Promotes the node to a dense child table once its fanout exceeds DENSE_FANOUT.
+ * @node: internal node receiving the child (must not have a child on @branch yet)
+ * @branch: index in the alphabet of the first character of the child's edge
+ * @child: node to link
+ */
+void add_child(NodeTable* tree, NodeId node, int branch, NodeId child);
+
+// ReplaceChild
+/**
+ * Puts @new_child in the place of @old_child among @node's children (same branch character).
+ * Used when an edge is split and the new internal node takes over the old child's slot.
+ */
+void replace_child(NodeTable* tree, NodeId node, NodeId old_child, NodeId new_child);
+
+// Tree visitor
+/**
+ * Callbacks of visit_tree. enter runs before a node's children (pre-order), leave after them (post-order).
+ * @level: distance of the node from the node the walk started at
+ * @context: caller state passed through visit_tree
+ * enter returns false to skip the node's subtree (leave still runs for the node).
+ */
+typedef bool (*VisitEnter)(const SuffixTree* st, NodeId node, int level, void* context);
+typedef void (*VisitLeave)(const SuffixTree* st, NodeId node, int level, void* context);
+
+// VisitTree
+/**
+ * Walks the subtree of @node in lexicographic order without recursion or a stack: down first children,
+ * then up the parent links to the next sibling, so memory stays O(1) however deep the tree is.
+ * Every tree walk (printing, statistics, BWT, repeats, longest common substring) runs on it.
+ * @node: root of the walk (its siblings are not visited)
+ * @enter: called when a node is reached (NULL: descend everywhere)
+ * @leave: called when a node's subtree is finished (may be NULL)
+ * @context: passed to both callbacks
+ */
+void visit_tree(const SuffixTree* st, NodeId node, VisitEnter enter, VisitLeave leave, void* context);
+
+// CreateSuffixTree
+/**
+ * Creates an empty suffix tree (just the root) owning copies of the sequence and alphabet,
+ * with the lengths and the 256-entry character rank table precomputed. Validates the sequence.
+ * @sequence_string: full sequence string (ends with $)
+ * @alphabet: alphabet the sequence is comprised of (including $)
+ */
+SuffixTree* create_suffix_tree(const char* sequence_string, const char* alphabet);
+
+// FreeSuffixTree
+/**
+ * Releases the tree and everything it owns (nodes, sequence, alphabet).
+ */
+void free_suffix_tree(SuffixTree* st);
+
+/**
+ * Given a character in an alphabet, gets the corresponding branch index of a node (O(1) table lookup)
+ * @st: tree holding the rank table
  * @c: character in an alphabet
- * @alphabet: alphabet over which a sequence string is comrpised of
- * @returns: corresponding index in children array (in a node) of a character
+ * @returns: index of the character in the alphabet
  */
-int get_char_child_index(const char c, const char* alphabet);
+static inline int get_char_child_index(const SuffixTree* st, const char c) {
+    return st->char_rank[(unsigned char)c];
+}
 
 // FindPath 
 /**
@@ -37,83 +205,70 @@ int get_char_child_index(const char c, const char* alphabet);
  * the longest possible prefix of the specified string arg,
  * and then inserts the next suffix.
  * i.e., inserts sufix S[i...] under some node u
+ * @st: tree being built (node table, sequence, lengths, rank table)
  * @root: root node of tree to find path from
- * @string: full string
- * @index: starting index of string
- * @alphabet: alphabet that string is comprised of
+ * @suff_index: starting index of suffix string
+ * @start_pos: index position to start comparing in sequence string
+ * @returns: parent of the newly inserted leaf
  */
-Node* find_path(Node* root, const char* sequence_string, int suff_index, int start_pos, const char* alphabet);
+NodeId find_path(SuffixTree* st, NodeId root, int suff_index, int start_pos);
 
 // NodeHops
 /**
  * Does node hopping child to child until
  * string Beta (or Beta') is exhausted, depending on the case
+ * @st: tree being built (node table, sequence, lengths, rank table)
  * @v_prime: node start node hopping from
- * @sequence_string: full sequence string
  * @suff_index: starting index of suffing string to insert
- * @beta: if u' is not root: beta = u.stringdepth. otherwise, beta = c + alpha between u and root.
+ * @beta_len: if u' is not root: beta = u.stringdepth. otherwise, beta = c + alpha between u and root.
+ * @beta_start: starting index position in the string according to beta edge from u.
  * @returns: node v - node reached from node hopping
  */
-Node* node_hops(Node* v_prime, const char* sequence_string, int suff_index, const char* alphabet, int beta_len, int beta_start);
+NodeId node_hops(SuffixTree* st, NodeId v_prime, int suff_index, int beta_len, int beta_start);
 
 /**
  * Case: SL(u) is known.
  * Inserts suffix string into ST.
  * @u: parent of leaf i-1 during suffix index iteration of building ST
- * @string: full sequence string 
  * @suff_index: starting index of suffing string to insert
- * @alphabet: alphabet that string is comprised of
+ * @returns: parent of the newly inserted leaf
  */
-Node* suff_link_known(Node* u, const char* sequence_string, int suff_index, const char* alphabet);
+NodeId suff_link_known(SuffixTree* st, NodeId u, int suff_index);
 
 /**
  * Case: SL(u) is unknown and u' (grandparent of leaf i-1) is not the root.
  * Inserts suffix string into ST.
  * @u: parent of leaf i-1 during suffix index iteration of building ST
- * @string: full sequence string 
  * @suff_index: starting index of suffing string to insert
- * @alphabet: alphabet that string is comprised of
+ * @returns: parent of the newly inserted leaf
  */
-Node* suff_link_unknown_internal(Node* u, const char* sequence_string, int suff_index, const char* alphabet);
+NodeId suff_link_unknown_internal(SuffixTree* st, NodeId u, int suff_index);
 
 /**
  * Case: SL(u) is unknown and u' (grandparent of leaf i-1) is the root.
  * Inserts suffix string into ST.
  * @u: parent of leaf i-1 during suffix index iteration of building ST
- * @sequence_string: full sequence string 
  * @suff_index: starting index of suffix string to insert
- * @alphabet: alphabet that string is comprised of
- * @returns: last internal node created during insertion
+ * @returns: parent of the newly inserted leaf
  */
-Node* suff_link_unknown_root(Node* u, const char* sequence_string, int suff_index, const char* alphabet);
+NodeId suff_link_unknown_root(SuffixTree* st, NodeId u, int suff_index);
 
 // ST Construction -- Naive or Linear
 /**
  * @sequence_string: input string to build ST of
  * @alphabet: alphabet related to input string to build ST with
- * @returns - root node of tree
+ * @returns - suffix tree owning its nodes, sequence and alphabet; free_suffix_tree releases it
  */
-Node* build_suffix_tree(const char* sequence_string, const char* alphabet, bool is_naive);
+SuffixTree* build_suffix_tree(const char* sequence_string, const char* alphabet, bool is_naive);
 
 
 /***************
  * PRINTING / TESTING CONSTRUCTION OF TREE FUNCTIONS
  ****************/
 
-// Helper function to check if a node is a leaf
-// Assumes leaf IDs are 0...n-1
-bool is_leaf(Node* node, int str_len);
-
-// Helper function to check if a node is the root
-/**
-* Assumes the root node initialized its suff_link to itself already
-* @node: node to check
- */
-bool is_root(Node* node);
-
 // PrintTree
-void print_suffix_tree(Node* node, const char* sequence_string, const char* alphabet, int str_len, int depth);
-void print_tree(Node* root, const char* sequence_string, const char* alphabet);
+void print_suffix_tree(const SuffixTree* st, NodeId node, int depth);
+void print_tree(const SuffixTree* st);
 
 // Stats
 /**
@@ -124,15 +279,15 @@ void print_tree(Node* root, const char* sequence_string, const char* alphabet);
  * - Average string-depth of internal nodes
  * - String-depth of the deepest internal node
  */
-void print_tree_stats(Node* node, const char* sequence_string, const char* alphabet, int str_len, int depth);
+void print_tree_stats(const SuffixTree* st);
 
  
 // Display children left to right
 /**
- * Given a pointer to a specific node u in the tree, display u's children from left to right
- * @node_u: node whose children to display
+ * Given a specific node u in the tree, display u's children from left to right
+ * @u: node whose children to display
  */
-void display_children(Node* u, const char* alphabet);
+void display_children(const SuffixTree* st, NodeId u);
 
 // Enumerate nodes using DFS
 /**
@@ -140,7 +295,7 @@ void display_children(Node* u, const char* alphabet);
 * As a result of this enumeration, displays STRING DEPTH info from each node.
 * @node_r: starting/root node to enumerate the tree
 */
-void dfs_enumerate(Node* node_r, const char* sequence_string, const char* alphabet);
+void dfs_enumerate(const SuffixTree* st, NodeId node_r);
 
 // BWT index
 /**
@@ -150,15 +305,15 @@ void dfs_enumerate(Node* node_r, const char* sequence_string, const char* alphab
     * where leaf(i) is the suffix ID of the ith leaf in lexicographical order.
  * If i = 0, then B[0] = $ (i.e., cycling around from the end of the string)
  */
-void compute_bwt_index(Node* root, const char* sequence_file, const char* sequence_string, const char* alphabet);
+void compute_bwt_index(const SuffixTree* st, const char* sequence_file);
 
-// estimating space usage according to seq string size
-void report_space_usage(Node* root, const char* seq_str, const char* alphabet);
+// reporting space used by the node table relative to the seq string size
+void report_space_usage(const SuffixTree* st);
 
 // finding longest repeated substrings
-void find_longest_repeat(Node* node, const char* sequence, const char* alphabet, LongestRepeat* result, int current_depth);
-void collect_leaf_positions(Node* node, const char* sequence, const char* alphabet, LongestRepeat* result);
-LongestRepeat find_repeats(Node* root, const char* sequence, const char* alphabet);
+void find_longest_repeat(const SuffixTree* st, NodeId node, NodeId* deepest);
+void collect_leaf_positions(const SuffixTree* st, NodeId node, LongestRepeat* result);
+LongestRepeat find_repeats(const SuffixTree* st);
 void print_repeats(const LongestRepeat* repeat, const char* sequence);
 
 
@@ -1,6 +1,9 @@
 #ifndef TYPES_H
 #define TYPES_H
 
+#include <stdint.h>
+#include <stddef.h>
+
 typedef enum bool {
     false,
     true
@@ -12,19 +15,55 @@ typedef struct sequence {
     char *sequence;  // sequence data
 } Sequence;
 
-typedef struct node {
-    int id; // 0...n-1 (for leaves, the suffix order), n...x (internal nodes)
-    struct node* suff_link; // ptr to suffix link node
-    struct node* parent;
-    struct node** children; // array of children of size dependent on size of alphabet
-    int depth; // length of the string that leads from root to the node
-    int edge_label[2]; // [start_index, end_index], i.e., label of incoming edge from parent
-} Node;
+// Index of a node in a NodeTable: 0...n-1 for leaves (the suffix order), n...x for internal nodes
+typedef uint32_t NodeId;
+#define NO_NODE ((NodeId)UINT32_MAX)
+
+// internal nodes with more children than this get a dense child table
+#define DENSE_FANOUT 8
+
+// Suffix tree nodes stored as structure-of-arrays, linked through 32-bit indices instead of pointers.
+// Leaf i stores no children: its depth is n - i and its edge label is [i + parent.depth, n - 1].
+// Children hang off first_child as a sibling list sorted by branch character (lexicographic order);
+// nodes with more than DENSE_FANOUT children also get a dense alphabet_size block for O(1) lookup.
+typedef struct {
+    int str_len; // n, i.e., number of leaves
+    int alphabet_size; // number of distinct branch characters (including $)
+    NodeId root; // id of the root (the first internal node, n)
+    int internal_count; // internal nodes handed out so far (including the root)
+    int internal_capacity; // internal nodes the arrays have room for
+
+    // [n] arrays indexed by leaf id
+    NodeId* leaf_parent;
+    NodeId* leaf_next_sibling;
+    uint8_t* leaf_branch; // index in the alphabet of the first character of the incoming edge
+
+    // [internal_capacity] arrays indexed by id - n
+    int* depth; // length of the string that leads from root to the node
+    int* edge_start; // start index of incoming edge label; end index follows from the parent's depth
+    NodeId* parent;
+    NodeId* suff_link; // NO_NODE until known
+    NodeId* first_child; // lexicographically smallest child
+    NodeId* next_sibling;
+    uint8_t* branch;
+    uint32_t* child_count;
+    int* dense_slot; // block in dense_children, -1 while the node's fanout is small
+
+    NodeId* dense_children; // alphabet_size child slots per dense block, NO_NODE if empty
+    int dense_count; // dense blocks handed out
+    int dense_capacity; // dense blocks the pool has room for
+} NodeTable;
 
+// A suffix tree and everything it was built from. Trees share no state with each other,
+// so any number of them can be built, queried and freed concurrently from independent threads.
 typedef struct {
-    int from_s1;
-    int from_s2;
-} SubtreeColor;
+    char* sequence; // owned copy of the sequence string (ends with $)
+    int str_len; // length of sequence (including $)
+    char* alphabet; // owned copy of the alphabet (including $)
+    int alphabet_size;
+    int16_t char_rank[256]; // index in the alphabet of every byte value, -1 if not in the alphabet
+    NodeTable nodes; // node storage, internal node counter and root
+} SuffixTree;
 
 typedef struct {
     int Sscore; // substitution (match/mismatch)
@@ -48,6 +87,31 @@ typedef struct {
     int count;
 } LongestRepeat;
 
+// Accumulators of the tree walks built on visit_tree
+typedef struct {
+    int internal_nodes; // excluding the root
+    int leaves;
+    int total_nodes;
+    long long total_internal_depth;
+    int max_depth;
+} TreeStats;
+
+typedef struct {
+    char* bwt; // [n] BWT characters in leaf order
+    int count; // characters written so far
+} BwtWalk;
+
+// leaves below a node from each string of a two-string tree, as bits of a color mask
+#define COLOR_S1 1
+#define COLOR_S2 2
+
+// State of the longest common substring walk: color of every finished internal node, indexed by id - n
+typedef struct {
+    int len1; // leaves 0...len1-1 belong to s1, the rest to s2
+    uint8_t* color;
+    LongestRepeat* result;
+} LcsWalk;
+
 typedef struct {
     int alignment_score; // alignment score between the sequences
     int lcs_length; // length of the longest common substring (LCS)
@@ -1,4 +1,5 @@
 #include "input_parser.h"
+#include "input_stream.h"
 #include <stdlib.h>
 #include <string.h>
 
@@ -12,7 +13,7 @@ int parse_alignment_type(const char *arg) {
 }
 
 Sequence* read_sequence_inputs(const char *filename, const size_t num_seq) {
-    FILE *file = fopen(filename, "r");
+    InputStream *file = open_input_stream(filename, 0); // gzip/BGZF inflated on the fly
     if (!file) {
         perror("Error opening file");
         exit(1);
@@ -23,7 +24,7 @@ Sequence* read_sequence_inputs(const char *filename, const size_t num_seq) {
 
     if (!sequences || !allocated_sizes) {
         perror("Memory allocation failed");
-        fclose(file);
+        close_input_stream(file);
         exit(1);
     }
 
@@ -37,7 +38,7 @@ Sequence* read_sequence_inputs(const char *filename, const size_t num_seq) {
 
         if (!sequences[i].sequence) {
             perror("Failed to allocate sequence memory");
-            fclose(file);
+            close_input_stream(file);
             exit(1);
         }
 
@@ -45,9 +46,10 @@ Sequence* read_sequence_inputs(const char *filename, const size_t num_seq) {
     }
 
     int curr_seq = -1; // current sequence being processed
-    char line[256]; // buffer to hold current line being read
+    char *line = NULL; // whole lines, so a long header is never mistaken for sequence
+    size_t capacity = 0;
 
-    while (fgets(line, sizeof(line), file)) {
+    while (input_stream_getline(&line, &capacity, file) > 0) {
         if (line[0] == '>') {
             curr_seq++;
             if (curr_seq >= num_seq) break; // ignore extra sequences, if any
@@ -59,7 +61,7 @@ Sequence* read_sequence_inputs(const char *filename, const size_t num_seq) {
             sequences[curr_seq].name = strdup(line + 1); // skip '>' part of the header -- allocate memory for name
             if (!sequences[curr_seq].name) {
                 perror("Failed to allocate name memory");
-                fclose(file);
+                close_input_stream(file);
                 exit(1);
             }
         } 
@@ -80,7 +82,7 @@ Sequence* read_sequence_inputs(const char *filename, const size_t num_seq) {
                 char *temp = realloc(sequences[curr_seq].sequence, new_size);
                 if (!temp) {
                     perror("Failed to realloc sequence");
-                    fclose(file);
+                    close_input_stream(file);
                     exit(1);
                 }
                 sequences[curr_seq].sequence = temp;
@@ -91,8 +93,12 @@ Sequence* read_sequence_inputs(const char *filename, const size_t num_seq) {
         }
     }
 
+    free(line);
     free(allocated_sizes);
-    fclose(file);
+    if (close_input_stream(file) != 0) {
+        fprintf(stderr, "Error: %s is corrupt or truncated\n", filename);
+        exit(1);
+    }
     
     return sequences;
 }
@@ -20,6 +20,7 @@ int parse_alignment_type(const char *arg);
  * This header line will always starts with the ">" symbol and is immediately followed (without any whitespace character) by a word that will serve as the unique identifier (or name) for that sequence. Whatever follows the first whitespace character after the identifier is a don't care and can be ignored in your program. 
  * The header line is followed by the actual DNA sequence which is a string over the alphabet {a,c,g,t}. 
  * The sequence can span multiple lines and each line can variable number of characters (but no whitespaces or any other special characters).
+ * The file may be gzip or BGZF compressed; it is decompressed while it is read (see open_input_stream).
  */
 Sequence* read_sequence_inputs(const char *filename, const size_t num_seq);
 
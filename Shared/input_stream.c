@@ -0,0 +1,431 @@
+#include "input_stream.h"
+#include <string.h>
+#include <limits.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <zlib.h>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+// Format of the underlying file
+typedef enum {
+    INPUT_PLAIN,
+    INPUT_GZIP, // one or more gzip members, inflated as one stream
+    INPUT_BGZF // gzip members of at most 64 KB each, inflated independently
+} InputKind;
+
+// One BGZF block in the queue: filled by the worker that read it, drained by the reader
+typedef struct {
+    unsigned char compressed[INPUT_BGZF_MAX_BLOCK]; // whole block as stored (header, deflate data, trailer)
+    size_t compressed_size;
+    size_t deflate_offset; // start of the deflate data in compressed
+    char data[INPUT_BGZF_MAX_BLOCK];
+    size_t data_size;
+    int ready; // data holds the inflated block
+} BgzfBlock;
+
+struct InputStream {
+    FILE* file;
+    InputKind kind;
+    int error; // read or format error: the stream ends early
+    int finished; // no more data
+
+    // read-ahead for input_stream_gets
+    char ahead[INPUT_GZIP_CHUNK];
+    size_t ahead_pos;
+    size_t ahead_len;
+
+    // gzip
+    z_stream zs;
+    unsigned char* compressed;
+    int in_member; // inside a member that has not reached its end yet
+
+    // BGZF: block k goes to slot k % num_slots; workers read blocks in order and inflate them in parallel
+    BgzfBlock* slots;
+    int num_slots;
+    pthread_t* workers;
+    int num_workers;
+    pthread_mutex_t lock;
+    pthread_cond_t block_done; // a block was inflated (or the file ended)
+    pthread_cond_t slot_free; // the reader released a block
+    uint64_t next_read; // next block to read from the file
+    uint64_t next_consume; // block the reader is draining
+    size_t consume_pos; // bytes of it already returned
+    int end_of_file;
+    int stop;
+};
+
+// helper function: little-endian 16 and 32-bit fields of the gzip format
+unsigned int read_le16(const unsigned char* p) {
+    return p[0] | (p[1] << 8);
+}
+
+uint32_t read_le32(const unsigned char* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// helper function: total size of a BGZF block from its 12-byte gzip header and extra field (0 if not BGZF)
+size_t bgzf_block_size(const unsigned char* header, const unsigned char* extra, size_t xlen) {
+    if (header[0] != 0x1f || header[1] != 0x8b || header[2] != 8 || !(header[3] & 4)) return 0;
+    for (size_t i = 0; i + 4 <= xlen; ) {
+        size_t length = read_le16(extra + i + 2);
+        if (extra[i] == 'B' && extra[i + 1] == 'C' && length == 2 && i + 6 <= xlen) {
+            return read_le16(extra + i + 4) + 1;
+        }
+        i += 4 + length;
+    }
+    return 0;
+}
+
+// helper function: read the next BGZF block into a slot (1: read, 0: clean end of file, -1: corrupt)
+int read_bgzf_block(FILE* file, BgzfBlock* block) {
+    unsigned char* p = block->compressed;
+    size_t got = fread(p, 1, 12, file);
+    if (got == 0) return 0;
+    if (got < 12) return -1;
+
+    size_t xlen = read_le16(p + 10);
+    if (12 + xlen > INPUT_BGZF_MAX_BLOCK || fread(p + 12, 1, xlen, file) != xlen) return -1;
+    size_t size = bgzf_block_size(p, p + 12, xlen);
+    if (size < 12 + xlen + 8 || size > INPUT_BGZF_MAX_BLOCK) return -1;
+    if (fread(p + 12 + xlen, 1, size - 12 - xlen, file) != size - 12 - xlen) return -1;
+
+    block->compressed_size = size;
+    block->deflate_offset = 12 + xlen;
+    return 1;
+}
+
+// helper function: inflate a BGZF block and check its CRC and length (0 if corrupt)
+int inflate_bgzf_block(z_stream* zs, BgzfBlock* block) {
+    const unsigned char* trailer = block->compressed + block->compressed_size - 8;
+    uint32_t crc = read_le32(trailer);
+    uint32_t isize = read_le32(trailer + 4);
+    if (isize > INPUT_BGZF_MAX_BLOCK) return 0;
+
+    inflateReset(zs);
+    zs->next_in = block->compressed + block->deflate_offset;
+    zs->avail_in = (uInt)(block->compressed_size - block->deflate_offset - 8);
+    zs->next_out = (Bytef*)block->data;
+    zs->avail_out = INPUT_BGZF_MAX_BLOCK;
+    if (inflate(zs, Z_FINISH) != Z_STREAM_END || zs->total_out != isize) return 0;
+
+    block->data_size = isize;
+    return crc32(crc32(0L, Z_NULL, 0), (const Bytef*)block->data, isize) == crc;
+}
+
+// helper function: worker thread taking the next block from the file and inflating it
+void* bgzf_worker(void* arg) {
+    InputStream* in = (InputStream*)arg;
+    z_stream zs;
+    memset(&zs, 0, sizeof(zs));
+    if (inflateInit2(&zs, -15) != Z_OK) { // raw deflate: the gzip framing is parsed by read_bgzf_block
+        pthread_mutex_lock(&in->lock);
+        in->error = 1;
+        pthread_cond_broadcast(&in->block_done);
+        pthread_mutex_unlock(&in->lock);
+        return NULL;
+    }
+
+    pthread_mutex_lock(&in->lock);
+    for (;;) {
+        // bounded queue: block k may only be read once block k - num_slots has been drained
+        while (!in->stop && !in->end_of_file && !in->error &&
+               in->next_read - in->next_consume >= (uint64_t)in->num_slots) {
+            pthread_cond_wait(&in->slot_free, &in->lock);
+        }
+        if (in->stop || in->end_of_file || in->error) break;
+
+        // the file is read in block order under the lock; only inflating runs in parallel
+        BgzfBlock* block = &in->slots[in->next_read % in->num_slots];
+        int result = read_bgzf_block(in->file, block);
+        if (result <= 0) {
+            in->end_of_file = 1;
+            if (result < 0) in->error = 1;
+            pthread_cond_broadcast(&in->block_done);
+            pthread_cond_broadcast(&in->slot_free);
+            break;
+        }
+        in->next_read++;
+        pthread_mutex_unlock(&in->lock);
+
+        int ok = inflate_bgzf_block(&zs, block);
+
+        pthread_mutex_lock(&in->lock);
+        if (ok) block->ready = 1;
+        else in->error = 1;
+        pthread_cond_broadcast(&in->block_done);
+    }
+    pthread_mutex_unlock(&in->lock);
+
+    inflateEnd(&zs);
+    return NULL;
+}
+
+// helper function: BGZF reads, draining the queue in block order
+size_t read_bgzf(InputStream* in, char* buffer, size_t size) {
+    size_t total = 0;
+    while (total < size) {
+        BgzfBlock* block = &in->slots[in->next_consume % in->num_slots];
+        pthread_mutex_lock(&in->lock);
+        while (!block->ready && !in->error && !(in->end_of_file && in->next_read == in->next_consume)) {
+            pthread_cond_wait(&in->block_done, &in->lock);
+        }
+        int ready = block->ready;
+        pthread_mutex_unlock(&in->lock);
+        if (!ready) {
+            in->finished = 1;
+            break;
+        }
+
+        // the block is not touched by the workers until it is released below
+        size_t count = block->data_size - in->consume_pos;
+        if (count > size - total) count = size - total;
+        memcpy(buffer + total, block->data + in->consume_pos, count);
+        in->consume_pos += count;
+        total += count;
+
+        if (in->consume_pos == block->data_size) {
+            pthread_mutex_lock(&in->lock);
+            block->ready = 0;
+            in->next_consume++;
+            in->consume_pos = 0;
+            pthread_cond_broadcast(&in->slot_free);
+            pthread_mutex_unlock(&in->lock);
+        }
+    }
+    return total;
+}
+
+// helper function: gzip reads, inflating member after member
+size_t read_gzip(InputStream* in, char* buffer, size_t size) {
+    z_stream* zs = &in->zs;
+    zs->next_out = (Bytef*)buffer;
+    zs->avail_out = (uInt)size;
+
+    while (zs->avail_out > 0) {
+        if (zs->avail_in == 0) {
+            size_t got = fread(in->compressed, 1, INPUT_GZIP_CHUNK, in->file);
+            if (got == 0) {
+                if (in->in_member || ferror(in->file)) in->error = 1; // truncated
+                in->finished = 1;
+                break;
+            }
+            zs->next_in = in->compressed;
+            zs->avail_in = (uInt)got;
+        }
+
+        in->in_member = 1;
+        int status = inflate(zs, Z_NO_FLUSH);
+        if (status == Z_STREAM_END) {
+            in->in_member = 0; // a concatenated member may follow
+            inflateReset(zs);
+        } else if (status != Z_OK && !(status == Z_BUF_ERROR && zs->avail_in == 0)) {
+            in->error = 1;
+            in->finished = 1;
+            break;
+        }
+    }
+    return size - zs->avail_out;
+}
+
+// helper function: reads below the read-ahead buffer
+size_t read_underlying(InputStream* in, char* buffer, size_t size) {
+    if (in->finished || size == 0) return 0;
+    switch (in->kind) {
+    case INPUT_GZIP:
+        return read_gzip(in, buffer, size);
+    case INPUT_BGZF:
+        return read_bgzf(in, buffer, size);
+    default: {
+        size_t got = fread(buffer, 1, size, in->file);
+        if (got < size) {
+            if (ferror(in->file)) in->error = 1;
+            in->finished = 1;
+        }
+        return got;
+    }
+    }
+}
+
+// helper function: default number of BGZF decompression threads
+int input_default_threads() {
+#ifndef _WIN32
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    return (cores > 0) ? (int)cores : 1;
+#else
+    return 4;
+#endif
+}
+
+int is_compressed_file(const char* filename) {
+    FILE* file = fopen(filename, "rb");
+    if (!file) return 0;
+    unsigned char magic[2];
+    int compressed = fread(magic, 1, 2, file) == 2 && magic[0] == 0x1f && magic[1] == 0x8b;
+    fclose(file);
+    return compressed;
+}
+
+// UncompressedNameLength
+size_t uncompressed_name_length(const char* filename) {
+    static const char* suffixes[] = {".gz", ".bgz", ".bwz"};
+    size_t length = strlen(filename);
+    for (size_t k = 0; k < sizeof(suffixes) / sizeof(suffixes[0]); k++) {
+        size_t suffix = strlen(suffixes[k]);
+        if (length > suffix && strcmp(filename + length - suffix, suffixes[k]) == 0) return length - suffix;
+    }
+    return length;
+}
+
+// InputFileStemLength
+size_t input_file_stem_length(const char* filename) {
+    size_t length = uncompressed_name_length(filename);
+    for (size_t i = length; i-- > 0 && filename[i] != '/' && filename[i] != '\\'; ) {
+        if (filename[i] == '.') return i;
+    }
+    return length;
+}
+
+// OpenInputStream
+InputStream* open_input_stream(const char* filename, int num_threads) {
+    FILE* file = fopen(filename, "rb");
+    if (!file) return NULL;
+
+    InputStream* in = (InputStream*)calloc(1, sizeof(InputStream));
+    if (!in) {
+        perror("Could not allocate memory for input stream");
+        exit(1);
+    }
+    in->file = file;
+    in->kind = INPUT_PLAIN;
+
+    // classify from the first header: BGZF is gzip whose extra field carries the block size
+    unsigned char header[12];
+    unsigned char extra[INPUT_BGZF_MAX_BLOCK];
+    if (fread(header, 1, 12, file) == 12 && header[0] == 0x1f && header[1] == 0x8b) {
+        in->kind = INPUT_GZIP;
+        size_t xlen = read_le16(header + 10);
+        if ((header[3] & 4) && fread(extra, 1, xlen, file) == xlen && bgzf_block_size(header, extra, xlen) > 0) {
+            in->kind = INPUT_BGZF;
+        }
+    }
+    rewind(file);
+
+    if (in->kind == INPUT_GZIP) {
+        in->compressed = (unsigned char*)malloc(INPUT_GZIP_CHUNK);
+        if (!in->compressed) {
+            perror("Could not allocate memory for input stream");
+            exit(1);
+        }
+        if (inflateInit2(&in->zs, 15 + 16) != Z_OK) { // gzip framing only
+            fprintf(stderr, "Error: Could not initialize gzip decompression\n");
+            exit(1);
+        }
+    } else if (in->kind == INPUT_BGZF) {
+        in->num_workers = (num_threads > 0) ? num_threads : input_default_threads();
+        in->num_slots = INPUT_BGZF_QUEUE_PER_THREAD * in->num_workers;
+        in->slots = (BgzfBlock*)calloc(in->num_slots, sizeof(BgzfBlock));
+        in->workers = (pthread_t*)malloc(in->num_workers * sizeof(pthread_t));
+        if (!in->slots || !in->workers) {
+            perror("Could not allocate memory for input stream");
+            exit(1);
+        }
+        pthread_mutex_init(&in->lock, NULL);
+        pthread_cond_init(&in->block_done, NULL);
+        pthread_cond_init(&in->slot_free, NULL);
+        for (int t = 0; t < in->num_workers; t++) {
+            if (pthread_create(&in->workers[t], NULL, bgzf_worker, in) != 0) {
+                perror("Could not start decompression thread");
+                exit(1);
+            }
+        }
+    }
+    return in;
+}
+
+// ReadInputStream
+size_t read_input_stream(InputStream* in, char* buffer, size_t size) {
+    size_t total = 0;
+    if (in->ahead_pos < in->ahead_len) {
+        total = in->ahead_len - in->ahead_pos;
+        if (total > size) total = size;
+        memcpy(buffer, in->ahead + in->ahead_pos, total);
+        in->ahead_pos += total;
+    }
+    return total + read_underlying(in, buffer + total, size - total);
+}
+
+// InputStreamGets
+char* input_stream_gets(char* line, int size, InputStream* in) {
+    int length = 0;
+    while (length < size - 1) {
+        if (in->ahead_pos == in->ahead_len) {
+            in->ahead_pos = 0;
+            in->ahead_len = read_underlying(in, in->ahead, sizeof(in->ahead));
+            if (in->ahead_len == 0) break;
+        }
+        const char* start = in->ahead + in->ahead_pos;
+        size_t count = in->ahead_len - in->ahead_pos;
+        if (count > (size_t)(size - 1 - length)) count = size - 1 - length;
+        const char* newline = (const char*)memchr(start, '\n', count);
+        if (newline) count = newline - start + 1;
+
+        memcpy(line + length, start, count);
+        in->ahead_pos += count;
+        length += (int)count;
+        if (newline) break;
+    }
+    if (length == 0) return NULL;
+    line[length] = '\0';
+    return line;
+}
+
+// InputStreamGetline
+size_t input_stream_getline(char** line, size_t* capacity, InputStream* in) {
+    size_t length = 0;
+    for (;;) {
+        if (*capacity - length < 2) {
+            size_t grown = (*capacity < 256) ? 256 : 2 * *capacity;
+            char* temp = (char*)realloc(*line, grown);
+            if (!temp) {
+                perror("Could not allocate memory for line");
+                exit(1);
+            }
+            *line = temp;
+            *capacity = grown;
+        }
+        size_t room = *capacity - length;
+        if (room > INT_MAX) room = INT_MAX;
+        if (!input_stream_gets(*line + length, (int)room, in)) break;
+        length += strlen(*line + length);
+        if (length > 0 && (*line)[length - 1] == '\n') break;
+    }
+    return length;
+}
+
+// CloseInputStream
+int close_input_stream(InputStream* in) {
+    if (in->kind == INPUT_BGZF) {
+        pthread_mutex_lock(&in->lock);
+        in->stop = 1;
+        pthread_cond_broadcast(&in->slot_free);
+        pthread_mutex_unlock(&in->lock);
+        for (int t = 0; t < in->num_workers; t++) {
+            pthread_join(in->workers[t], NULL);
+        }
+        pthread_mutex_destroy(&in->lock);
+        pthread_cond_destroy(&in->block_done);
+        pthread_cond_destroy(&in->slot_free);
+        free(in->slots);
+        free(in->workers);
+    } else if (in->kind == INPUT_GZIP) {
+        inflateEnd(&in->zs);
+        free(in->compressed);
+    }
+
+    int status = (in->error || ferror(in->file)) ? -1 : 0;
+    fclose(in->file);
+    free(in);
+    return status;
+}
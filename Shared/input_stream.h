@@ -0,0 +1,78 @@
+#ifndef INPUT_STREAM_H
+#define INPUT_STREAM_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+
+#define INPUT_BGZF_QUEUE_PER_THREAD 4 // BGZF blocks in flight per decompression thread
+#define INPUT_BGZF_MAX_BLOCK 65536 // a BGZF block holds at most 64 KB, compressed or not
+#define INPUT_GZIP_CHUNK 262144 // compressed bytes read at a time from a plain gzip file
+
+// Sequential reader over a plain, gzip or BGZF file (contents private to input_stream.c)
+typedef struct InputStream InputStream;
+
+// Is the file gzip-compressed (gzip or BGZF)?
+/**
+ * Looks at the two magic bytes only.
+ * @returns - 1 if the file starts with the gzip magic, 0 otherwise (also for unreadable files)
+ */
+int is_compressed_file(const char* filename);
+
+// Length of a file name without its compression suffix
+/**
+ * Drops a trailing .gz or .bgz (gzip/BGZF), or .bwz (a compressed sequence file of Suffix-Tree-Construction).
+ * @returns - length of the name without the suffix, strlen(filename) if there is none
+ */
+size_t uncompressed_name_length(const char* filename);
+
+// Length of a file name without its extension
+/**
+ * Drops the compression suffix first (uncompressed_name_length), then the extension, so chr12.fas.gz and
+ * chr12.fas both give chr12 to build output names from. Dots in directory names are not extensions.
+ * @returns - length of the stem, keeping the directory part of the name
+ */
+size_t input_file_stem_length(const char* filename);
+
+// Open an input stream
+/**
+ * Plain files are read as they are. gzip files (including concatenated members) are inflated as the
+ * stream is read. BGZF files are split into their independent blocks, which num_threads worker threads
+ * inflate ahead of the reader into a bounded queue of INPUT_BGZF_QUEUE_PER_THREAD * num_threads blocks,
+ * so decompression overlaps with whatever consumes the stream and memory stays bounded.
+ * @filename: name of the file
+ * @num_threads: BGZF decompression threads (<= 0: number of online cores)
+ * @returns - the stream, or NULL if the file cannot be opened
+ */
+InputStream* open_input_stream(const char* filename, int num_threads);
+
+// Read from an input stream
+/**
+ * Fills buffer with up to size decompressed bytes, like fread.
+ * @returns - bytes read, 0 at the end of the stream or after an error (see close_input_stream)
+ */
+size_t read_input_stream(InputStream* in, char* buffer, size_t size);
+
+// Read a line from an input stream
+/**
+ * Same contract as fgets: reads until a newline (kept) or size - 1 bytes, and null-terminates.
+ * @returns - line, or NULL at the end of the stream
+ */
+char* input_stream_gets(char* line, int size, InputStream* in);
+
+// Read a whole line from an input stream
+/**
+ * Like getline: reads up to and including the next newline however long the line is, growing *line
+ * (which may start as NULL with *capacity 0; the caller frees it) as needed.
+ * @returns - length of the line (newline included), 0 at the end of the stream
+ */
+size_t input_stream_getline(char** line, size_t* capacity, InputStream* in);
+
+// Close an input stream
+/**
+ * Stops the decompression threads and releases the stream.
+ * @returns - 0, or -1 if the file could not be read or is not valid gzip/BGZF (corrupt or truncated)
+ */
+int close_input_stream(InputStream* in);
+
+#endif
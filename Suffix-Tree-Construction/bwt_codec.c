@@ -0,0 +1,605 @@
+#include "bwt_codec.h"
+#include "bwt_io.h"
+#include "input_stream.h"
+#include <zlib.h>
+
+// helper function: default number of decoding threads
+int codec_default_threads() {
+#ifndef _WIN32
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    return (cores > 0) ? (int)cores : 1;
+#else
+    return 4;
+#endif
+}
+
+// helper function: run one decoding phase on every thread of the job (on the calling thread when there is one)
+void run_codec_workers(CodecJob* job, void* (*phase)(void*)) {
+    CodecWorker workers[CODEC_MAX_STREAMS];
+    pthread_t threads[CODEC_MAX_STREAMS];
+    for (int t = 0; t < job->num_threads; t++) {
+        workers[t].job = job;
+        workers[t].id = t;
+    }
+    if (job->num_threads == 1) {
+        phase(&workers[0]);
+        return;
+    }
+    for (int t = 0; t < job->num_threads; t++) {
+        if (pthread_create(&threads[t], NULL, phase, &workers[t]) != 0) {
+            perror("Could not start decoding thread");
+            exit(1);
+        }
+    }
+    for (int t = 0; t < job->num_threads; t++) {
+        pthread_join(threads[t], NULL);
+    }
+}
+
+// helper function: first element of part t when count elements are split into parts contiguous ranges
+TextPos part_start(TextPos count, int parts, int t) {
+    return (TextPos)((int64_t)count * t / parts);
+}
+
+// helper function: count the characters of this thread's range of the BWT
+void* count_worker(void* arg) {
+    CodecWorker* w = (CodecWorker*)arg;
+    CodecJob* job = w->job;
+    TextPos* counts = job->counts[w->id];
+    memset(counts, 0, 256 * sizeof(TextPos));
+    TextPos end = part_start(job->n, job->num_threads, w->id + 1);
+    for (TextPos i = part_start(job->n, job->num_threads, w->id); i < end; i++) {
+        counts[(unsigned char)job->bwt[i]]++;
+    }
+    return NULL;
+}
+
+// helper function: LF of this thread's range, each character taking the next row of its own (from the bases)
+void* lf_worker(void* arg) {
+    CodecWorker* w = (CodecWorker*)arg;
+    CodecJob* job = w->job;
+    TextPos* next = job->counts[w->id];
+    TextPos end = part_start(job->n, job->num_threads, w->id + 1);
+    for (TextPos i = part_start(job->n, job->num_threads, w->id); i < end; i++) {
+        job->lf[i] = next[(unsigned char)job->bwt[i]]++;
+    }
+    return NULL;
+}
+
+// helper function: LF mapping of the job's BWT, LF(i) = C[BWT[i]] + rank of BWT[i] in BWT[0..i)
+/**
+ * Rows are sorted by byte value, so C[c] counts the smaller bytes. Each thread counts its range of the BWT,
+ * then fills its range of LF from where the same character of the ranges before it left off.
+ * @returns - 0, or -1 if the BWT does not hold exactly one $ as its smallest character (job->lf stays NULL)
+ */
+int build_lf(CodecJob* job) {
+    job->counts = (TextPos(*)[256])malloc(job->num_threads * sizeof(*job->counts));
+    if (!job->counts) {
+        perror("Could not allocate memory for BWT inversion");
+        exit(1);
+    }
+    run_codec_workers(job, count_worker);
+
+    TextPos rows = 0;
+    for (int c = 0; c < 256; c++) {
+        TextPos total = 0;
+        for (int t = 0; t < job->num_threads; t++) {
+            TextPos count = job->counts[t][c];
+            job->counts[t][c] = rows + total;
+            total += count;
+        }
+        if ((c < '$' && total > 0) || (c == '$' && total != 1)) {
+            free(job->counts);
+            job->counts = NULL;
+            return -1;
+        }
+        rows += total;
+    }
+
+    job->lf = (TextPos*)malloc(job->n * sizeof(TextPos));
+    if (!job->lf) {
+        perror("Could not allocate memory for BWT inversion");
+        exit(1);
+    }
+    run_codec_workers(job, lf_worker);
+    free(job->counts);
+    job->counts = NULL;
+    return 0;
+}
+
+// helper function: first text position of inversion stream s (streams past the end of the text are empty)
+TextPos stream_start(TextPos n, int num_streams, int s) {
+    int64_t segment = ((int64_t)n - 1 + num_streams - 1) / num_streams;
+    return (TextPos)((s * segment < (int64_t)n - 1) ? s * segment : (int64_t)n - 1);
+}
+
+// helper function: rows of the first text position of each stream, by walking LF once from the $ suffix (row 0)
+void find_stream_rows(const TextPos* lf, TextPos n, int num_streams, int64_t* stream_rows) {
+    TextPos row = 0;
+    int s = num_streams - 1;
+    for (TextPos position = n - 1; ; position--) {
+        while (s >= 0 && stream_start(n, num_streams, s) == position) {
+            stream_rows[s--] = row;
+        }
+        if (position == 0) break;
+        row = lf[row];
+    }
+}
+
+// helper function: decode this thread's streams back to front, advancing all of them in turn
+/**
+ * A single walk pays a cache miss per character, one after the other. The streams are independent, so
+ * their misses overlap; each stream starts on the row its successor begins at (the last on row 0, $) and
+ * must end on its own row.
+ */
+void* walk_worker(void* arg) {
+    CodecWorker* w = (CodecWorker*)arg;
+    CodecJob* job = w->job;
+    TextPos n = job->n;
+    int first = (int)part_start(job->num_streams, job->num_threads, w->id);
+    int last = (int)part_start(job->num_streams, job->num_threads, w->id + 1);
+    const char* bwt = job->bwt;
+    const TextPos* lf = job->lf;
+    char* text = job->text;
+
+    TextPos row[CODEC_MAX_STREAMS];
+    TextPos position[CODEC_MAX_STREAMS];
+    TextPos stop[CODEC_MAX_STREAMS];
+    TextPos longest = 0;
+    int k = 0;
+    for (int s = first; s < last; s++, k++) {
+        row[k] = (s + 1 < job->num_streams) ? (TextPos)job->stream_rows[s + 1] : 0;
+        position[k] = (s + 1 < job->num_streams) ? stream_start(n, job->num_streams, s + 1) : n - 1;
+        stop[k] = stream_start(n, job->num_streams, s);
+        if (position[k] - stop[k] > longest) longest = position[k] - stop[k];
+    }
+
+    for (TextPos step = 0; step < longest; step++) {
+        for (k = 0; k < last - first; k++) {
+            if (position[k] == stop[k]) continue;
+            text[--position[k]] = bwt[row[k]];
+            row[k] = lf[row[k]];
+        }
+    }
+
+    for (k = 0; k < last - first; k++) {
+        if (row[k] != (TextPos)job->stream_rows[first + k]) __atomic_store_n(&job->failed, 1, __ATOMIC_RELAXED);
+    }
+    return NULL;
+}
+
+// Invert a BWT
+char* invert_bwt(const char* bwt, TextPos n, const int64_t* stream_rows, int num_streams, int num_threads) {
+    if (n < 1) return NULL;
+    CodecJob job;
+    memset(&job, 0, sizeof(job));
+    job.bwt = bwt;
+    job.n = n;
+    if (!stream_rows) num_streams = 1;
+    if (num_threads <= 0) num_threads = codec_default_threads();
+    job.num_threads = (num_threads < num_streams) ? num_threads : num_streams;
+    if (build_lf(&job) != 0) return NULL;
+
+    int64_t whole_text = (const char*)memchr(bwt, '$', n) - bwt; // the row of the whole text is preceded by $
+    job.stream_rows = stream_rows ? stream_rows : &whole_text;
+    job.num_streams = num_streams;
+    for (int s = 0; s < num_streams; s++) {
+        if (job.stream_rows[s] < 0 || job.stream_rows[s] >= n) job.failed = 1;
+    }
+    job.text = (char*)malloc((size_t)n + 1);
+    if (!job.text) {
+        perror("Could not allocate memory for BWT inversion");
+        exit(1);
+    }
+    if (!job.failed) run_codec_workers(&job, walk_worker);
+    free(job.lf);
+    if (job.failed) {
+        free(job.text);
+        return NULL;
+    }
+    job.text[n - 1] = '$';
+    job.text[n] = '\0';
+    return job.text;
+}
+
+// CodecFileName
+void codec_file_name(const char* sequence_file, char* output_filename, size_t size) {
+    snprintf(output_filename, size, "%.*s.bwz", (int)uncompressed_name_length(sequence_file), sequence_file);
+}
+
+// Is the file a compressed sequence file?
+int is_codec_file(const char* filename) {
+    FILE* file = fopen(filename, "rb");
+    if (!file) return 0;
+    char magic[8];
+    size_t got = fread(magic, 1, sizeof(magic), file);
+    fclose(file);
+    return got == sizeof(magic) && memcmp(magic, CODEC_FILE_MAGIC, sizeof(magic)) == 0;
+}
+
+// helper function: move-to-front and zero-run coding of one block; returns the number of symbols
+/**
+ * A run of r rank-0 characters is written as the bijective base-2 digits of r, low digit first,
+ * RUNA (0) for a digit 1 and RUNB (1) for a digit 2; rank k > 0 is written as symbol k + 1.
+ * Never produces more symbols than characters.
+ */
+uint32_t mtf_rle_encode(const uint8_t* block, uint32_t length, uint16_t* symbols) {
+    uint8_t order[256];
+    for (int c = 0; c < 256; c++) order[c] = (uint8_t)c;
+
+    uint32_t count = 0;
+    uint32_t run = 0;
+    for (uint32_t i = 0; i <= length; i++) {
+        if (i < length && block[i] == order[0]) {
+            run++;
+            continue;
+        }
+        while (run > 0) {
+            if (run & 1) {
+                symbols[count++] = 0;
+                run = (run - 1) >> 1;
+            } else {
+                symbols[count++] = 1;
+                run = (run - 2) >> 1;
+            }
+        }
+        if (i == length) break;
+
+        // move block[i] to the front, shifting the characters before it back by one
+        uint8_t c = block[i];
+        uint8_t previous = order[0];
+        int rank = 1;
+        order[0] = c;
+        while (order[rank] != c) {
+            uint8_t temp = order[rank];
+            order[rank] = previous;
+            previous = temp;
+            rank++;
+        }
+        order[rank] = previous;
+        symbols[count++] = (uint16_t)(rank + 1);
+    }
+    return count;
+}
+
+// helper function: scale symbol counts to frequencies summing to 1 << CODEC_SCALE_BITS (used symbols keep >= 1)
+void normalize_frequencies(const uint32_t* counts, uint32_t total, uint32_t* freq) {
+    const uint32_t target = 1u << CODEC_SCALE_BITS;
+    uint32_t sum = 0;
+    for (int s = 0; s < CODEC_SYMBOLS; s++) {
+        freq[s] = 0;
+        if (counts[s] == 0) continue;
+        freq[s] = (uint32_t)((uint64_t)counts[s] * target / total);
+        if (freq[s] == 0) freq[s] = 1;
+        sum += freq[s];
+    }
+
+    // the rounding error goes to (or comes from) the most frequent symbols
+    while (sum != target) {
+        int largest = 0;
+        for (int s = 1; s < CODEC_SYMBOLS; s++) {
+            if (freq[s] > freq[largest]) largest = s;
+        }
+        if (sum < target) {
+            freq[largest] += target - sum;
+            sum = target;
+        } else {
+            uint32_t take = (sum - target < freq[largest] - 1) ? sum - target : freq[largest] - 1;
+            freq[largest] -= take;
+            sum -= take;
+        }
+    }
+}
+
+// helper function: code one block (write errors are collected by the output buffer)
+void write_codec_block(OutputBuffer* out, const uint8_t* block, uint32_t length, uint16_t* symbols, uint8_t* coded) {
+    uint32_t num_symbols = mtf_rle_encode(block, length, symbols);
+
+    uint32_t counts[CODEC_SYMBOLS] = {0};
+    for (uint32_t i = 0; i < num_symbols; i++) {
+        counts[symbols[i]]++;
+    }
+    uint32_t freq[CODEC_SYMBOLS];
+    uint32_t start[CODEC_SYMBOLS];
+    normalize_frequencies(counts, num_symbols, freq);
+    uint32_t cumulative = 0;
+    uint16_t num_used = 0;
+    for (int s = 0; s < CODEC_SYMBOLS; s++) {
+        start[s] = cumulative;
+        cumulative += freq[s];
+        if (freq[s] > 0) num_used++;
+    }
+
+    // rANS codes the symbols last to first, filling coded from its end, so they decode first to last
+    uint32_t capacity = 2 * num_symbols + 8; // at most 2 bytes per symbol with 12-bit frequencies, 4 for the state
+    uint8_t* ptr = coded + capacity;
+    uint32_t x = CODEC_RANS_LOW;
+    for (uint32_t i = num_symbols; i-- > 0; ) {
+        uint32_t s = symbols[i];
+        uint32_t x_max = ((CODEC_RANS_LOW >> CODEC_SCALE_BITS) << 8) * freq[s];
+        while (x >= x_max) {
+            *--ptr = (uint8_t)(x & 0xff);
+            x >>= 8;
+        }
+        x = ((x / freq[s]) << CODEC_SCALE_BITS) + (x % freq[s]) + start[s];
+    }
+    for (int k = 0; k < 4; k++) {
+        *--ptr = (uint8_t)(x >> (8 * k)); // final state, high byte first
+    }
+    uint32_t coded_size = (uint32_t)(coded + capacity - ptr);
+
+    output_bytes(out, &length, sizeof(length));
+    output_bytes(out, &num_symbols, sizeof(num_symbols));
+    output_bytes(out, &coded_size, sizeof(coded_size));
+    output_bytes(out, &num_used, sizeof(num_used));
+    for (int s = 0; s < CODEC_SYMBOLS; s++) {
+        if (freq[s] == 0) continue;
+        uint16_t pair[2] = {(uint16_t)s, (uint16_t)freq[s]};
+        output_bytes(out, pair, sizeof(pair));
+    }
+    output_bytes(out, ptr, coded_size);
+}
+
+// Write a compressed sequence file
+int write_codec_file(const char* filename, const char* name, const char* bwt, TextPos n) {
+    // the encoder walks LF once, so the decoder can start every inversion stream at once
+    CodecJob job;
+    memset(&job, 0, sizeof(job));
+    job.num_threads = 1;
+    job.bwt = bwt;
+    job.n = n;
+    if (n < 1 || build_lf(&job) != 0) {
+        fprintf(stderr, "Error: not a BWT (a BWT holds exactly one $, its smallest character)\n");
+        exit(1);
+    }
+
+    FILE* file = fopen(filename, "wb");
+    if (!file) {
+        free(job.lf);
+        return -1;
+    }
+    OutputBuffer out;
+    init_output_buffer(&out, file);
+
+    CodecFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CODEC_FILE_MAGIC, sizeof(header.magic));
+    header.version = CODEC_FILE_VERSION;
+    header.endian_check = BWT_FILE_ENDIAN_CHECK;
+    header.block_size = CODEC_BLOCK_SIZE;
+    header.name_length = (uint32_t)strlen(name);
+    header.str_len = n;
+    header.num_blocks = ((int64_t)n + CODEC_BLOCK_SIZE - 1) / CODEC_BLOCK_SIZE;
+    header.num_streams = (uint32_t)(((int64_t)n - 1) / CODEC_STREAM_LENGTH + 1);
+    if (header.num_streams > CODEC_MAX_STREAMS) header.num_streams = CODEC_MAX_STREAMS;
+    uLong crc = crc32(0L, Z_NULL, 0);
+    for (int64_t i = 0; i < n; i += CODEC_BLOCK_SIZE) {
+        crc = crc32(crc, (const Bytef*)bwt + i, (uInt)((n - i < CODEC_BLOCK_SIZE) ? n - i : CODEC_BLOCK_SIZE));
+    }
+    header.checksum = (uint32_t)crc;
+    output_bytes(&out, &header, sizeof(header));
+    output_bytes(&out, name, header.name_length);
+    int64_t stream_rows[CODEC_MAX_STREAMS];
+    find_stream_rows(job.lf, n, (int)header.num_streams, stream_rows);
+    free(job.lf);
+    output_bytes(&out, stream_rows, header.num_streams * sizeof(int64_t));
+
+    uint16_t* symbols = (uint16_t*)malloc(CODEC_BLOCK_SIZE * sizeof(uint16_t));
+    uint8_t* coded = (uint8_t*)malloc(2 * CODEC_BLOCK_SIZE + 8);
+    if (!symbols || !coded) {
+        perror("Could not allocate memory for codec");
+        exit(1);
+    }
+    for (int64_t i = 0; i < n; i += CODEC_BLOCK_SIZE) {
+        uint32_t length = (uint32_t)((n - i < CODEC_BLOCK_SIZE) ? n - i : CODEC_BLOCK_SIZE);
+        write_codec_block(&out, (const uint8_t*)bwt + i, length, symbols, coded);
+    }
+    free(symbols);
+    free(coded);
+
+    return close_output_buffer(&out);
+}
+
+// helper function: exit on a compressed file that ends early or does not decode
+void codec_file_error(const char* filename, FILE* file) {
+    fprintf(stderr, "Error: compressed file %s is truncated or corrupt\n", filename);
+    if (file) fclose(file);
+    exit(1);
+}
+
+// helper function: decode one block into bwt (rANS, zero runs and move-to-front in one pass)
+/**
+ * @returns - 0, or -1 if the block does not decode to exactly length characters
+ */
+int read_codec_block(const uint8_t* coded, uint32_t coded_size, uint32_t num_symbols, const uint16_t* freq,
+                     const uint32_t* start, const uint16_t* slot_symbol, uint8_t* bwt, uint32_t length) {
+    const uint8_t* ptr = coded;
+    const uint8_t* end = coded + coded_size;
+    if (coded_size < 4) return -1;
+    uint32_t x = ((uint32_t)ptr[0] << 24) | ((uint32_t)ptr[1] << 16) | ((uint32_t)ptr[2] << 8) | ptr[3];
+    ptr += 4;
+
+    uint8_t order[256];
+    for (int c = 0; c < 256; c++) order[c] = (uint8_t)c;
+    uint32_t out = 0;
+    uint32_t run = 0;
+    uint32_t weight = 1;
+    const uint32_t mask = (1u << CODEC_SCALE_BITS) - 1;
+
+    for (uint32_t i = 0; i <= num_symbols; i++) {
+        uint32_t s = CODEC_SYMBOLS; // past the last symbol: flush the final run
+        if (i < num_symbols) {
+            uint32_t slot = x & mask;
+            s = slot_symbol[slot];
+            x = freq[s] * (x >> CODEC_SCALE_BITS) + slot - start[s];
+            while (x < CODEC_RANS_LOW) {
+                if (ptr == end) return -1;
+                x = (x << 8) | *ptr++;
+            }
+        }
+
+        if (s <= 1) { // RUNA or RUNB: one more bijective base-2 digit of the run
+            if (weight > length) return -1;
+            run += (s + 1) * weight;
+            weight <<= 1;
+            continue;
+        }
+        if (run > 0) {
+            if (run > length - out) return -1;
+            memset(bwt + out, order[0], run);
+            out += run;
+            run = 0;
+            weight = 1;
+        }
+        if (s == CODEC_SYMBOLS) break;
+
+        if (out == length) return -1;
+        uint32_t rank = s - 1;
+        uint8_t c = order[rank];
+        for (; rank > 0; rank--) order[rank] = order[rank - 1]; // ranks are small: cheaper than memmove
+        order[0] = c;
+        bwt[out++] = c;
+    }
+    return (out == length) ? 0 : -1;
+}
+
+// helper function: decode the blocks this thread claims, each with its own frequency table and CRC
+void* decode_worker(void* arg) {
+    CodecWorker* w = (CodecWorker*)arg;
+    CodecJob* job = w->job;
+    uint16_t slot_symbol[1u << CODEC_SCALE_BITS];
+
+    for (;;) {
+        int64_t b = __atomic_fetch_add(&job->next_block, 1, __ATOMIC_RELAXED);
+        if (b >= job->num_blocks) break;
+        CodecBlock* block = &job->blocks[b];
+
+        uint16_t freq[CODEC_SYMBOLS] = {0};
+        uint32_t start[CODEC_SYMBOLS];
+        int ok = 1;
+        for (uint16_t k = 0; k < block->num_used; k++) {
+            uint16_t pair[2];
+            memcpy(pair, block->pairs + k * sizeof(pair), sizeof(pair));
+            if (pair[0] >= CODEC_SYMBOLS || pair[1] == 0) ok = 0;
+            else freq[pair[0]] = pair[1];
+        }
+        uint32_t cumulative = 0;
+        for (int s = 0; ok && s < CODEC_SYMBOLS; s++) {
+            start[s] = cumulative;
+            if (cumulative + freq[s] > (1u << CODEC_SCALE_BITS)) ok = 0;
+            for (uint32_t slot = cumulative; ok && slot < cumulative + freq[s]; slot++) {
+                slot_symbol[slot] = (uint16_t)s;
+            }
+            cumulative += freq[s];
+        }
+        uint8_t* out = (uint8_t*)job->bwt + block->offset;
+        if (!ok || cumulative != (1u << CODEC_SCALE_BITS) ||
+            read_codec_block(block->coded, block->coded_size, block->num_symbols, freq, start, slot_symbol, out, block->length) != 0) {
+            __atomic_store_n(&job->failed, 1, __ATOMIC_RELAXED);
+            continue;
+        }
+        block->crc = (uint32_t)crc32(crc32(0L, Z_NULL, 0), out, block->length);
+    }
+    return NULL;
+}
+
+// Read a compressed sequence file
+char* read_codec_file(const char* filename, char** name, int num_threads) {
+    FILE* file = fopen(filename, "rb");
+    if (!file) {
+        perror("Error opening compressed file");
+        exit(1);
+    }
+
+    CodecFileHeader header;
+    if (fread(&header, 1, sizeof(header), file) != sizeof(header) ||
+        memcmp(header.magic, CODEC_FILE_MAGIC, sizeof(header.magic)) != 0) {
+        codec_file_error(filename, file);
+    }
+    if (header.version != CODEC_FILE_VERSION || header.endian_check != BWT_FILE_ENDIAN_CHECK ||
+        header.str_len < 1 || header.str_len >= POS_MAX || header.block_size == 0 || header.block_size > CODEC_MAX_BLOCK_SIZE ||
+        header.num_blocks != (header.str_len + header.block_size - 1) / header.block_size ||
+        header.num_streams < 1 || header.num_streams > CODEC_MAX_STREAMS) {
+        fprintf(stderr, "Error: compressed file %s has an unsupported version, byte order or length\n", filename);
+        fclose(file);
+        exit(1);
+    }
+    TextPos n = (TextPos)header.str_len;
+
+    *name = (char*)malloc((size_t)header.name_length + 1);
+    if (!*name) {
+        perror("Could not allocate memory for compressed file");
+        exit(1);
+    }
+    if (fread(*name, 1, header.name_length, file) != header.name_length) codec_file_error(filename, file);
+    (*name)[header.name_length] = '\0';
+    int64_t stream_rows[CODEC_MAX_STREAMS];
+    if (fread(stream_rows, sizeof(int64_t), header.num_streams, file) != header.num_streams) {
+        codec_file_error(filename, file);
+    }
+
+    // the blocks are read in one go and located, so threads can decode them in any order
+    long blocks_start = ftell(file);
+    if (blocks_start < 0 || fseek(file, 0, SEEK_END) != 0) codec_file_error(filename, file);
+    size_t image_size = (size_t)(ftell(file) - blocks_start);
+    fseek(file, blocks_start, SEEK_SET);
+    uint8_t* image = (uint8_t*)malloc(image_size + 1);
+    char* bwt = (char*)malloc((size_t)n + 1);
+    CodecBlock* blocks = (CodecBlock*)malloc(header.num_blocks * sizeof(CodecBlock));
+    if (!image || !bwt || !blocks) {
+        perror("Could not allocate memory for compressed file");
+        exit(1);
+    }
+    if (fread(image, 1, image_size, file) != image_size) codec_file_error(filename, file);
+    fclose(file);
+
+    const uint8_t* ptr = image;
+    const uint8_t* end = image + image_size;
+    TextPos offset = 0;
+    for (int64_t b = 0; b < header.num_blocks; b++) {
+        CodecBlock* block = &blocks[b];
+        const size_t fixed = 3 * sizeof(uint32_t) + sizeof(uint16_t);
+        if ((size_t)(end - ptr) < fixed) codec_file_error(filename, NULL);
+        memcpy(&block->length, ptr, sizeof(uint32_t));
+        memcpy(&block->num_symbols, ptr + 4, sizeof(uint32_t));
+        memcpy(&block->coded_size, ptr + 8, sizeof(uint32_t));
+        memcpy(&block->num_used, ptr + 12, sizeof(uint16_t));
+        ptr += fixed;
+        if (block->length == 0 || block->length > header.block_size || block->length > (uint64_t)(n - offset) ||
+            block->num_symbols > block->length || block->coded_size > 2 * block->num_symbols + 8 ||
+            block->num_used == 0 || block->num_used > CODEC_SYMBOLS ||
+            (size_t)(end - ptr) < 4 * (size_t)block->num_used + block->coded_size) {
+            codec_file_error(filename, NULL);
+        }
+        block->pairs = ptr;
+        ptr += 4 * (size_t)block->num_used;
+        block->coded = ptr;
+        ptr += block->coded_size;
+        block->offset = offset;
+        offset += block->length;
+    }
+    if (offset != n) codec_file_error(filename, NULL);
+
+    if (num_threads <= 0) num_threads = codec_default_threads();
+    CodecJob job;
+    memset(&job, 0, sizeof(job));
+    job.num_threads = (num_threads < CODEC_MAX_STREAMS) ? num_threads : CODEC_MAX_STREAMS;
+    if (job.num_threads > header.num_blocks) job.num_threads = (int)header.num_blocks;
+    job.blocks = blocks;
+    job.num_blocks = header.num_blocks;
+    job.bwt = bwt;
+    job.n = n;
+    run_codec_workers(&job, decode_worker);
+    free(image);
+    if (job.failed) codec_file_error(filename, NULL);
+
+    uLong crc = crc32(0L, Z_NULL, 0);
+    for (int64_t b = 0; b < header.num_blocks; b++) {
+        crc = crc32_combine(crc, blocks[b].crc, blocks[b].length);
+    }
+    free(blocks);
+    char* text = ((uint32_t)crc == header.checksum) ? invert_bwt(bwt, n, stream_rows, (int)header.num_streams, num_threads) : NULL;
+    free(bwt);
+    if (!text) codec_file_error(filename, NULL);
+    return text;
+}
@@ -0,0 +1,82 @@
+#ifndef BWT_CODEC_H
+#define BWT_CODEC_H
+
+#include "types.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <pthread.h>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+#define CODEC_FILE_MAGIC "BWTCODEC"
+#define CODEC_FILE_VERSION 1
+#define CODEC_BLOCK_SIZE (1 << 18) // BWT characters per independently coded block (small enough to spread over threads)
+#define CODEC_MAX_BLOCK_SIZE (1 << 24) // largest block a file may declare
+#define CODEC_SYMBOLS 257 // RUNA, RUNB and move-to-front ranks 1..255
+#define CODEC_SCALE_BITS 12 // rANS frequencies sum to 1 << CODEC_SCALE_BITS (the decoding table stays in L1)
+#define CODEC_RANS_LOW (1u << 23) // lower bound of the rANS state
+#define CODEC_MAX_STREAMS 32 // independent walks of the BWT inversion (and most decoding threads)
+#define CODEC_STREAM_LENGTH 16384 // fewest characters per inversion stream (each costs 8 bytes of file)
+
+// Invert a BWT
+/**
+ * Recovers the text by LF-mapping, LF(i) = C[BWT[i]] + rank of BWT[i] in BWT[0..i): the row of a suffix
+ * leads to the row of the suffix one character earlier, and BWT[i] is that character. LF is built by
+ * threads over contiguous ranges of the BWT. Each character of a walk is a dependent random access, so
+ * the text is cut into streams at evenly spaced positions whose rows are given; the streams are split
+ * among the threads, and each thread advances its streams in turn so their cache misses overlap.
+ * Rows are assumed sorted by byte value, which is the order of read_alphabet ($ first, then the
+ * characters in ascending order).
+ * @bwt: BWT characters
+ * @n: number of characters
+ * @stream_rows: row of the first position of each stream (as written by write_codec_file), NULL for one walk
+ * @num_streams: number of streams (at most CODEC_MAX_STREAMS)
+ * @num_threads: most threads to use (no more than there are streams), 0 for one per online core
+ * @returns - null-terminated text ending with $, or NULL if bwt is not the BWT of such a text
+ */
+char* invert_bwt(const char* bwt, TextPos n, const int64_t* stream_rows, int num_streams, int num_threads);
+
+// CodecFileName
+/**
+ * Gets the name of the compressed file of a sequence file: <sequence file>.bwz, chr12.fas.gz giving chr12.fas.bwz
+ */
+void codec_file_name(const char* sequence_file, char* output_filename, size_t size);
+
+// Is the file a compressed sequence file?
+/**
+ * Looks at the magic only.
+ * @returns - 1 for a file written by write_codec_file, 0 otherwise (also for unreadable files)
+ */
+int is_codec_file(const char* filename);
+
+// Write a compressed sequence file
+/**
+ * Compresses a sequence from its BWT, block by block: move-to-front, bijective base-2 coding of the
+ * runs of rank 0 (RUNA/RUNB, as in bzip2) and a static order-0 rANS coder whose frequencies are
+ * stored with each block. Long runs in the BWT become a few run digits, so repetitive sequences
+ * code well below 2 bits per character. The rows of up to CODEC_MAX_STREAMS evenly spaced text
+ * positions are stored too, for invert_bwt.
+ * @filename: name of the file to write
+ * @name: name of the sequence (its FASTA header)
+ * @bwt: BWT of the sequence
+ * @n: number of characters
+ * @returns - 0, or -1 if the file could not be written
+ */
+int write_codec_file(const char* filename, const char* name, const char* bwt, TextPos n);
+
+// Read a compressed sequence file
+/**
+ * Decodes the BWT of a file written by write_codec_file, checks it against its CRC-32 and inverts it.
+ * The blocks are read in one go and decoded by a pool of threads (like BGZF members), each checksummed
+ * on its own and the CRCs combined; the inversion is threaded too (invert_bwt).
+ * @filename: name of the compressed file
+ * @name: receives the name of the sequence (caller frees)
+ * @num_threads: most threads to use, 0 for one per online core
+ * @returns - null-terminated sequence ending with $ (exits if the file cannot be read or is corrupt)
+ */
+char* read_codec_file(const char* filename, char** name, int num_threads);
+
+#endif
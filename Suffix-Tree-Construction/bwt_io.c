@@ -0,0 +1,339 @@
+#include "bwt_io.h"
+#include "input_stream.h"
+#include <time.h>
+
+// ParseBWTFormat
+int parse_bwt_format(const char* name, BwtFormat* format) {
+    if (strcmp(name, "text") == 0) *format = BWT_FORMAT_TEXT;
+    else if (strcmp(name, "raw") == 0) *format = BWT_FORMAT_RAW;
+    else if (strcmp(name, "packed") == 0) *format = BWT_FORMAT_PACKED;
+    else if (strcmp(name, "rle") == 0) *format = BWT_FORMAT_RLE;
+    else return -1;
+    return 0;
+}
+
+// BWTFormatName
+const char* bwt_format_name(BwtFormat format) {
+    switch (format) {
+    case BWT_FORMAT_TEXT: return "text";
+    case BWT_FORMAT_PACKED: return "packed";
+    case BWT_FORMAT_RLE: return "rle";
+    default: return "raw";
+    }
+}
+
+// BWTFileName
+void bwt_file_name(const char* sequence_file, BwtFormat format, char* output_filename, size_t size) {
+    const char* extension = (format == BWT_FORMAT_TEXT) ? "txt" :
+                            (format == BWT_FORMAT_PACKED) ? "2bit" :
+                            (format == BWT_FORMAT_RLE) ? "rle" : "raw";
+    snprintf(output_filename, size, "%.*s_bwt.%s",
+             (int)input_file_stem_length(sequence_file),
+             sequence_file, extension);
+}
+
+// Output buffer
+void init_output_buffer(OutputBuffer* out, FILE* file) {
+    out->file = file;
+    out->size = BWT_BUFFER_SIZE;
+    out->data = (uint8_t*)malloc(out->size);
+    out->used = 0;
+    out->written = 0;
+    out->ok = true;
+    if (!out->data) {
+        perror("Could not allocate memory for output buffer");
+        exit(1);
+    }
+}
+
+void output_bytes(OutputBuffer* out, const void* data, size_t size) {
+    const uint8_t* bytes = (const uint8_t*)data;
+    // flush when full (output_byte passes size 0 for that), then copy what fits, buffer by buffer
+    do {
+        if (out->used == out->size || (size > 0 && out->used + size > out->size && out->used > 0)) {
+            if (out->ok && fwrite(out->data, 1, out->used, out->file) != out->used) out->ok = false;
+            out->written += out->used;
+            out->used = 0;
+        }
+        size_t count = (size < out->size - out->used) ? size : out->size - out->used;
+        memcpy(out->data + out->used, bytes, count);
+        out->used += count;
+        bytes += count;
+        size -= count;
+    } while (size > 0);
+}
+
+int close_output_buffer(OutputBuffer* out) {
+    if (out->ok && out->used > 0 && fwrite(out->data, 1, out->used, out->file) != out->used) out->ok = false;
+    out->written += out->used;
+    out->used = 0;
+    free(out->data);
+    out->data = NULL;
+    if (fclose(out->file) != 0) out->ok = false;
+    return out->ok ? 0 : -1;
+}
+
+// helper function: wall-clock seconds, for the write throughput
+double bwt_wall_seconds() {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// helper function: codes of the packed format, most frequent characters first; returns the exception count
+TextPos choose_packed_symbols(const char* bwt, TextPos n, char symbols[4], int8_t code[256]) {
+    TextPos frequency[256] = {0};
+    for (TextPos i = 0; i < n; i++) {
+        frequency[(unsigned char)bwt[i]]++;
+    }
+
+    memset(code, -1, 256);
+    memset(symbols, 'A', 4); // codes without a character never occur
+    TextPos packed = 0;
+    for (int k = 0; k < 4; k++) {
+        int best = -1;
+        for (int c = 0; c < 256; c++) {
+            if (frequency[c] > 0 && code[c] < 0 && (best < 0 || frequency[c] > frequency[best])) best = c;
+        }
+        if (best < 0) break;
+        code[best] = (int8_t)k;
+        symbols[k] = (char)best;
+        packed += frequency[best];
+    }
+    return n - packed;
+}
+
+// helper function: LEB128 varint, 7 bits per byte, low bits first
+void output_varint(OutputBuffer* out, uint64_t value) {
+    while (value >= 0x80) {
+        output_byte(out, (uint8_t)(value & 0x7f) | 0x80);
+        value >>= 7;
+    }
+    output_byte(out, (uint8_t)value);
+}
+
+// WriteBWTFile
+void write_bwt_file(const char* sequence_file, const char* bwt, TextPos n, BwtFormat format) {
+    double start = bwt_wall_seconds();
+
+    // choose the packed codes first: a file that would not be smaller than raw is written raw
+    char symbols[4];
+    int8_t code[256];
+    TextPos exceptions = 0;
+    if (format == BWT_FORMAT_PACKED) {
+        exceptions = choose_packed_symbols(bwt, n, symbols, code);
+        if ((uint64_t)(n + 3) / 4 + (uint64_t)exceptions * (sizeof(int64_t) + 1) >= (uint64_t)n) {
+            printf("Packed BWT would not be smaller than raw (%lld characters outside the 4 most frequent); writing raw\n",
+                   (long long)exceptions);
+            char stale[256];
+            bwt_file_name(sequence_file, BWT_FORMAT_PACKED, stale, sizeof(stale));
+            remove(stale); // readers fall back to the raw file only when there is no packed one
+            format = BWT_FORMAT_RAW;
+        }
+    }
+
+    char output_filename[256];
+    bwt_file_name(sequence_file, format, output_filename, sizeof(output_filename));
+    FILE* file = fopen(output_filename, (format == BWT_FORMAT_TEXT) ? "w" : "wb");
+    if (file == NULL) {
+        perror("Error opening file");
+        return;
+    }
+    OutputBuffer out;
+    init_output_buffer(&out, file);
+
+    if (format != BWT_FORMAT_TEXT) {
+        BwtFileHeader header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, BWT_FILE_MAGIC, sizeof(header.magic));
+        header.version = BWT_FILE_VERSION;
+        header.endian_check = BWT_FILE_ENDIAN_CHECK;
+        header.format = format;
+        header.str_len = n;
+        if (format == BWT_FORMAT_PACKED) {
+            memcpy(header.symbols, symbols, 4);
+            header.count = exceptions;
+        } else if (format == BWT_FORMAT_RLE) {
+            for (TextPos i = 0; i < n; i++) {
+                if (i == 0 || bwt[i] != bwt[i - 1]) header.count++;
+            }
+        }
+        output_bytes(&out, &header, sizeof(header));
+    }
+
+    switch (format) {
+    case BWT_FORMAT_TEXT:
+        for (TextPos i = 0; i < n; i++) {
+            output_byte(&out, (uint8_t)bwt[i]);
+            output_byte(&out, '\n');
+        }
+        break;
+    case BWT_FORMAT_RAW:
+        output_bytes(&out, bwt, n);
+        break;
+    case BWT_FORMAT_PACKED:
+        for (TextPos i = 0; i < n; i += 4) {
+            uint8_t byte = 0;
+            for (int k = 0; k < 4 && i + k < n; k++) {
+                int c = code[(unsigned char)bwt[i + k]];
+                byte |= (uint8_t)((c < 0 ? 0 : c) << (2 * k));
+            }
+            output_byte(&out, byte);
+        }
+        for (TextPos i = 0; i < n && exceptions > 0; i++) {
+            if (code[(unsigned char)bwt[i]] < 0) {
+                int64_t position = i;
+                output_bytes(&out, &position, sizeof(position));
+            }
+        }
+        for (TextPos i = 0; i < n && exceptions > 0; i++) {
+            if (code[(unsigned char)bwt[i]] < 0) output_byte(&out, (uint8_t)bwt[i]);
+        }
+        break;
+    case BWT_FORMAT_RLE:
+        for (TextPos i = 0; i < n; ) {
+            TextPos run = 1;
+            while (i + run < n && bwt[i + run] == bwt[i]) run++;
+            output_varint(&out, (uint64_t)run);
+            output_byte(&out, (uint8_t)bwt[i]);
+            i += run;
+        }
+        break;
+    }
+
+    if (close_output_buffer(&out) != 0) {
+        perror("Error writing BWT file");
+        return;
+    }
+    double elapsed = bwt_wall_seconds() - start;
+
+    printf("BWT output written to: %s (%s, %llu bytes, %.2f bits per character)\n", output_filename,
+           bwt_format_name(format), (unsigned long long)out.written, (n > 0) ? 8.0 * out.written / n : 0.0);
+    printf("BWT Write Time: %.4f seconds (%.1f MB/s of BWT)\n", elapsed,
+           (elapsed > 0) ? n / (1024.0 * 1024.0) / elapsed : 0.0);
+}
+
+// helper function: exit on a BWT file that ends early or does not decode
+void bwt_file_error(const char* filename, FILE* file, char* bwt) {
+    fprintf(stderr, "Error: BWT file %s is truncated or corrupt\n", filename);
+    free(bwt);
+    fclose(file);
+    exit(1);
+}
+
+// Read a BWT file
+char* read_bwt_file(const char* filename) {
+    FILE* file = fopen(filename, "rb");
+    if (!file) {
+        perror("Error opening BWT file");
+        exit(1);
+    }
+    setvbuf(file, NULL, _IOFBF, BWT_BUFFER_SIZE);
+
+    BwtFileHeader header;
+    size_t got = fread(&header, 1, sizeof(header), file);
+    if (got < sizeof(header) || memcmp(header.magic, BWT_FILE_MAGIC, sizeof(header.magic)) != 0) {
+        // text: one character per line
+        rewind(file);
+        size_t capacity = BWT_BUFFER_SIZE;
+        size_t length = 0;
+        char* bwt = (char*)malloc(capacity);
+        if (!bwt) {
+            perror("Could not allocate memory for BWT");
+            fclose(file);
+            exit(1);
+        }
+        int c;
+        while ((c = getc(file)) != EOF) {
+            if (c == '\n' || c == '\r') continue;
+            if (length + 1 >= capacity) {
+                capacity *= 2;
+                char* temp = realloc(bwt, capacity);
+                if (!temp) {
+                    perror("Failed to realloc BWT");
+                    fclose(file);
+                    exit(1);
+                }
+                bwt = temp;
+            }
+            bwt[length++] = (char)c;
+        }
+        bwt[length] = '\0';
+        fclose(file);
+        return bwt;
+    }
+
+    if (header.version != BWT_FILE_VERSION || header.endian_check != BWT_FILE_ENDIAN_CHECK ||
+        header.str_len < 0 || header.str_len >= POS_MAX || header.count < 0) {
+        fprintf(stderr, "Error: BWT file %s has an unsupported version, byte order or length\n", filename);
+        fclose(file);
+        exit(1);
+    }
+    TextPos n = (TextPos)header.str_len;
+    char* bwt = (char*)malloc((size_t)n + 1);
+    if (!bwt) {
+        perror("Could not allocate memory for BWT");
+        fclose(file);
+        exit(1);
+    }
+
+    switch (header.format) {
+    case BWT_FORMAT_RAW:
+        if (fread(bwt, 1, n, file) != (size_t)n) bwt_file_error(filename, file, bwt);
+        break;
+    case BWT_FORMAT_PACKED: {
+        for (TextPos i = 0; i < n; i += 4) {
+            int byte = getc(file);
+            if (byte == EOF) bwt_file_error(filename, file, bwt);
+            for (int k = 0; k < 4 && i + k < n; k++) {
+                bwt[i + k] = header.symbols[(byte >> (2 * k)) & 3];
+            }
+        }
+        int64_t* positions = (int64_t*)malloc((size_t)header.count * sizeof(int64_t) + 1);
+        if (!positions) {
+            perror("Could not allocate memory for BWT");
+            exit(1);
+        }
+        if (fread(positions, sizeof(int64_t), header.count, file) != (size_t)header.count) {
+            free(positions);
+            bwt_file_error(filename, file, bwt);
+        }
+        for (int64_t e = 0; e < header.count; e++) {
+            int c = getc(file);
+            if (c == EOF || positions[e] < 0 || positions[e] >= n) {
+                free(positions);
+                bwt_file_error(filename, file, bwt);
+            }
+            bwt[positions[e]] = (char)c;
+        }
+        free(positions);
+        break;
+    }
+    case BWT_FORMAT_RLE: {
+        TextPos length = 0;
+        for (int64_t r = 0; r < header.count; r++) {
+            uint64_t run = 0;
+            int shift = 0;
+            int byte;
+            do {
+                byte = getc(file);
+                if (byte == EOF || shift > 63) bwt_file_error(filename, file, bwt);
+                run |= (uint64_t)(byte & 0x7f) << shift;
+                shift += 7;
+            } while (byte & 0x80);
+            int c = getc(file);
+            if (c == EOF || run == 0 || run > (uint64_t)(n - length)) bwt_file_error(filename, file, bwt);
+            memset(bwt + length, c, run);
+            length += (TextPos)run;
+        }
+        if (length != n) bwt_file_error(filename, file, bwt);
+        break;
+    }
+    default:
+        bwt_file_error(filename, file, bwt);
+    }
+
+    bwt[n] = '\0';
+    fclose(file);
+    return bwt;
+}
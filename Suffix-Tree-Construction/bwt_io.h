@@ -0,0 +1,76 @@
+#ifndef BWT_IO_H
+#define BWT_IO_H
+
+#include "types.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdint.h>
+
+#define BWT_FILE_MAGIC "BWTINDEX"
+#define BWT_FILE_VERSION 1
+#define BWT_FILE_ENDIAN_CHECK 0x01020304u
+#define BWT_BUFFER_SIZE (1 << 20) // bytes collected before each fwrite
+#define BWT_DEFAULT_FORMAT BWT_FORMAT_RAW
+
+// ParseBWTFormat
+/**
+ * Maps a --bwt-format name (text, raw, packed, rle) to its format.
+ * @returns - 0, or -1 if the name is unknown
+ */
+int parse_bwt_format(const char* name, BwtFormat* format);
+
+// BWTFormatName
+const char* bwt_format_name(BwtFormat format);
+
+// BWTFileName
+/**
+ * Gets the name of the BWT file of a sequence file: <sequence file without extension>_bwt.<ext>, a .gz,
+ * .bgz or .bwz suffix being dropped first (input_file_stem_length),
+ * where ext is txt (text), raw, 2bit (packed) or rle.
+ * @sequence_file: name of the file the sequence was read from
+ * @format: format of the file
+ * @output_filename: buffer receiving the name
+ * @size: size of the buffer
+ */
+void bwt_file_name(const char* sequence_file, BwtFormat format, char* output_filename, size_t size);
+
+// WriteBWTFile
+/**
+ * Writes a BWT to its BWT file (see bwt_file_name) through a BWT_BUFFER_SIZE output buffer and reports
+ * the file size, bits per character and write throughput.
+ * Packed files store the four most frequent characters as 2-bit codes and every other one ($, N, ...)
+ * as a (position, character) exception; when the exceptions would make the file larger than the raw
+ * format, the raw format is written instead (and an older packed file of the sequence is removed).
+ * @sequence_file: name of the file the sequence was read from
+ * @bwt: BWT characters
+ * @n: number of characters
+ * @format: format to write
+ */
+void write_bwt_file(const char* sequence_file, const char* bwt, TextPos n, BwtFormat format);
+
+// Read a BWT file
+/**
+ * Reads a BWT file of any format back into a string. Binary formats are recognized by their header,
+ * anything else is read as text (one character per line).
+ * @filename: name of the BWT file
+ * @returns - null-terminated BWT string (exits if the file cannot be read)
+ */
+char* read_bwt_file(const char* filename);
+
+// Output buffer
+/**
+ * Collects output bytes and writes them with one fwrite per BWT_BUFFER_SIZE bytes.
+ * close_output_buffer flushes, closes the file and returns 0, or -1 if any write failed.
+ */
+void init_output_buffer(OutputBuffer* out, FILE* file);
+void output_bytes(OutputBuffer* out, const void* data, size_t size);
+int close_output_buffer(OutputBuffer* out);
+
+// helper function: append one byte
+static inline void output_byte(OutputBuffer* out, uint8_t byte) {
+    if (out->used == out->size) output_bytes(out, NULL, 0); // flush
+    out->data[out->used++] = byte;
+}
+
+#endif
@@ -0,0 +1,143 @@
+#!/bin/sh
+# Checks a 64-bit position build (make POS64=1) on a synthetic sequence past 2^31 characters.
+#
+# usage: ./check_pos64.sh [length] [mem-limit MB]
+#
+# A random A/C/G background is written as FASTA with T-containing markers planted at known
+# offsets, some of them straddling position 2^31. The sequence goes through the out-of-core
+# builder (--mem-limit) and the count/locate queries of the FM-index are compared against a
+# brute-force scan of the same file. The default length is 2^31 + 2^20; a smaller length runs
+# the same comparison with the markers around n/2 instead of 2^31.
+#
+# Needs python3 and, at the default length, ~38 GB of free disk in CHECK_DIR (default $TMPDIR
+# or /tmp) and ~4 bytes of RAM per character for the text and the FM-index. The objects in
+# this directory are rebuilt with POS64=1 and removed afterwards; run make to get the default
+# build back.
+
+set -eu
+
+LENGTH=${1:-2148532224}
+MEM_LIMIT=${2:-1024}
+HERE=$(cd "$(dirname "$0")" && pwd)
+WORK=${CHECK_DIR:-${TMPDIR:-/tmp}}/check_pos64.$$
+FASTA=$WORK/synthetic.fas
+
+# rough requirements: FASTA, suffix array + LCP and BWT on disk, text and FM-index in RAM
+NEED_DISK_KB=$((LENGTH / 1024 * 18))
+NEED_MEM_KB=$((LENGTH / 1024 * 4))
+
+mkdir -p "$WORK"
+trap 'rm -rf "$WORK"; rm -f "$HERE"/*.o "$HERE"/suffix_tree' EXIT
+
+FREE_DISK_KB=$(df -Pk "$WORK" | awk 'NR == 2 { print $4 }')
+if [ "$FREE_DISK_KB" -lt "$NEED_DISK_KB" ]; then
+    echo "Skipped: $LENGTH characters need ~$((NEED_DISK_KB / 1048576)) GB free in $WORK, $((FREE_DISK_KB / 1048576)) GB available"
+    exit 2
+fi
+if [ -r /proc/meminfo ]; then
+    FREE_MEM_KB=$(awk '/^MemAvailable:/ { print $2 }' /proc/meminfo)
+    if [ "$FREE_MEM_KB" -lt "$NEED_MEM_KB" ]; then
+        echo "Skipped: $LENGTH characters need ~$((NEED_MEM_KB / 1048576)) GB of memory, $((FREE_MEM_KB / 1048576)) GB available"
+        exit 2
+    fi
+fi
+
+echo "Building with POS64=1"
+rm -f "$HERE"/*.o "$HERE"/suffix_tree
+make -C "$HERE" POS64=1 > "$WORK/build.log" 2>&1 || { cat "$WORK/build.log"; exit 1; }
+
+printf 'A C G T\n' > "$WORK/alphabet.txt"
+
+echo "Generating $LENGTH characters"
+python3 - "$LENGTH" "$FASTA" > "$WORK/markers.txt" <<'EOF'
+import random, sys
+
+n, path = int(sys.argv[1]), sys.argv[2]
+boundary = 1 << 31 if n > (1 << 31) + 4096 else n // 2
+markers = {
+    "TACGTTGCAT": [1000, boundary - 20, boundary + 777, n - 50],
+    "GATTACA": [boundary - 3, boundary + 40, n - 7],
+}
+planted = sorted((p, m) for m, ps in markers.items() for p in ps)
+table = bytes(b"ACG"[i % 3] for i in range(256))
+rng = random.Random(2024)
+chunk = 60 << 20  # a multiple of the line width
+with open(path, "wb") as out:
+    out.write(b">synthetic\n")
+    for start in range(0, n, chunk):
+        end = min(n, start + chunk)
+        seq = bytearray(rng.randbytes(end - start).translate(table))
+        for p, m in planted:
+            for j, c in enumerate(m.encode()):
+                if start <= p + j < end:
+                    seq[p + j - start] = c
+        out.write(b"\n".join(seq[i:i + 60] for i in range(0, len(seq), 60)) + b"\n")
+for m in markers:
+    print(m)
+EOF
+
+PATTERNS="$(cat "$WORK/markers.txt") T ACGG CAGCAG TTGCATA"
+
+echo "Counting patterns by brute force"
+python3 - "$FASTA" $PATTERNS > "$WORK/expected.txt" <<'EOF'
+import sys
+
+path, patterns = sys.argv[1], sys.argv[2:]
+overlap = max(map(len, patterns)) - 1
+counts = {p: 0 for p in patterns}
+positions = {p: [] for p in patterns}
+offset = 0  # text position of buf[0]
+buf = b""
+with open(path, "rb") as f:
+    f.readline()
+    while True:
+        data = f.read(64 << 20)
+        if not data:
+            break
+        buf += data.replace(b"\n", b"")
+        # occurrences starting in the first len(buf) - overlap characters are complete and new
+        limit = len(buf) - overlap
+        for p in patterns:
+            pb = p.encode()
+            i = buf.find(pb)
+            while 0 <= i < limit:
+                counts[p] += 1
+                if len(positions[p]) <= 20:
+                    positions[p].append(offset + i)
+                i = buf.find(pb, i + 1)
+        offset += limit
+        buf = buf[limit:]
+for p in patterns:
+    pb = p.encode()
+    i = buf.find(pb)
+    while i >= 0:
+        counts[p] += 1
+        positions[p].append(offset + i)
+        i = buf.find(pb, i + 1)
+for p in patterns:
+    located = " ".join(map(str, sorted(positions[p]))) if counts[p] <= 20 else "-"
+    print(p, counts[p], located)
+EOF
+
+echo "Running suffix_tree --mem-limit $MEM_LIMIT"
+ARGS=""
+for p in $PATTERNS; do ARGS="$ARGS --pattern $p"; done
+"$HERE/suffix_tree" "$FASTA" "$WORK/alphabet.txt" --mem-limit "$MEM_LIMIT" --locate $ARGS > "$WORK/run.log" 2>&1 \
+    || { tail -20 "$WORK/run.log"; exit 1; }
+
+# turn "Pattern 'X': N occurrences" (+ "Positions: ...") into the same lines as the brute-force scan
+awk '
+    /^Pattern / { if (p != "") print p, c, l; p = substr($2, 2, length($2) - 3); c = $3; l = (c == 0) ? "" : "-"; next }
+    /^Positions: / && p != "" && c <= 20 { sub(/^Positions: /, ""); gsub(/,/, ""); l = $0; next }
+    /^Count queries/ { if (p != "") print p, c, l; p = "" }
+    END { if (p != "") print p, c, l }
+' "$WORK/run.log" | while read -r p c l; do
+    printf '%s %s %s\n' "$p" "$c" "$(printf '%s\n' $l | sort -n | tr '\n' ' ' | sed 's/ $//')"
+done > "$WORK/actual.txt"
+
+if diff "$WORK/expected.txt" "$WORK/actual.txt"; then
+    echo "OK: $(wc -l < "$WORK/expected.txt") patterns match the brute-force counts and positions"
+else
+    echo "FAILED: suffix_tree disagrees with the brute-force scan (< expected, > suffix_tree)"
+    exit 1
+fi
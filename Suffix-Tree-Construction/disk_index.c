@@ -0,0 +1,362 @@
+#include "disk_index.h"
+#include "input_parser.h"
+#include "input_stream.h"
+
+// IndexFileName
+void index_file_name(const char* sequence_file, char* output_filename, size_t size) {
+    snprintf(output_filename, size, "%.*s.sa",
+             (int)input_file_stem_length(sequence_file),
+             sequence_file);
+}
+
+// helper function: checksum a section of an open file, reading it back in chunks of buffer_size (a multiple of 8)
+uint64_t checksum_file(FILE* file, uint64_t offset, uint64_t size, uint8_t* buffer, size_t buffer_size) {
+    uint64_t h = 0;
+    fseek(file, (long)offset, SEEK_SET);
+    while (size > 0) {
+        size_t chunk = (size < buffer_size) ? (size_t)size : buffer_size;
+        if (fread(buffer, 1, chunk, file) != chunk) {
+            perror("Error reading back index file");
+            exit(1);
+        }
+        h = checksum_words(h, buffer, chunk);
+        size -= chunk;
+    }
+    return h;
+}
+
+// helper function: write the LCP section from the SA section of the index file (sparse Phi)
+/**
+ * One scan of the SA keeps, for every q-th suffix i in text order, the suffix before it in SA order. Their
+ * LCPs are computed in text order, each at least the previous one minus q (O(n) character comparisons
+ * in total). A second scan gets every LCP from the sampled one at or before it in text order, which it
+ * exceeds by a bounded amount: O(nq) comparisons for n / q words of memory.
+ * @sa_file: second handle on the index file, for reading the SA section
+ * @file: index file, positioned at the LCP section
+ * @phi: [n / q + 1] sampled predecessors, then their LCPs
+ * @buffer, @lcp: chunk buffers of @chunk positions
+ * @returns - 1, or 0 if the file could not be read or written
+ */
+int write_lcp_section(const char* s, TextPos n, FILE* sa_file, uint64_t sa_offset, FILE* file, TextPos q, TextPos* phi,
+                      TextPos* buffer, TextPos* lcp, size_t chunk) {
+    fseek(sa_file, (long)sa_offset, SEEK_SET);
+    TextPos prev = -1; // SA[0] is the $ suffix, the only one without a predecessor
+    for (TextPos r = 0; r < n; ) {
+        size_t count = ((size_t)(n - r) < chunk) ? (size_t)(n - r) : chunk;
+        if (fread(buffer, sizeof(TextPos), count, sa_file) != count) return 0;
+        for (size_t x = 0; x < count; x++) {
+            if (buffer[x] % q == 0) phi[buffer[x] / q] = prev;
+            prev = buffer[x];
+        }
+        r += count;
+    }
+
+    TextPos h = 0;
+    for (TextPos i = 0; i < n; i += q) {
+        TextPos j = phi[i / q];
+        if (j < 0) {
+            phi[i / q] = 0;
+            continue;
+        }
+        while (s[i + h] == s[j + h]) h++;
+        phi[i / q] = h;
+        h = (h > q) ? h - q : 0;
+    }
+
+    fseek(sa_file, (long)sa_offset, SEEK_SET);
+    prev = -1;
+    for (TextPos r = 0; r < n; ) {
+        size_t count = ((size_t)(n - r) < chunk) ? (size_t)(n - r) : chunk;
+        if (fread(buffer, sizeof(TextPos), count, sa_file) != count) return 0;
+        for (size_t x = 0; x < count; x++) {
+            TextPos i = buffer[x];
+            TextPos l = 0;
+            if (prev >= 0) {
+                TextPos sampled = i - i % q;
+                l = phi[sampled / q] - (i - sampled);
+                if (l < 0) l = 0;
+                while (s[i + l] == s[prev + l]) l++;
+            }
+            lcp[x] = l;
+            prev = i;
+        }
+        if (fwrite(lcp, sizeof(TextPos), count, file) != count) return 0;
+        r += count;
+    }
+    return 1;
+}
+
+// BuildSuffixArrayOnDisk
+int build_suffix_array_on_disk(const char* sequence_string, const char* alphabet, const char* filename, size_t mem_limit) {
+    int16_t char_rank[256];
+    build_char_rank(char_rank, sequence_string, alphabet);
+    const char* s = sequence_string;
+    size_t length = strlen(sequence_string);
+    if (length >= (size_t)POS_MAX) {
+        fprintf(stderr, "Error: Sequence is too long for this build (%zu characters); rebuild with make POS64=1\n", length);
+        return -1;
+    }
+    TextPos n = (TextPos)length;
+    int sigma = strlen(alphabet);
+
+    // k: longest prefix with at most DISK_MAX_BUCKETS keys (at least 1, at most n)
+    int k = 1;
+    long long num_keys = sigma;
+    while (k < n && num_keys * sigma <= DISK_MAX_BUCKETS) {
+        num_keys *= sigma;
+        k++;
+    }
+    int top_digit = (int)(num_keys / sigma);
+
+    // pass 1: bucket sizes ($ = 0 pads past the end, so keys of the last k - 1 suffixes are unique)
+    TextPos* bucket_start = (TextPos*)calloc(num_keys + 1, sizeof(TextPos));
+    TextPos* fill = (TextPos*)malloc(num_keys * sizeof(TextPos));
+    if (!bucket_start || !fill) {
+        perror("Could not allocate memory for prefix buckets");
+        exit(1);
+    }
+    int key = 0;
+    for (TextPos i = n - 1; i >= 0; i--) {
+        key = key / sigma + char_rank[(unsigned char)s[i]] * top_digit;
+        bucket_start[key + 1]++;
+    }
+    TextPos max_bucket = 0;
+    for (int b = 0; b < num_keys; b++) {
+        if (bucket_start[b + 1] > max_bucket) max_bucket = bucket_start[b + 1];
+        bucket_start[b + 1] += bucket_start[b];
+    }
+
+    // what a partition may use: the text, bucket tables and two I/O buffers are fixed (a buffer never needs
+    // to exceed one section), and so is the difference cover sample once built, at the shortest period that
+    // fits; each suffix costs its position and a merge sort scratch slot
+    size_t io_size = align8((size_t)n * sizeof(TextPos));
+    if (io_size > DISK_IO_BUFFER) io_size = DISK_IO_BUFFER;
+    size_t fixed = (size_t)n + (size_t)(2 * num_keys + 1) * sizeof(TextPos) + 2 * io_size;
+    size_t per_suffix = 2 * sizeof(TextPos);
+    int period = COVER_MIN_PERIOD;
+    size_t kept, needed;
+    for (;;) {
+        size_t build = cover_sample_bytes(n, period, &kept);
+        size_t sorting = kept + (size_t)max_bucket * per_suffix;
+        needed = fixed + ((build > sorting) ? build : sorting);
+        if (needed <= mem_limit || period == COVER_MAX_PERIOD) break;
+        period *= 2;
+    }
+    if (mem_limit < needed) {
+        fprintf(stderr, "Error: Memory limit of %zu MB is too small for this sequence (needs at least %zu MB)\n",
+                mem_limit / (1024 * 1024), needed / (1024 * 1024) + 1);
+        free(bucket_start);
+        free(fill);
+        return -1;
+    }
+    size_t capacity = (mem_limit - fixed - kept) / per_suffix;
+    if (capacity > (size_t)n) capacity = n;
+
+    uint8_t* buffer = (uint8_t*)malloc(io_size);
+    TextPos* lcp_buffer = (TextPos*)malloc(io_size);
+    if (!buffer || !lcp_buffer) {
+        perror("Could not allocate memory for I/O buffers");
+        exit(1);
+    }
+
+    FILE* file = fopen(filename, "w+b");
+    if (!file) {
+        perror("Error opening index file");
+        free(bucket_start);
+        free(fill);
+        free(buffer);
+        free(lcp_buffer);
+        return -1;
+    }
+
+    CoverSample* sample = build_cover_sample(s, char_rank, n, period);
+    TextPos* positions = (TextPos*)malloc(capacity * sizeof(TextPos));
+    TextPos* scratch = (TextPos*)malloc(max_bucket * sizeof(TextPos));
+    if (!positions || !scratch) {
+        perror("Could not allocate memory for partition");
+        exit(1);
+    }
+
+    IndexFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, INDEX_FILE_MAGIC, sizeof(header.magic));
+    header.version = INDEX_FILE_VERSION;
+    header.endian_check = TREE_FILE_ENDIAN_CHECK;
+    header.pos_size = sizeof(TextPos);
+    header.str_len = n;
+    header.alphabet_size = sigma;
+    header.sequence_hash = sequence_hash(sequence_string);
+    header.sa_offset = align8(sizeof(IndexFileHeader));
+    header.lcp_offset = header.sa_offset + align8((size_t)n * sizeof(TextPos));
+    header.file_size = header.lcp_offset + align8((size_t)n * sizeof(TextPos));
+
+    static const uint8_t padding[8] = {0};
+    int ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    ok = ok && fwrite(padding, 1, header.sa_offset - sizeof(header), file) == header.sa_offset - sizeof(header);
+
+    // pass 2...: one text scan per partition of consecutive buckets, written out in lexicographic order
+    int partitions = 0;
+    for (int b = 0; ok && b < num_keys; ) {
+        int b_end = b;
+        while (b_end < num_keys && (size_t)(bucket_start[b_end + 1] - bucket_start[b]) <= capacity) {
+            b_end++;
+        }
+        TextPos size = bucket_start[b_end] - bucket_start[b];
+
+        for (int bb = b; bb < b_end; bb++) {
+            fill[bb - b] = bucket_start[bb] - bucket_start[b];
+        }
+        key = 0;
+        for (TextPos i = n - 1; i >= 0; i--) {
+            key = key / sigma + char_rank[(unsigned char)s[i]] * top_digit;
+            if (key >= b && key < b_end) {
+                positions[fill[key - b]++] = i;
+            }
+        }
+
+        for (int bb = b; bb < b_end; bb++) {
+            TextPos lo = bucket_start[bb] - bucket_start[b];
+            sort_suffixes(sample, positions + lo, bucket_start[bb + 1] - bucket_start[bb], k, scratch);
+        }
+
+        ok = fwrite(positions, sizeof(TextPos), size, file) == (size_t)size;
+        partitions++;
+        b = b_end;
+    }
+    free(positions);
+    free(scratch);
+    free_cover_sample(sample);
+
+    // LCP section from the SA section as written, with every q-th suffix sampled so the samples fit the limit
+    size_t sampled_max = (mem_limit - fixed) / sizeof(TextPos) - 1;
+    TextPos q = (TextPos)(((size_t)n + sampled_max - 1) / sampled_max);
+    if (q < 1) q = 1;
+    size_t sa_padding = header.lcp_offset - header.sa_offset - (size_t)n * sizeof(TextPos);
+    ok = ok && fwrite(padding, 1, sa_padding, file) == sa_padding && fflush(file) == 0;
+    FILE* sa_file = ok ? fopen(filename, "rb") : NULL;
+    TextPos* phi = (TextPos*)malloc((n / q + 1) * sizeof(TextPos));
+    if (!phi) {
+        perror("Could not allocate memory for LCP samples");
+        exit(1);
+    }
+    ok = ok && sa_file && write_lcp_section(s, n, sa_file, header.sa_offset, file, q, phi, (TextPos*)buffer,
+                                            lcp_buffer, io_size / sizeof(TextPos));
+    if (sa_file) fclose(sa_file);
+    free(phi);
+    size_t lcp_padding = header.file_size - header.lcp_offset - (size_t)n * sizeof(TextPos);
+    ok = ok && fwrite(padding, 1, lcp_padding, file) == lcp_padding;
+
+    // checksum the file as written and fill in the header
+    if (ok && fflush(file) == 0) {
+        header.checksum = checksum_file(file, header.sa_offset, header.file_size - header.sa_offset, buffer, io_size);
+        fseek(file, 0, SEEK_SET);
+        ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    }
+
+    if (fclose(file) != 0 || !ok) {
+        perror("Error writing index file");
+        ok = 0;
+    }
+    else {
+        printf("Out-of-core construction: %d partitions of at most %zu suffixes (k = %d, cover period %d, "
+               "LCP sampling q = %lld, memory limit %zu MB)\n",
+               partitions, capacity, k, period, (long long)q, mem_limit / (1024 * 1024));
+        printf("Suffix array + LCP written to: %s (%llu bytes)\n", filename, (unsigned long long)header.file_size);
+    }
+
+    free(bucket_start);
+    free(fill);
+    free(buffer);
+    free(lcp_buffer);
+    return ok ? 0 : -1;
+}
+
+// LoadSuffixArray
+SuffixArray* load_suffix_array(const char* filename, const char* sequence_string, const char* alphabet, size_t mem_limit) {
+    FILE* file = fopen(filename, "rb");
+    if (!file) {
+        fprintf(stderr, "Index file %s could not be opened\n", filename);
+        return NULL;
+    }
+    IndexFileHeader header;
+    int has_header = fread(&header, sizeof(header), 1, file) == 1;
+    fseek(file, 0, SEEK_END);
+    size_t size = (size_t)ftell(file);
+
+    // windows share what the limit leaves after the text, the array's copy of it and the BWT pass
+    size_t n = strlen(sequence_string);
+    size_t reserved = 3 * n + BWT_BUFFER_SIZE;
+    size_t window = (mem_limit > reserved) ? (mem_limit - reserved) / (2 * sizeof(TextPos)) : 0;
+    window = window / DISK_MIN_WINDOW * DISK_MIN_WINDOW; // whole words, for the checksum
+    if (window < DISK_MIN_WINDOW) window = DISK_MIN_WINDOW;
+    if (window > align8(n)) window = align8(n);
+    TextPos* sa_buffer = (TextPos*)malloc(window * sizeof(TextPos));
+    TextPos* lcp_buffer = (TextPos*)malloc(window * sizeof(TextPos));
+    if (!sa_buffer || !lcp_buffer) {
+        perror("Could not allocate memory for index windows");
+        exit(1);
+    }
+
+    const char* reason = NULL;
+    if (!has_header || memcmp(header.magic, INDEX_FILE_MAGIC, sizeof(header.magic)) != 0) {
+        reason = "not an index file";
+    }
+    else if (header.version != INDEX_FILE_VERSION) {
+        reason = "unsupported version";
+    }
+    else if (header.endian_check != TREE_FILE_ENDIAN_CHECK) {
+        reason = "built for a different byte order";
+    }
+    else if (header.pos_size != sizeof(TextPos)) {
+        reason = "built with a different position width (32/64-bit build)";
+    }
+    else if (header.file_size != size) {
+        reason = "truncated";
+    }
+    else if (header.str_len != (int64_t)n || header.sequence_hash != sequence_hash(sequence_string)) {
+        reason = "stale (built from a different sequence)";
+    }
+    else if (header.alphabet_size != (int32_t)strlen(alphabet)) {
+        reason = "stale (built with a different alphabet)";
+    }
+    else if (header.sa_offset % 8 != 0 || header.lcp_offset % 8 != 0 ||
+             header.sa_offset < sizeof(IndexFileHeader) || header.sa_offset + n * sizeof(TextPos) > header.lcp_offset ||
+             header.lcp_offset + n * sizeof(TextPos) > size) {
+        reason = "corrupt section table";
+    }
+    else if (header.checksum != checksum_file(file, header.sa_offset, size - header.sa_offset, (uint8_t*)sa_buffer,
+                                              window * sizeof(TextPos))) {
+        reason = "checksum mismatch";
+    }
+
+    if (reason) {
+        fprintf(stderr, "Index file %s rejected: %s\n", filename, reason);
+        fclose(file);
+        free(sa_buffer);
+        free(lcp_buffer);
+        return NULL;
+    }
+
+    SuffixArray* array = (SuffixArray*)malloc(sizeof(SuffixArray));
+    if (!array) {
+        perror("Could not allocate memory for suffix array");
+        exit(1);
+    }
+    array->sequence = strdup(sequence_string);
+    array->alphabet = strdup(alphabet);
+    if (!array->sequence || !array->alphabet) {
+        perror("Could not copy sequence/alphabet into suffix array");
+        exit(1);
+    }
+    array->str_len = n;
+    array->alphabet_size = strlen(alphabet);
+    build_char_rank(array->char_rank, sequence_string, alphabet);
+    array->sa = sa_buffer;
+    array->lcp = lcp_buffer;
+    array->file = file;
+    array->sa_offset = header.sa_offset;
+    array->lcp_offset = header.lcp_offset;
+    array->file_size = size;
+    array->window = (TextPos)window;
+    return array;
+}
@@ -0,0 +1,63 @@
+#ifndef DISK_INDEX_H
+#define DISK_INDEX_H
+
+#include "types.h"
+#include "suffix_array.h"
+#include "tree_io.h"
+#include "bwt_io.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdint.h>
+
+#define INDEX_FILE_MAGIC "SAIDXLCP"
+#define INDEX_FILE_VERSION 2
+#define DISK_MAX_BUCKETS 65536 // k is the longest prefix with at most this many possible keys
+#define DISK_IO_BUFFER (1 << 20) // most bytes read or written at a time when computing LCPs or checksumming
+#define DISK_MIN_WINDOW 4096 // fewest positions read at a time from a loaded index
+
+// IndexFileName
+/**
+ * Gets the name of the on-disk index of a sequence file: <sequence file without extension>.sa
+ * @sequence_file: name of the file the sequence was read from
+ * @output_filename: buffer receiving the name
+ * @size: size of the buffer
+ */
+void index_file_name(const char* sequence_file, char* output_filename, size_t size);
+
+// BuildSuffixArrayOnDisk
+/**
+ * Builds the suffix array and LCP array of a sequence in bounded memory and writes them to an index file.
+ * Suffixes are bucketed by their first k characters (one counting pass over the text). Consecutive buckets
+ * are grouped into partitions that fit the memory limit; for each partition the text is scanned again to
+ * collect its suffixes, which are sorted against a difference cover sample (sort_suffixes, with the
+ * shortest period whose sample fits), so long repeats cost no more than short ones. Partitions are
+ * produced in lexicographic order, so the SA section is written sequentially. The LCP section is then
+ * computed from the SA section by sparse Phi (Kaerkkaeinen, Manzini & Puglisi) with every q-th suffix
+ * sampled, q as small as the memory limit allows. Only the text, the sample and one partition (or the LCP
+ * samples) are in memory at a time.
+ * @sequence_string: full sequence string (ends with $)
+ * @alphabet: alphabet the sequence is comprised of (including $)
+ * @filename: name of the index file to write
+ * @mem_limit: bytes the construction may use, including the text
+ * @returns - 0 on success, -1 if the file could not be written
+ */
+int build_suffix_array_on_disk(const char* sequence_string, const char* alphabet, const char* filename, size_t mem_limit);
+
+// LoadSuffixArray
+/**
+ * Opens an index file and returns a suffix array that reads its sa and lcp sections a window at a time
+ * (print_tree_stats_sa, compute_bwt_index_sa and find_repeats_sa scan them window by window), so the
+ * memory limit holds after construction too: the windows get what the limit leaves after the text, the
+ * array's copy of it, the BWT and its output buffer, and the checksum is computed through them as well.
+ * The file is rejected (NULL) if it is missing, corrupt (magic, version, layout or checksum), was built
+ * on a machine of the other byte order, or was built from another sequence or alphabet.
+ * @filename: name of the index file
+ * @sequence_string: sequence the caller expects the index to cover (ends with $)
+ * @alphabet: alphabet the caller expects (including $)
+ * @mem_limit: bytes the passes over the index may use, including the text
+ * @returns - suffix array released by free_suffix_array, or NULL
+ */
+SuffixArray* load_suffix_array(const char* filename, const char* sequence_string, const char* alphabet, size_t mem_limit);
+
+#endif
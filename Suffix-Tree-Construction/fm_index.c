@@ -0,0 +1,297 @@
+#include "fm_index.h"
+
+#define LOW_BITS 0x5555555555555555ULL // low bit of every 2-bit group
+
+// helper function: occurrences of 2-bit code c among the first k (<= 32) codes of a word
+int count_code(uint64_t word, int c, int k) {
+    if (k == 0) return 0;
+
+    uint64_t x = word ^ (LOW_BITS * (uint64_t)c); // groups equal to c become 00
+    uint64_t match = ~(x | (x >> 1)) & LOW_BITS;
+    if (k < 32) {
+        match &= (1ULL << (2 * k)) - 1;
+    }
+    return __builtin_popcountll(match);
+}
+
+// helper function: symbol code stored for BWT row r ($ reads as 0)
+int symbol_at(const FMIndex* fm, TextPos r) {
+    if (fm->packed) {
+        const OccBlock* block = &fm->blocks[r / FM_BLOCK_SIZE];
+        int offset = (int)(r % FM_BLOCK_SIZE);
+        return (int)((block->bits[offset / 32] >> (2 * (offset % 32))) & 3);
+    }
+    return fm->bwt_codes[r];
+}
+
+// helper function: sampled rows before row r
+TextPos sample_index(const FMIndex* fm, TextPos r) {
+    uint64_t below = fm->sampled[r / 64] & ((1ULL << (r % 64)) - 1);
+    return fm->sampled_rank[r / 64] + __builtin_popcountll(below);
+}
+
+// helper function: ascending order for qsort
+int compare_positions(const void* a, const void* b) {
+    TextPos x = *(const TextPos*)a;
+    TextPos y = *(const TextPos*)b;
+    return (x > y) - (x < y);
+}
+
+// Occ
+TextPos fm_occ(const FMIndex* fm, int c, TextPos i) {
+    TextPos b = i / FM_BLOCK_SIZE;
+    int offset = (int)(i % FM_BLOCK_SIZE);
+    TextPos count;
+
+    if (fm->packed) {
+        const OccBlock* block = &fm->blocks[b];
+        count = block->counts[c];
+        if (offset > 32) {
+            count += count_code(block->bits[0], c, 32) + count_code(block->bits[1], c, offset - 32);
+        }
+        else {
+            count += count_code(block->bits[0], c, offset);
+        }
+    }
+    else {
+        count = fm->block_counts[(size_t)b * fm->num_symbols + c];
+        for (TextPos j = b * FM_BLOCK_SIZE; j < i; j++) {
+            count += (fm->bwt_codes[j] == c);
+        }
+    }
+
+    // $ is stored as code 0 but is not an occurrence of symbol 0
+    if (c == 0 && fm->dollar_row < i) count--;
+
+    return count;
+}
+
+// LF mapping
+TextPos fm_lf(const FMIndex* fm, TextPos r) {
+    if (r == fm->dollar_row) return 0;
+
+    int c = symbol_at(fm, r);
+    return fm->C[c] + fm_occ(fm, c, r);
+}
+
+// BuildFMIndex
+FMIndex* build_fm_index(const char* bwt, const char* alphabet, int sample_rate) {
+    FMIndex* fm = (FMIndex*)calloc(1, sizeof(FMIndex));
+    if (!fm) {
+        perror("Could not allocate memory for FM-index");
+        exit(1);
+    }
+
+    TextPos n = (TextPos)strlen(bwt);
+    fm->str_len = n;
+    fm->alphabet = strdup(alphabet);
+    if (!fm->alphabet) {
+        perror("Could not copy alphabet into FM-index");
+        exit(1);
+    }
+    fm->num_symbols = strlen(alphabet) - 1;
+
+    for (int c = 0; c < 256; c++) {
+        fm->code[c] = -1;
+    }
+    for (int i = 1; alphabet[i] != '\0'; i++) {
+        fm->code[(unsigned char)alphabet[i]] = (int16_t)(i - 1);
+    }
+
+    // validate the BWT and count every symbol
+    TextPos totals[256] = {0};
+    fm->dollar_row = -1;
+    for (TextPos r = 0; r < n; r++) {
+        if (bwt[r] == '$') {
+            if (fm->dollar_row != -1) {
+                fprintf(stderr, "Error: BWT contains more than one $\n");
+                exit(1);
+            }
+            fm->dollar_row = r;
+        }
+        else if (fm->code[(unsigned char)bwt[r]] < 0) {
+            fprintf(stderr, "Error: Invalid character %c at position %lld in BWT (not in alphabet)\n", bwt[r], (long long)r);
+            exit(1);
+        }
+        else {
+            totals[fm->code[(unsigned char)bwt[r]]]++;
+        }
+    }
+    if (fm->dollar_row == -1) {
+        fprintf(stderr, "Error: BWT contains no $\n");
+        exit(1);
+    }
+
+    // C array: $ sorts before every symbol
+    fm->C[0] = 1;
+    for (int c = 1; c < fm->num_symbols; c++) {
+        fm->C[c] = fm->C[c - 1] + totals[c - 1];
+    }
+
+    // occurrence tables
+    fm->num_blocks = n / FM_BLOCK_SIZE + 1;
+    fm->packed = (fm->num_symbols <= 4);
+    TextPos running[256] = {0};
+    if (fm->packed) {
+        fm->blocks = (OccBlock*)calloc(fm->num_blocks, sizeof(OccBlock));
+        if (!fm->blocks) {
+            perror("Could not allocate memory for occurrence blocks");
+            exit(1);
+        }
+        for (TextPos r = 0; r <= n; r++) {
+            OccBlock* block = &fm->blocks[r / FM_BLOCK_SIZE];
+            int offset = (int)(r % FM_BLOCK_SIZE);
+            if (offset == 0) {
+                memcpy(block->counts, running, sizeof(block->counts));
+            }
+            if (r == n) break;
+
+            int c = (bwt[r] == '$') ? 0 : fm->code[(unsigned char)bwt[r]];
+            block->bits[offset / 32] |= (uint64_t)c << (2 * (offset % 32));
+            running[c]++;
+        }
+    }
+    else {
+        fm->bwt_codes = (uint8_t*)malloc(n * sizeof(uint8_t));
+        fm->block_counts = (TextPos*)malloc((size_t)fm->num_blocks * fm->num_symbols * sizeof(TextPos));
+        if (!fm->bwt_codes || !fm->block_counts) {
+            perror("Could not allocate memory for occurrence tables");
+            exit(1);
+        }
+        for (TextPos r = 0; r <= n; r++) {
+            if (r % FM_BLOCK_SIZE == 0) {
+                memcpy(&fm->block_counts[(size_t)(r / FM_BLOCK_SIZE) * fm->num_symbols], running,
+                       fm->num_symbols * sizeof(TextPos));
+            }
+            if (r == n) break;
+
+            int c = (bwt[r] == '$') ? 0 : fm->code[(unsigned char)bwt[r]];
+            fm->bwt_codes[r] = (uint8_t)c;
+            running[c]++;
+        }
+    }
+
+    // sampled suffix array: walk the text right to left from row 0 (suffix "$" at position n - 1)
+    fm->sample_rate = sample_rate;
+    TextPos num_samples = (n - 1) / sample_rate + 1;
+    TextPos num_words = n / 64 + 1;
+    fm->sa_samples = (TextPos*)malloc(num_samples * sizeof(TextPos));
+    fm->sampled = (uint64_t*)calloc(num_words, sizeof(uint64_t));
+    fm->sampled_rank = (TextPos*)malloc(num_words * sizeof(TextPos));
+    TextPos* rows = (TextPos*)malloc(num_samples * sizeof(TextPos)); // row of each sampled position
+    if (!fm->sa_samples || !fm->sampled || !fm->sampled_rank || !rows) {
+        perror("Could not allocate memory for suffix array samples");
+        exit(1);
+    }
+
+    TextPos r = 0;
+    for (TextPos pos = n - 1; pos >= 0; pos--) {
+        if (pos % sample_rate == 0) {
+            fm->sampled[r / 64] |= 1ULL << (r % 64);
+            rows[pos / sample_rate] = r;
+        }
+        r = fm_lf(fm, r);
+    }
+
+    TextPos cumulative = 0;
+    for (TextPos w = 0; w < num_words; w++) {
+        fm->sampled_rank[w] = cumulative;
+        cumulative += __builtin_popcountll(fm->sampled[w]);
+    }
+    for (TextPos j = 0; j < num_samples; j++) {
+        fm->sa_samples[sample_index(fm, rows[j])] = j * sample_rate;
+    }
+
+    free(rows);
+    return fm;
+}
+
+// FreeFMIndex
+void free_fm_index(FMIndex* fm) {
+    if (!fm) return;
+
+    free(fm->alphabet);
+    free(fm->blocks);
+    free(fm->bwt_codes);
+    free(fm->block_counts);
+    free(fm->sa_samples);
+    free(fm->sampled);
+    free(fm->sampled_rank);
+    free(fm);
+}
+
+// Backward search
+TextPos fm_backward_search(const FMIndex* fm, const char* pattern, TextPos* sp, TextPos* ep) {
+    TextPos start = 0;
+    TextPos end = fm->str_len;
+
+    for (TextPos i = (TextPos)strlen(pattern) - 1; i >= 0 && start < end; i--) {
+        int c = fm->code[(unsigned char)pattern[i]];
+        if (c < 0) {
+            start = end = 0; // not in the alphabet: no match
+            break;
+        }
+        start = fm->C[c] + fm_occ(fm, c, start);
+        end = fm->C[c] + fm_occ(fm, c, end);
+    }
+
+    if (start > end) start = end;
+    *sp = start;
+    *ep = end;
+    return end - start;
+}
+
+// Count
+TextPos fm_count(const FMIndex* fm, const char* pattern) {
+    TextPos sp, ep;
+    return fm_backward_search(fm, pattern, &sp, &ep);
+}
+
+// Locate
+TextPos fm_locate_row(const FMIndex* fm, TextPos r) {
+    TextPos steps = 0;
+    while (!((fm->sampled[r / 64] >> (r % 64)) & 1)) {
+        r = fm_lf(fm, r);
+        steps++;
+    }
+    return fm->sa_samples[sample_index(fm, r)] + steps;
+}
+
+TextPos* fm_locate(const FMIndex* fm, const char* pattern, TextPos* count) {
+    TextPos sp, ep;
+    *count = fm_backward_search(fm, pattern, &sp, &ep);
+    if (*count == 0) return NULL;
+
+    TextPos* positions = (TextPos*)malloc(*count * sizeof(TextPos));
+    if (!positions) {
+        perror("Could not allocate memory for pattern positions");
+        exit(1);
+    }
+    for (TextPos r = sp; r < ep; r++) {
+        positions[r - sp] = fm_locate_row(fm, r);
+    }
+    qsort(positions, *count, sizeof(TextPos), compare_positions);
+
+    return positions;
+}
+
+// reporting space used by the FM-index relative to the BWT size
+void report_fm_space_usage(const FMIndex* fm) {
+    size_t n = fm->str_len;
+    size_t occ_bytes = fm->packed
+        ? (size_t)fm->num_blocks * sizeof(OccBlock)
+        : n * sizeof(uint8_t) + (size_t)fm->num_blocks * fm->num_symbols * sizeof(TextPos);
+    size_t num_samples = (n - 1) / fm->sample_rate + 1;
+    size_t num_words = n / 64 + 1;
+    size_t sample_bytes = (num_samples + num_words) * sizeof(TextPos) + num_words * sizeof(uint64_t);
+    size_t total = occ_bytes + sample_bytes;
+
+    printf("FM-index Space Usage:\n");
+    printf("BWT length: %zu\n", n);
+    printf("Occurrence tables (%s): %zu bytes (~%.2f bytes per base)\n",
+           fm->packed ? "2-bit packed" : "byte per character", occ_bytes, (double)occ_bytes / n);
+    printf("Sampled suffix array (every %d positions): %zu bytes (~%.2f bytes per base)\n",
+           fm->sample_rate, sample_bytes, (double)sample_bytes / n);
+    printf("FM-index memory: %zu bytes (~%.2f MB, ~%.2f bytes per base)\n",
+           total, total/(1024.0*1024.0), (double)total / n);
+}
@@ -0,0 +1,72 @@
+#ifndef FM_INDEX_H
+#define FM_INDEX_H
+
+#include "types.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdint.h>
+
+#define FM_BLOCK_SIZE 64 // BWT characters per occurrence block
+#define FM_SAMPLE_RATE 32 // default spacing of sampled text positions for locate
+
+// BuildFMIndex
+/**
+ * Builds an FM-index from a BWT (e.g., the one compute_bwt_index writes).
+ * The sampled suffix array is recovered from the BWT alone: row 0 is the suffix "$" (position n - 1)
+ * and each LF step moves one position to the left in the text.
+ * @bwt: BWT string (exactly one $)
+ * @alphabet: alphabet the sequence is comprised of (including $)
+ * @sample_rate: keep the SA value of every text position divisible by this
+ * @returns - FM-index owning its tables; free_fm_index releases it
+ */
+FMIndex* build_fm_index(const char* bwt, const char* alphabet, int sample_rate);
+
+// FreeFMIndex
+void free_fm_index(FMIndex* fm);
+
+// Occ
+/**
+ * Number of occurrences of a symbol in BWT[0...i-1].
+ * @c: symbol code (alphabet index - 1)
+ * @i: row (0 <= i <= n)
+ */
+TextPos fm_occ(const FMIndex* fm, int c, TextPos i);
+
+// LF mapping
+/**
+ * Maps the row of suffix SA[r] to the row of suffix SA[r] - 1 (the $ row maps to row 0).
+ */
+TextPos fm_lf(const FMIndex* fm, TextPos r);
+
+// Backward search
+/**
+ * Finds the rows [sp, ep) of the suffixes prefixed by a pattern, one occ lookup pair per pattern character.
+ * @pattern: null-terminated pattern
+ * @sp: receives the first row of the range
+ * @ep: receives one past the last row of the range
+ * @returns - number of occurrences (ep - sp)
+ */
+TextPos fm_backward_search(const FMIndex* fm, const char* pattern, TextPos* sp, TextPos* ep);
+
+// Count
+TextPos fm_count(const FMIndex* fm, const char* pattern);
+
+// Locate
+/**
+ * Text position of a row: walks LF until a sampled row (at most sample_rate - 1 steps).
+ */
+TextPos fm_locate_row(const FMIndex* fm, TextPos r);
+
+/**
+ * Finds every text position where a pattern occurs.
+ * @pattern: null-terminated pattern
+ * @count: receives the number of occurrences
+ * @returns - positions in ascending order (NULL if none); caller frees
+ */
+TextPos* fm_locate(const FMIndex* fm, const char* pattern, TextPos* count);
+
+// reporting space used by the FM-index relative to the BWT size
+void report_fm_space_usage(const FMIndex* fm);
+
+#endif
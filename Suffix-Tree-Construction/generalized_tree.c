@@ -0,0 +1,342 @@
+#include "generalized_tree.h"
+#include "input_stream.h"
+
+// BuildGeneralizedSuffixTree
+SuffixTree* build_generalized_suffix_tree(const Sequence* records, int num_records, const char* alphabet) {
+    // concatenate the records (each already ends with its $)
+    size_t total = 0;
+    for (int j = 0; j < num_records; j++) {
+        total += strlen(records[j].sequence);
+    }
+    if (total >= (size_t)POS_MAX) {
+        fprintf(stderr, "Error: Records are too long for one tree (%zu characters)\n", total);
+        exit(1);
+    }
+    TextPos n = (TextPos)total;
+
+    char* concatenated = (char*)malloc(n + 1);
+    TextPos* record_start = (TextPos*)malloc((num_records + 1) * sizeof(TextPos));
+    char** record_names = (char**)malloc(num_records * sizeof(char*));
+    if (!concatenated || !record_start || !record_names) {
+        perror("Could not allocate memory for generalized suffix tree");
+        exit(1);
+    }
+    TextPos pos = 0;
+    for (int j = 0; j < num_records; j++) {
+        size_t len = strlen(records[j].sequence);
+        record_start[j] = pos;
+        memcpy(concatenated + pos, records[j].sequence, len);
+        pos += len;
+        record_names[j] = strdup(records[j].name ? records[j].name : "");
+        if (!record_names[j]) {
+            perror("Could not copy record name");
+            exit(1);
+        }
+    }
+    record_start[num_records] = n;
+    concatenated[n] = '\0';
+
+    SuffixTree* st = create_suffix_tree(concatenated, alphabet);
+    st->num_records = num_records;
+    st->record_start = record_start;
+    st->record_names = record_names;
+
+    NodeTable* tree = &st->nodes;
+    const char* s = concatenated; // the tree may hold the text packed
+    int sigma = st->alphabet_size;
+
+    // integer text: record j's $ is j + 1, characters follow every terminator, and a final 0 lets SA-IS run
+    TextPos* text = (TextPos*)malloc((n + 1) * sizeof(TextPos));
+    TextPos* sa = (TextPos*)malloc((n + 1) * sizeof(TextPos));
+    if (!text || !sa) {
+        perror("Could not allocate memory for generalized suffix array");
+        exit(1);
+    }
+    int record = 0;
+    for (TextPos i = 0; i < n; i++) {
+        int rank = st->char_rank[(unsigned char)s[i]];
+        text[i] = (rank == 0) ? ++record : num_records + rank;
+    }
+    text[n] = 0;
+    sa_is(text, sa, n + 1, num_records + sigma - 1, sizeof(TextPos));
+
+    // Kasai on the integer text, so terminators never match each other; sa[0] is the extra 0
+    TextPos* lcp = (TextPos*)malloc((n + 1) * sizeof(TextPos));
+    TextPos* inverse = (TextPos*)malloc((n + 1) * sizeof(TextPos));
+    if (!lcp || !inverse) {
+        perror("Could not allocate memory for generalized LCP array");
+        exit(1);
+    }
+    for (TextPos r = 0; r <= n; r++) {
+        inverse[sa[r]] = r;
+    }
+    TextPos h = 0;
+    for (TextPos i = 0; i <= n; i++) {
+        if (inverse[i] == 0) {
+            lcp[0] = 0;
+            h = 0;
+            continue;
+        }
+        TextPos j = sa[inverse[i] - 1];
+        while (text[i + h] == text[j + h]) h++;
+        lcp[inverse[i]] = h;
+        if (h > 0) h--;
+    }
+    free(inverse);
+    free(text);
+
+    // bottom-up along the rightmost path: each leaf hangs off the ancestor at its LCP with the previous leaf,
+    // splitting that ancestor's last edge when no node sits at that depth yet
+    TextPos* rep = (TextPos*)malloc(tree->internal_capacity * sizeof(TextPos)); // a leaf below each internal node
+    NodeId* stack = (NodeId*)malloc((n + 1) * sizeof(NodeId));
+    if (!rep || !stack) {
+        perror("Could not allocate memory for generalized suffix tree");
+        exit(1);
+    }
+    rep[0] = 0;
+    TextPos stack_top = 0;
+    stack[0] = tree->root;
+    NodeId prev = NO_NODE;
+
+    for (TextPos r = 1; r <= n; r++) {
+        NodeId leaf = (NodeId)sa[r];
+        TextPos depth = (r == 1) ? 0 : lcp[r];
+
+        NodeId last = prev;
+        while (node_depth(tree, stack[stack_top]) > depth) {
+            last = stack[stack_top--];
+        }
+        if (node_depth(tree, stack[stack_top]) < depth) {
+            TextPos last_rep = is_leaf(tree, last) ? (TextPos)last : rep[last - n];
+            NodeId w = create_internal_node(tree);
+            tree->depth[w - n] = depth;
+            rep[w - n] = last_rep;
+            replace_child(tree, stack[stack_top], last, w);
+            set_parent(tree, w, stack[stack_top]);
+            add_child(tree, w, st->char_rank[(unsigned char)s[last_rep + depth]], last);
+            set_parent(tree, last, w);
+            stack[++stack_top] = w;
+        }
+
+        NodeId parent = stack[stack_top];
+        add_child(tree, parent, st->char_rank[(unsigned char)s[leaf + node_depth(tree, parent)]], leaf);
+        set_parent(tree, leaf, parent);
+        prev = leaf;
+    }
+
+    for (TextPos i = 1; i < tree->internal_count; i++) {
+        tree->edge_start[i] = rep[i] + node_depth(tree, tree->parent[i]);
+    }
+
+    free(rep);
+    free(stack);
+    free(sa);
+    free(lcp);
+    free(concatenated);
+    return st;
+}
+
+// LeafRecord
+int leaf_record(const SuffixTree* st, NodeId leaf, TextPos* offset) {
+    if (st->num_records == 0) {
+        *offset = (TextPos)leaf;
+        return 0;
+    }
+
+    // last record starting at or before the leaf
+    int lo = 0;
+    int hi = st->num_records - 1;
+    while (lo < hi) {
+        int mid = (lo + hi + 1) / 2;
+        if (st->record_start[mid] <= (TextPos)leaf) {
+            lo = mid;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    *offset = (TextPos)leaf - st->record_start[lo];
+    return lo;
+}
+
+// helper function: leaf after @leaf in lexicographic order (NO_NODE after the last one)
+/**
+ * Climbs to the first ancestor-or-self with a next sibling and descends to that sibling's leftmost leaf.
+ * @lca_depth: receives the string-depth of the lowest common ancestor of the two leaves
+ */
+NodeId next_leaf(const NodeTable* tree, NodeId leaf, TextPos* lca_depth) {
+    NodeId v = leaf;
+    while (!is_root(tree, v) && next_sibling(tree, v) == NO_NODE) {
+        v = node_parent(tree, v);
+    }
+    if (is_root(tree, v)) return NO_NODE;
+
+    *lca_depth = node_depth(tree, node_parent(tree, v));
+    return leftmost_leaf(tree, next_sibling(tree, v));
+}
+
+// Per-record BWT index
+void compute_record_bwt_index(const SuffixTree* st, const char* sequence_file) {
+    const NodeTable* tree = &st->nodes;
+    TextPos n = tree->str_len;
+    int num_records = (st->num_records > 0) ? st->num_records : 1;
+
+    // every record's BWT goes to its own range, at the record's own start
+    char* BWT = (char*)malloc(n * sizeof(char));
+    TextPos* filled = (TextPos*)calloc(num_records, sizeof(TextPos));
+    if (!BWT || !filled) {
+        perror("Could not allocate memory for BWT");
+        exit(1);
+    }
+
+    TextPos lca_depth;
+    for (NodeId leaf = leftmost_leaf(tree, tree->root); leaf != NO_NODE; leaf = next_leaf(tree, leaf, &lca_depth)) {
+        TextPos offset;
+        int j = leaf_record(st, leaf, &offset);
+        TextPos start = (TextPos)leaf - offset;
+        TextPos length = (st->num_records > 0) ? st->record_start[j + 1] - start : n;
+        BWT[start + filled[j]++] = (offset == 0) ? text_char(st, start + length - 1) : text_char(st, leaf - 1);
+    }
+
+    char output_filename[256];
+    snprintf(output_filename, sizeof(output_filename), "%.*s_records_bwt.txt",
+             (int)input_file_stem_length(sequence_file),
+             sequence_file);
+
+    FILE* file = fopen(output_filename, "w");
+    if (file == NULL) {
+        perror("Error opening file");
+        free(BWT);
+        free(filled);
+        return;
+    }
+    OutputBuffer out;
+    init_output_buffer(&out, file);
+    for (int j = 0; j < num_records; j++) {
+        TextPos start = (st->num_records > 0) ? st->record_start[j] : 0;
+        const char* name = (st->num_records > 0) ? st->record_names[j] : "";
+        output_byte(&out, '>');
+        output_bytes(&out, name, strlen(name));
+        output_byte(&out, '\n');
+        for (TextPos i = 0; i < filled[j]; i++) {
+            output_byte(&out, (uint8_t)BWT[start + i]);
+            output_byte(&out, '\n');
+        }
+    }
+    if (close_output_buffer(&out) != 0) perror("Error writing per-record BWT file");
+    else printf("Per-record BWT output written to: %s\n", output_filename);
+
+    free(BWT);
+    free(filled);
+}
+
+// Repeats per record and across records
+void print_record_repeats(const SuffixTree* st) {
+    const NodeTable* tree = &st->nodes;
+    TextPos n = tree->str_len;
+    int num_records = (st->num_records > 0) ? st->num_records : 1;
+
+    // per record: rank and offset of its latest leaf, and its best pair so far
+    TextPos* last_rank = (TextPos*)malloc(num_records * sizeof(TextPos));
+    TextPos* last_offset = (TextPos*)malloc(num_records * sizeof(TextPos));
+    TextPos* best_length = (TextPos*)calloc(num_records, sizeof(TextPos));
+    TextPos* best_first = (TextPos*)malloc(num_records * sizeof(TextPos));
+    TextPos* best_second = (TextPos*)malloc(num_records * sizeof(TextPos));
+    // monotone stack: from leaf rank start[k] up to the current leaf, the smallest LCA depth is value[k]
+    TextPos* start = (TextPos*)malloc(n * sizeof(TextPos));
+    TextPos* value = (TextPos*)malloc(n * sizeof(TextPos));
+    if (!last_rank || !last_offset || !best_length || !best_first || !best_second || !start || !value) {
+        perror("Could not allocate memory for record repeats");
+        exit(1);
+    }
+    for (int j = 0; j < num_records; j++) {
+        last_rank[j] = -1;
+    }
+
+    TextPos cross_length = 0;
+    NodeId cross_first = NO_NODE;
+    NodeId cross_second = NO_NODE;
+
+    TextPos stack_top = -1;
+    TextPos rank = 0;
+    TextPos depth = 0;
+    int prev_record = -1;
+    NodeId prev = NO_NODE;
+    for (NodeId leaf = leftmost_leaf(tree, tree->root); leaf != NO_NODE; leaf = next_leaf(tree, leaf, &depth), rank++) {
+        TextPos offset;
+        int j = leaf_record(st, leaf, &offset);
+
+        if (rank > 0) {
+            TextPos merged = rank;
+            while (stack_top >= 0 && value[stack_top] >= depth) {
+                merged = start[stack_top--];
+            }
+            start[++stack_top] = merged;
+            value[stack_top] = depth;
+
+            if (j != prev_record && depth > cross_length) {
+                cross_length = depth;
+                cross_first = prev;
+                cross_second = leaf;
+            }
+        }
+
+        if (last_rank[j] >= 0) {
+            // smallest LCA depth over leaf ranks last_rank[j] + 1 ... rank
+            TextPos lo = 0;
+            TextPos hi = stack_top;
+            while (lo < hi) {
+                TextPos mid = (lo + hi + 1) / 2;
+                if (start[mid] <= last_rank[j] + 1) {
+                    lo = mid;
+                } else {
+                    hi = mid - 1;
+                }
+            }
+            if (value[lo] > best_length[j]) {
+                best_length[j] = value[lo];
+                best_first[j] = (last_offset[j] < offset) ? last_offset[j] : offset;
+                best_second[j] = (last_offset[j] < offset) ? offset : last_offset[j];
+            }
+        }
+        last_rank[j] = rank;
+        last_offset[j] = offset;
+        prev_record = j;
+        prev = leaf;
+    }
+
+    if (cross_length == 0) {
+        printf("No substring is shared between records.\n");
+    }
+    else {
+        printf("Longest substring shared across records: '");
+        for (TextPos i = 0; i < cross_length; i++) {
+            printf("%c", text_char(st, cross_first + i));
+        }
+        printf("' (length %lld)\n", (long long)cross_length);
+
+        TextPos first_offset, second_offset;
+        int first_record = leaf_record(st, cross_first, &first_offset);
+        int second_record = leaf_record(st, cross_second, &second_offset);
+        printf("Positions: %s:%lld, %s:%lld\n", st->record_names[first_record], (long long)first_offset,
+               st->record_names[second_record], (long long)second_offset);
+    }
+
+    printf("Longest repeat within each record:\n");
+    for (int j = 0; j < num_records; j++) {
+        const char* name = (st->num_records > 0) ? st->record_names[j] : "";
+        if (best_length[j] == 0) {
+            printf("%s: no repeats\n", name);
+        } else {
+            printf("%s: length %lld at %lld, %lld\n", name, (long long)best_length[j], (long long)best_first[j],
+                   (long long)best_second[j]);
+        }
+    }
+
+    free(last_rank);
+    free(last_offset);
+    free(best_length);
+    free(best_first);
+    free(best_second);
+    free(start);
+    free(value);
+}
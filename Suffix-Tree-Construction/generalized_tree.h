@@ -0,0 +1,57 @@
+#ifndef GENERALIZED_TREE_H
+#define GENERALIZED_TREE_H
+
+#include "types.h"
+#include "suffix_tree.h"
+#include "suffix_array.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdint.h>
+
+// BuildGeneralizedSuffixTree
+/**
+ * Builds one suffix tree over every record of a multi-FASTA file in a single pass.
+ * The tree's sequence is the records concatenated, each followed by its own $. Terminators are distinct:
+ * the suffixes are sorted (SA-IS) on integer ranks where record j's terminator is j + 1 and every
+ * character ranks above all terminators, so no internal node spans a record boundary and the $ of
+ * record j sorts before the $ of record j + 1. The tree is then built bottom-up from the suffix and
+ * LCP arrays along its rightmost path. With a single record it is the same tree build_suffix_tree builds.
+ * Leaves are positions in the concatenation; leaf_record turns them into (record, offset).
+ * Suffix links are not built.
+ * @records: records as read by read_fasta_records (each ends with $)
+ * @num_records: number of records
+ * @alphabet: alphabet the records are comprised of (including $)
+ * @returns - suffix tree owning its sequence and record table; free_suffix_tree releases it
+ */
+SuffixTree* build_generalized_suffix_tree(const Sequence* records, int num_records, const char* alphabet);
+
+// LeafRecord
+/**
+ * Labels a leaf (or any position of the sequence) with its record.
+ * @leaf: leaf (position in the concatenated sequence)
+ * @offset: receives the offset of the leaf inside its record
+ * @returns - record index (0 for a tree built from a single sequence)
+ */
+int leaf_record(const SuffixTree* st, NodeId leaf, TextPos* offset);
+
+// Per-record BWT index
+/**
+ * Writes the BWT of every record on its own to <sequence file>_records_bwt.txt: a ">name" line per record,
+ * then its BWT one character per line. Leaves of one record appear in the same order as in that record's
+ * own suffix tree, so each BWT is the one the record alone would give.
+ * (compute_bwt_index on the generalized tree writes the BWT across records.)
+ */
+void compute_record_bwt_index(const SuffixTree* st, const char* sequence_file);
+
+// Repeats per record and across records
+/**
+ * Reports, in one walk over the leaves in lexicographic order, the longest repeat inside every record
+ * and the longest substring shared by two different records. Two suffixes share exactly the string-depth
+ * of their lowest common ancestor, and the longest repeat among a set of leaves is always between two of
+ * them that are adjacent in leaf order, so each leaf is only compared with the previous leaf of its own
+ * record (minimum LCA depth since then, kept on a monotone stack) and with the leaf right before it.
+ */
+void print_record_repeats(const SuffixTree* st);
+
+#endif
@@ -1,115 +1,370 @@
 #include "input_parser.h"
+#include "input_stream.h"
+#include "bwt_codec.h"
 #include <stdlib.h>
 #include <string.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 void print_usage() {
-    printf("Usage: <executable> <input file containing sequence s> <input alphabet file>\n");
+    printf("Usage: <executable> <input file containing sequence s> <input alphabet file> [options]\n");
+    printf("The sequence file may be gzip or BGZF compressed (.gz/.bgz); BGZF blocks are decompressed in parallel.\n");
+    printf("It may also be a .bwz file written by --compress.\n");
+    printf("Options:\n");
+    printf("  --index tree|sa|bwt  index to build: suffix tree (McCreight, default), suffix array + LCP (SA-IS, Kasai)\n");
+    printf("                    or the BWT alone (SA-IS overwritten in place, about 6 bytes per character)\n");
+    printf("  --scaling         time construction on 1K...1M prefixes of the sequence and exit\n");
+    printf("  --pattern P       count occurrences of P with an FM-index built from the BWT (repeatable)\n");
+    printf("  --pattern-file F  same for every line of F (FASTA headers and empty lines are skipped)\n");
+    printf("  --locate          also report the positions of every pattern\n");
+    printf("  --engine fm|tree  answer patterns with the FM-index (default) or by descent on the suffix tree,\n");
+    printf("                    batched across --threads threads\n");
+    printf("  --save-tree       write the constructed tree to <sequence file>.stree\n");
+    printf("  --load-tree       map <sequence file>.stree instead of constructing (rebuilds if missing or stale)\n");
+    printf("  --online          build the tree with Ukkonen's algorithm while the FASTA file is read\n");
+    printf("  --parallel        build the tree with a pool of threads, partitioned by k-mer prefix\n");
+    printf("  --threads T       worker threads for --parallel (default: number of online cores)\n");
+    printf("  --mem-limit MB    build the suffix array + LCP out of core within MB megabytes, writing\n");
+    printf("                    <sequence file>.sa, and answer the BWT and repeat queries from that file a window\n");
+    printf("                    at a time, within the same limit\n");
+    printf("  --mine-repeats L K  write every maximal and supermaximal repeat of length >= L occurring >= K times\n");
+    printf("                    to <sequence file>_repeats.tsv (suffix tree index)\n");
+    printf("  --tandem-repeats L  write every primitive tandem array of total length >= L (start, period, copies)\n");
+    printf("                    to <sequence file>_tandems.tsv (suffix tree index)\n");
+    printf("  --generalized     build one generalized suffix tree over every record of the sequence file\n");
+    printf("                    (BWT across records and per record, repeats within and across records)\n");
+    printf("  --compress        write <sequence file>.bwz (BWT + move-to-front + run-length + rANS), check that it\n");
+    printf("                    decompresses to the sequence and compare size and speed with gzip, then exit\n");
+    printf("  --bwt-format F    BWT file format: raw (one byte per character, default), packed (2-bit codes),\n");
+    printf("                    rle (run-length) or text (one character per line, <sequence file>_bwt.txt)\n");
 }
 
 
-Sequence* read_string_sequence(const char *filename, const size_t num_seq) {
-    FILE *file = fopen(filename, "r");
-    if (!file) {
-        perror("Error opening file");
-        exit(1);
-    }
-
-    Sequence *sequences = (Sequence*)malloc(num_seq * sizeof(Sequence)); // array of sequence strings
-    size_t *allocated_sizes = (size_t*)malloc(num_seq * sizeof(size_t)); // track allocated memory for each sequence
+// helper function: map (or read) a whole file read-only; NULL for a missing or empty file
+const char* map_input_file(const char* filename, size_t* size) {
+#ifdef _WIN32
+    FILE* file = fopen(filename, "rb");
+    if (!file) return NULL;
 
-    if (!sequences || !allocated_sizes) {
-        perror("Memory allocation failed");
+    fseek(file, 0, SEEK_END);
+    long length = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    char* data = (length > 0) ? (char*)malloc(length) : NULL;
+    if (!data || fread(data, 1, length, file) != (size_t)length) {
+        free(data);
         fclose(file);
-        exit(1);
+        return NULL;
+    }
+    fclose(file);
+    *size = length;
+    return data;
+#else
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) return NULL;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+        close(fd);
+        return NULL;
     }
+    void* data = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // the mapping keeps the file alive
+    if (data == MAP_FAILED) return NULL;
+    madvise(data, info.st_size, MADV_SEQUENTIAL); // one front-to-back pass: read ahead aggressively
 
-    // init sequences
-    for (size_t i = 0; i < num_seq; i++) {
-        size_t initial_seq_size = INITIAL_MAX_SEQ_LEN * sizeof(char); // in BYTES
+    *size = info.st_size;
+    return (const char*)data;
+#endif
+}
 
-        sequences[i].name = NULL;
-        sequences[i].sequence = (char*)malloc(initial_seq_size);
-        allocated_sizes[i] = initial_seq_size;
+// helper function: release a map_input_file mapping
+void unmap_input_file(const char* data, size_t size) {
+#ifdef _WIN32
+    (void)size;
+    free((void*)data);
+#else
+    munmap((void*)data, size);
+#endif
+}
 
-        if (!sequences[i].sequence) {
-            perror("Failed to allocate sequence memory");
-            fclose(file);
+// helper function: make room for count more bytes of sequence
+void reserve_fasta_buffer(FastaParser* p, size_t count) {
+    if (p->out + count <= p->buffer_size) return;
+    if (p->fixed_buffer) {
+        fprintf(stderr, "Error: FASTA buffer overflow\n"); // cannot happen: see load_fasta
+        exit(1);
+    }
+    size_t size = p->buffer_size * 2;
+    while (size < p->out + count) size *= 2;
+    char* temp = realloc(p->buffer, size);
+    if (!temp) {
+        perror("Failed to realloc sequence");
+        exit(1);
+    }
+    p->buffer = temp;
+    p->buffer_size = size;
+}
+
+// helper function: start a record named by the header collected so far
+void open_fasta_record(FastaParser* p) {
+    if (p->count == p->capacity) {
+        p->capacity *= 2;
+        Sequence* records = realloc(p->records, p->capacity * sizeof(Sequence));
+        size_t* record_start = realloc(p->record_start, p->capacity * sizeof(size_t));
+        if (!records || !record_start) {
+            perror("Failed to realloc records");
             exit(1);
         }
+        p->records = records;
+        p->record_start = record_start;
+    }
 
-        sequences[i].sequence[0] = '\0';
+    size_t length = p->name_length;
+    if (length > 0 && p->name[length - 1] == '\r') length--;
+    char* name = (char*)malloc(length + 1);
+    if (!name) {
+        perror("Failed to allocate name memory");
+        exit(1);
     }
+    memcpy(name, p->name, length);
+    name[length] = '\0';
 
-    int curr_seq = -1; // current sequence being processed (as an index)
-    char line[600]; // buffer to hold current line being read
-    size_t line_len = 0;
-    size_t curr_len = 0;
-    size_t curr_size = 0;
-    size_t needed_size = 0;
+    p->records[p->count].name = name;
+    p->record_start[p->count] = p->out;
+    p->count++;
+    p->open_record = true;
+}
 
-    while (fgets(line, sizeof(line), file)) {
-        if (line[0] == '>') {
-            if ((curr_seq + 1) >= num_seq) {
-                // ignore extra sequences, if any
-                break; 
-            }
-            
-            curr_seq++;
+// helper function: end the current record's sequence with "$\0"
+void close_fasta_record(FastaParser* p) {
+    if (!p->open_record) return;
+    reserve_fasta_buffer(p, 2);
+    p->buffer[p->out++] = '$';
+    p->buffer[p->out++] = '\0';
+    p->open_record = false;
+}
+
+// helper function: drop the '\r' of a CRLF line end from the sequence
+void end_sequence_line(FastaParser* p) {
+    if (p->open_record && p->out > p->record_start[p->count - 1] && p->buffer[p->out - 1] == '\r') p->out--;
+}
 
-            // extract and store the sequence name
-            char *newline = strchr(line, '\n');
-            if (newline) *newline = '\0'; // remove newline with null terminator
+// helper function: parse the next chunk of a FASTA file (records, headers and lines may span chunks)
+/**
+ * Newlines are found with memchr and every sequence line is copied with one memcpy, so the cost is
+ * linear in the input size. Copied bytes are validated against the alphabet while they are still
+ * in cache.
+ */
+void parse_fasta_chunk(FastaParser* p, const char* data, size_t size) {
+    const char* end = data + size;
+    const char* pos = data;
 
-            sequences[curr_seq].name = strdup(line + 1); // skip '>' part of the header -- allocate memory for name
-            if (!sequences[curr_seq].name) {
-                perror("Failed to allocate name memory");
-                fclose(file);
-                exit(1);
-            }
-        } 
-        else if (curr_seq >= 0 && curr_seq < num_seq) {
-            // process sequence data lines
-            line_len = strlen(line); 
-            if (line_len > 0 && line[line_len - 1] == '\n') {
-                line[line_len - 1] = '\0'; // remove newline
+    while (pos < end && !p->done) {
+        if (p->at_line_start) {
+            p->at_line_start = false;
+            if (*pos == '>') {
+                close_fasta_record(p);
+                if (p->count == p->max_records) {
+                    p->done = true; // ignore extra sequences, if any
+                    break;
+                }
+                p->in_header = true;
+                p->name_length = 0;
+                pos++; // skip '>' part of the header
+                continue;
             }
+        }
 
-            curr_len = curr_len + line_len;
-            curr_size = allocated_sizes[curr_seq];
-            needed_size = (curr_len) * sizeof(char);
+        const char* newline = (const char*)memchr(pos, '\n', end - pos);
+        const char* line_end = newline ? newline : end;
+        size_t length = line_end - pos;
 
-            // realloc if buffer is too small
-            if (curr_size < needed_size) {
-                size_t new_size = needed_size * 2;
-                char *temp = realloc(sequences[curr_seq].sequence, new_size);
+        if (p->in_header) {
+            if (p->name_length + length + 1 > p->name_capacity) {
+                p->name_capacity = (p->name_length + length + 1) * 2;
+                char* temp = realloc(p->name, p->name_capacity);
                 if (!temp) {
-                    perror("Failed to realloc sequence");
-                    fclose(file);
+                    perror("Failed to allocate name memory");
                     exit(1);
                 }
-                sequences[curr_seq].sequence = temp;
-                allocated_sizes[curr_seq] = new_size;
+                p->name = temp;
+            }
+            memcpy(p->name + p->name_length, pos, length);
+            p->name_length += length;
+        }
+        else if (p->open_record) {
+            reserve_fasta_buffer(p, length);
+            char* dest = p->buffer + p->out;
+            memcpy(dest, pos, length);
+
+            // OR of the table lookups: no branch per character, the position is only searched on failure
+            uint8_t bad = 0;
+            for (size_t k = 0; k < length; k++) {
+                bad |= p->invalid[(unsigned char)dest[k]];
+            }
+            if (bad) {
+                size_t k = 0;
+                while (!p->invalid[(unsigned char)dest[k]]) k++;
+                fprintf(stderr, "Error: Invalid character %c at position %lld in sequence (not in alphabet)\n",
+                        dest[k], (long long)(p->out + k - p->record_start[p->count - 1]));
+                exit(1);
             }
+            p->out += length;
+        }
 
-            strcat(sequences[curr_seq].sequence, line);
+        if (!newline) break;
+        if (p->in_header) {
+            open_fasta_record(p);
+            p->in_header = false;
+        } else {
+            end_sequence_line(p);
         }
+        p->at_line_start = true;
+        pos = newline + 1;
     }
-    size_t seq_len = strlen(sequences[curr_seq].sequence);
-    
-    // ensure space for '$' and null terminator
-    char *temp = realloc(sequences[curr_seq].sequence, seq_len + 2);
-    if (!temp) {
-        perror("Failed to realloc for $ addition of sequence string");
+}
+
+// helper function: load the single record of a compressed sequence file (see write_codec_file)
+Sequence* load_codec_file(const char* filename, const char* alphabet, int* num_records, size_t* input_size) {
+    Sequence* records = (Sequence*)malloc(sizeof(Sequence));
+    if (!records) {
+        perror("Memory allocation failed");
         exit(1);
     }
-    sequences[curr_seq].sequence = temp;
-    sequences[curr_seq].sequence[seq_len] = '$';
-    sequences[curr_seq].sequence[seq_len + 1] = '\0';
+    records[0].sequence = read_codec_file(filename, &records[0].name, 0);
 
-    free(allocated_sizes);
-    fclose(file);
-    
-    return sequences;
+    size_t length = strlen(records[0].sequence);
+    if (alphabet) {
+        uint8_t invalid[256];
+        memset(invalid, 1, sizeof(invalid));
+        for (int i = 0; alphabet[i] != '\0'; i++) {
+            if (alphabet[i] != '$') invalid[(unsigned char)alphabet[i]] = 0;
+        }
+        for (size_t k = 0; k + 1 < length; k++) {
+            if (invalid[(unsigned char)records[0].sequence[k]]) {
+                fprintf(stderr, "Error: Invalid character %c at position %lld in sequence (not in alphabet)\n",
+                        records[0].sequence[k], (long long)k);
+                exit(1);
+            }
+        }
+    }
+
+    *num_records = 1;
+    if (input_size) *input_size = length;
+    return records;
+}
+
+// helper function: parse up to max_records FASTA records into one buffer
+/**
+ * Plain files are mapped and parsed as a single chunk into a buffer of file size + 2 bytes, allocated
+ * once: each record drops at least its '>' and header newline, which leaves room for its "$\0" (the
+ * last record may lack the newline, hence the extra byte). gzip/BGZF files are parsed block by block
+ * as they are decompressed, into a buffer that grows from an estimate. records[0].sequence owns the buffer.
+ * Compressed sequence files (.bwz) are decoded instead; they hold one record.
+ */
+Sequence* load_fasta(const char* filename, const char* alphabet, size_t max_records, int* num_records,
+                     size_t* input_size) {
+    size_t size = 0;
+    const char* data = map_input_file(filename, &size);
+    if (!data) {
+        fprintf(stderr, "Error opening file %s (missing or empty)\n", filename);
+        exit(1);
+    }
+    if (size >= 8 && memcmp(data, CODEC_FILE_MAGIC, 8) == 0) {
+        unmap_input_file(data, size);
+        return load_codec_file(filename, alphabet, num_records, input_size);
+    }
+    bool compressed = size >= 2 && (unsigned char)data[0] == 0x1f && (unsigned char)data[1] == 0x8b;
+
+    FastaParser parser;
+    FastaParser* p = &parser;
+    memset(p, 0, sizeof(*p));
+    memset(p->invalid, alphabet ? 1 : 0, sizeof(p->invalid));
+    for (int i = 0; alphabet && alphabet[i] != '\0'; i++) {
+        if (alphabet[i] != '$') p->invalid[(unsigned char)alphabet[i]] = 0; // $ only terminates records
+    }
+    p->invalid['\r'] = 0; // stripped at line ends (anywhere else, the builders reject it)
+    p->capacity = INITIAL_MAX_SEQ_LEN;
+    p->max_records = max_records;
+    p->records = (Sequence*)malloc(p->capacity * sizeof(Sequence));
+    p->record_start = (size_t*)malloc(p->capacity * sizeof(size_t));
+    p->buffer_size = compressed ? size * 4 : size + 2; // DNA compresses about 4:1
+    p->fixed_buffer = !compressed;
+    p->buffer = (char*)malloc(p->buffer_size);
+    p->at_line_start = true;
+    if (!p->records || !p->record_start || !p->buffer) {
+        perror("Memory allocation failed");
+        exit(1);
+    }
+
+    size_t parsed = 0;
+    if (!compressed) {
+        parse_fasta_chunk(p, data, size);
+        parsed = size;
+        unmap_input_file(data, size);
+    } else {
+        unmap_input_file(data, size);
+        InputStream* in = open_input_stream(filename, 0);
+        char* chunk = (char*)malloc(FASTA_CHUNK_SIZE);
+        if (!in || !chunk) {
+            perror("Error opening compressed file");
+            exit(1);
+        }
+        size_t got;
+        while (!p->done && (got = read_input_stream(in, chunk, FASTA_CHUNK_SIZE)) > 0) {
+            parse_fasta_chunk(p, chunk, got);
+            parsed += got;
+        }
+        free(chunk);
+        if (close_input_stream(in) != 0 && !p->done) {
+            fprintf(stderr, "Error: %s is corrupt or truncated\n", filename);
+            exit(1);
+        }
+    }
+
+    // the last line may lack its newline
+    if (p->in_header) open_fasta_record(p);
+    else end_sequence_line(p);
+    close_fasta_record(p);
+    free(p->name);
+
+    if (p->count == 0) {
+        fprintf(stderr, "Error: No FASTA records in %s\n", filename);
+        exit(1);
+    }
+
+    // sequences are placed once the buffer has stopped moving
+    for (size_t j = 0; j < p->count; j++) {
+        p->records[j].sequence = p->buffer + p->record_start[j];
+    }
+    free(p->record_start);
+
+    *num_records = (int)p->count;
+    if (input_size) *input_size = parsed;
+    return p->records;
+}
+
+Sequence* read_string_sequence(const char *filename, const size_t num_seq, const char* alphabet, size_t* input_size) {
+    int count = 0;
+    return load_fasta(filename, alphabet, num_seq, &count, input_size);
+}
+
+// Read every record of a FASTA file
+Sequence* read_fasta_records(const char* filename, const char* alphabet, int* num_records) {
+    return load_fasta(filename, alphabet, (size_t)-1, num_records, NULL);
+}
+
+// Free records returned by read_string_sequence or read_fasta_records
+void free_sequences(Sequence* records, int num_records) {
+    for (int j = 0; j < num_records; j++) {
+        free(records[j].name);
+    }
+    free(records[0].sequence); // every sequence lives in this one buffer
+    free(records);
 }
 
 // Get alphabet from a file
@@ -156,3 +411,72 @@ char* read_alphabet(const char* filename) {
 
     return alpha_arr;
 }
+
+// Read query patterns from a file
+char** read_patterns(const char* filename, int* num_patterns) {
+    InputStream* file = open_input_stream(filename, 1);
+    if (!file) {
+        perror("Error opening pattern file");
+        exit(1);
+    }
+
+    int capacity = INITIAL_MAX_SEQ_LEN;
+    char** patterns = (char**)malloc(capacity * sizeof(char*));
+    if (!patterns) {
+        perror("Could not allocate memory for patterns");
+        close_input_stream(file);
+        exit(1);
+    }
+
+    *num_patterns = 0;
+    char* line = NULL; // whole lines: a long pattern is one query, not several
+    size_t line_capacity = 0;
+    while (input_stream_getline(&line, &line_capacity, file) > 0) {
+        line[strcspn(line, "\r\n")] = '\0';
+        if (line[0] == '\0' || line[0] == '>') continue;
+
+        if (*num_patterns == capacity) {
+            capacity *= 2;
+            char** temp = realloc(patterns, capacity * sizeof(char*));
+            if (!temp) {
+                perror("Failed to realloc patterns");
+                close_input_stream(file);
+                exit(1);
+            }
+            patterns = temp;
+        }
+
+        patterns[*num_patterns] = strdup(line);
+        if (!patterns[*num_patterns]) {
+            perror("Failed to allocate pattern memory");
+            close_input_stream(file);
+            exit(1);
+        }
+        (*num_patterns)++;
+    }
+    free(line);
+
+    if (close_input_stream(file) != 0) {
+        fprintf(stderr, "Error: pattern file %s is corrupt or truncated\n", filename);
+        exit(1);
+    }
+    return patterns;
+}
+
+// Character ranks
+void build_char_rank(int16_t char_rank[256], const char* sequence_string, const char* alphabet) {
+    for (int c = 0; c < 256; c++) {
+        char_rank[c] = -1;
+    }
+    for (int i = 0; alphabet[i] != '\0'; i++) {
+        char_rank[(unsigned char)alphabet[i]] = (int16_t)i;
+    }
+
+    for (TextPos i = 0; sequence_string[i] != '\0'; i++) {
+        if (char_rank[(unsigned char)sequence_string[i]] < 0) {
+            fprintf(stderr, "Error: Invalid character %c at position %lld in sequence (not in alphabet)\n", 
+                    sequence_string[i], (long long)i);
+            exit(1);
+        }
+    }
+}
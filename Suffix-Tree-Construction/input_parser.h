@@ -8,6 +8,7 @@
 
 #define INITIAL_MAX_SEQ_LEN 10
 #define MAX_ALPHABET_SIZE 256
+#define FASTA_CHUNK_SIZE (1 << 20) // decompressed bytes parsed at a time from a gzip/BGZF file
 
 // Prints command prompt guide for inputting params
 void print_usage();
@@ -19,8 +20,35 @@ void print_usage();
  * Whatever follows the first whitespace character after the identifier is a don't care and can be ignored in your program. 
  * The header line is followed by the actual string sequence.
  * The sequence can span multiple lines and each line can variable number of characters (but no whitespaces or any other special characters).
+ *
+ * The file is memory-mapped and scanned once: lines are split with memchr and copied into one buffer
+ * sized from the file length, and every character is checked against the alphabet on the way (exits
+ * on the first one that is not in it). gzip and BGZF files (.gz/.bgz, recognized by their magic bytes)
+ * are decompressed while they are parsed, BGZF blocks in parallel (see open_input_stream).
+ * Compressed sequence files written by write_codec_file (.bwz) are decoded and hold one record.
+ * @filename: name of the FASTA file
+ * @num_seq: number of records to read (extra records are ignored)
+ * @alphabet: alphabet the sequences are comprised of (including $), NULL to skip validation
+ * @input_size: receives the number of FASTA bytes parsed, after decompression (for throughput reporting), may be NULL
+ * @returns - array of records, each sequence ending with $; release with free_sequences
  */
-Sequence* read_string_sequence(const char *filename, const size_t num_seq);
+Sequence* read_string_sequence(const char *filename, const size_t num_seq, const char* alphabet, size_t* input_size);
+
+// Read every record of a FASTA file
+/**
+ * Same format and loader as read_string_sequence, but reads all records instead of a fixed number.
+ * @filename: name of the FASTA file
+ * @alphabet: alphabet the sequences are comprised of (including $), NULL to skip validation
+ * @num_records: receives the number of records read
+ * @returns - array of records, each sequence ending with its own $; release with free_sequences
+ */
+Sequence* read_fasta_records(const char* filename, const char* alphabet, int* num_records);
+
+// Free records returned by read_string_sequence or read_fasta_records
+/**
+ * The sequences share one buffer, so they must not be freed one by one.
+ */
+void free_sequences(Sequence* records, int num_records);
 
 // Get alphabet from a file
 /*
@@ -28,4 +56,25 @@ Sequence* read_string_sequence(const char *filename, const size_t num_seq);
 */
 char* read_alphabet(const char* filename);
 
+// Read query patterns from a file
+/**
+ * Reads one pattern per line, however long; empty lines and FASTA header lines (starting with '>') are
+ * skipped. The file may be gzip or BGZF compressed.
+ * @filename: name of the pattern file
+ * @num_patterns: receives the number of patterns read
+ * @returns - array of null-terminated patterns
+ */
+char** read_patterns(const char* filename, int* num_patterns);
+
+// Character ranks
+/**
+ * Fills a 256-entry table mapping every byte value to its index in the alphabet (-1 if not in it)
+ * and validates that every character of the sequence is in the alphabet (exits otherwise).
+ * Ranks follow the sorted alphabet, so comparing ranks compares characters lexicographically.
+ * @char_rank: table to fill
+ * @sequence_string: full sequence string (ends with $)
+ * @alphabet: alphabet the sequence is comprised of (including $)
+ */
+void build_char_rank(int16_t char_rank[256], const char* sequence_string, const char* alphabet);
+
 #endif
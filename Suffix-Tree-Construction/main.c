@@ -1,54 +1,793 @@
 #include "input_parser.h"
 #include "suffix_tree.h"
+#include "suffix_array.h"
+#include "fm_index.h"
+#include "tree_io.h"
+#include "ukkonen.h"
+#include "parallel_tree.h"
+#include "disk_index.h"
+#include "generalized_tree.h"
+#include "tree_query.h"
+#include "repeat_mining.h"
+#include "tandem_repeats.h"
+#include "bwt_codec.h"
+#include "input_stream.h"
+#include <zlib.h>
 #include <time.h>
+#ifndef _WIN32
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
 
 #define NUM_SEQ_STRINGS ((size_t)1)
+#define SCALING_MIN_SECONDS 0.05 // repeat small builds until timings are measurable
+
+#define MAX_PRINTED_POSITIONS 20 // positions listed per located pattern
+
+// helper function: wall-clock seconds (clock() adds up the CPU time of every thread)
+double wall_seconds() {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// helper function: default worker count for --parallel
+int default_threads() {
+#ifndef _WIN32
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    return (cores > 0) ? (int)cores : 1;
+#else
+    return 4;
+#endif
+}
+
+// Engine answering --pattern queries
+typedef enum {
+    ENGINE_FM, // FM-index built from the BWT file
+    ENGINE_TREE // descent on the suffix tree, batched across threads
+} QueryEngine;
+
+// Index built over the sequence
+typedef enum {
+    INDEX_TREE, // suffix tree (McCreight)
+    INDEX_SA, // suffix array (SA-IS) + LCP array (Kasai)
+    INDEX_BWT // BWT only (SA-IS overwritten in place), for sequences too large for a tree
+} IndexType;
+
+// Peak resident set size of the process in KB (0 where getrusage is unavailable)
+long peak_rss_kb() {
+#ifdef _WIN32
+    return 0;
+#else
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+#endif
+}
+
+// Scaling benchmark
+/**
+ * Builds indexes over prefixes of the sequence (1K, 10K, 100K, 1M characters, each re-terminated with $)
+ * and reports construction time per character. For a linear-time builder the per-character time
+ * should stay roughly flat as the prefix grows.
+ */
+void run_scaling_benchmark(const char* seq_str, const char* alphabet, IndexType index) {
+    TextPos seq_len = (TextPos)strlen(seq_str) - 1; // excluding $
+    char* prefix = (char*)malloc(seq_len + 2);
+    if (!prefix) {
+        perror("Could not allocate memory for benchmark prefix");
+        exit(1);
+    }
+
+    printf("Construction scaling (linear => flat ns/char):\n");
+    printf("%10s %8s %12s %10s %8s\n", "prefix", "builds", "seconds", "ns/char", "ratio");
+
+    double first_ns_per_char = 0.0;
+    for (TextPos prefix_len = 1000; ; prefix_len *= 10) {
+        if (prefix_len > seq_len) prefix_len = seq_len;
+
+        memcpy(prefix, seq_str, prefix_len);
+        prefix[prefix_len] = '$';
+        prefix[prefix_len + 1] = '\0';
+
+        int builds = 0;
+        double elapsed = 0.0;
+        while (elapsed < SCALING_MIN_SECONDS) {
+            clock_t start = clock();
+            if (index == INDEX_SA) {
+                SuffixArray* array = build_suffix_array(prefix, alphabet);
+                elapsed += (double)(clock() - start) / CLOCKS_PER_SEC;
+                free_suffix_array(array);
+            }
+            else if (index == INDEX_BWT) {
+                char* bwt = build_bwt_direct(prefix, alphabet);
+                elapsed += (double)(clock() - start) / CLOCKS_PER_SEC;
+                free(bwt);
+            }
+            else {
+                SuffixTree* st = build_suffix_tree(prefix, alphabet, false);
+                elapsed += (double)(clock() - start) / CLOCKS_PER_SEC;
+                free_suffix_tree(st);
+            }
+            builds++;
+        }
+
+        double seconds = elapsed / builds;
+        double ns_per_char = seconds * 1e9 / (prefix_len + 1);
+        if (first_ns_per_char == 0.0) first_ns_per_char = ns_per_char;
+        printf("%10lld %8d %12.6f %10.1f %8.2f\n", (long long)prefix_len + 1, builds, seconds, ns_per_char, ns_per_char / first_ns_per_char);
+
+        if (prefix_len == seq_len || prefix_len >= 1000000) break;
+    }
+
+    free(prefix);
+}
+
+// helper function: size of a file in bytes (-1 if it cannot be opened)
+long long file_size_bytes(const char* filename) {
+    FILE* file = fopen(filename, "rb");
+    if (!file) return -1;
+    fseek(file, 0, SEEK_END);
+    long long size = ftell(file);
+    fclose(file);
+    return size;
+}
+
+// helper function: gzip a plain file at level 6 (gzip's default); returns 0, or -1 on failure
+int gzip_file(const char* filename, const char* gz_filename) {
+    FILE* file = fopen(filename, "rb");
+    gzFile gz = gzopen(gz_filename, "wb6");
+    char* chunk = (char*)malloc(FASTA_CHUNK_SIZE);
+    if (!file || !gz || !chunk) {
+        if (file) fclose(file);
+        if (gz) gzclose(gz);
+        free(chunk);
+        return -1;
+    }
+    int status = 0;
+    size_t got;
+    while ((got = fread(chunk, 1, FASTA_CHUNK_SIZE, file)) > 0) {
+        if (gzwrite(gz, chunk, (unsigned)got) != (int)got) status = -1;
+    }
+    free(chunk);
+    fclose(file);
+    if (gzclose(gz) != Z_OK) status = -1;
+    return status;
+}
+
+// Compression benchmark
+/**
+ * Writes <sequence file>.bwz (direct BWT, then write_codec_file), loads it back through the sequence
+ * loader and checks that it decodes to the sequence, then does the same with gzip: the FASTA file is
+ * gzipped at level 6 into a temporary file of its own (mkstemp, <sequence file>.XXXXXX, so no existing
+ * file is touched) and loaded through the gzip path (a gzip input is used as it is). Sizes are compared
+ * with the FASTA bytes, load times are what a run pays to read the sequence back.
+ */
+void run_codec_benchmark(const char* sequence_file, const char* seq_name, const char* seq_str, const char* alphabet,
+                         size_t fasta_size) {
+    TextPos n = (TextPos)strlen(seq_str);
+    char codec_file[256];
+    codec_file_name(sequence_file, codec_file, sizeof(codec_file));
+
+    double start = wall_seconds();
+    char* bwt = build_bwt_direct(seq_str, alphabet);
+    if (write_codec_file(codec_file, seq_name, bwt, n) != 0) {
+        perror("Error writing compressed file");
+        exit(1);
+    }
+    double codec_compress = wall_seconds() - start;
+    free(bwt);
+    long long codec_size = file_size_bytes(codec_file);
+
+    start = wall_seconds();
+    Sequence* decoded = read_string_sequence(codec_file, NUM_SEQ_STRINGS, alphabet, NULL);
+    double codec_load = wall_seconds() - start;
+    if (strcmp(decoded[0].sequence, seq_str) != 0 || strcmp(decoded[0].name, seq_name) != 0) {
+        fprintf(stderr, "Error: %s does not decompress to the sequence\n", codec_file);
+        exit(1);
+    }
+    free_sequences(decoded, 1);
+
+    // gzip baseline
+    bool gzip_input = is_compressed_file(sequence_file);
+    char gz_file[256];
+    double gzip_compress = -1.0;
+    if (gzip_input) {
+        snprintf(gz_file, sizeof(gz_file), "%s", sequence_file);
+    } else if (!is_codec_file(sequence_file)) {
+        // a fresh file of our own, so no existing <sequence file>.gz is overwritten and then removed
+#ifndef _WIN32
+        snprintf(gz_file, sizeof(gz_file), "%s.XXXXXX", sequence_file);
+        int fd = mkstemp(gz_file);
+        if (fd < 0) {
+            perror("Error creating temporary gzip file");
+            exit(1);
+        }
+        close(fd);
+#else
+        if (!tmpnam(gz_file)) {
+            perror("Error creating temporary gzip file");
+            exit(1);
+        }
+#endif
+        start = wall_seconds();
+        if (gzip_file(sequence_file, gz_file) != 0) {
+            perror("Error writing gzip file");
+            remove(gz_file);
+            exit(1);
+        }
+        gzip_compress = wall_seconds() - start;
+    } else {
+        gz_file[0] = '\0'; // no FASTA file to gzip
+    }
+    long long gzip_size = -1;
+    double gzip_load = 0.0;
+    if (gz_file[0] != '\0') {
+        gzip_size = file_size_bytes(gz_file);
+        start = wall_seconds();
+        Sequence* loaded = read_string_sequence(gz_file, NUM_SEQ_STRINGS, alphabet, NULL);
+        gzip_load = wall_seconds() - start;
+        free_sequences(loaded, 1);
+        if (!gzip_input) remove(gz_file);
+    }
+
+    double megabytes = n / (1024.0 * 1024.0);
+    printf("Compression (%lld characters, %zu FASTA bytes):\n", (long long)n, fasta_size);
+    printf("%-10s %12s %10s %8s %12s %12s %12s\n", "format", "bytes", "bits/char", "ratio", "compress s", "load s", "load MB/s");
+    if (gzip_size >= 0) {
+        printf("%-10s %12lld %10.3f %8.2f ", "gzip -6", gzip_size, 8.0 * gzip_size / n, (double)fasta_size / gzip_size);
+        if (gzip_compress >= 0) printf("%12.4f ", gzip_compress);
+        else printf("%12s ", "-");
+        printf("%12.4f %12.1f\n", gzip_load, (gzip_load > 0) ? megabytes / gzip_load : 0.0);
+    }
+    printf("%-10s %12lld %10.3f %8.2f %12.4f %12.4f %12.1f\n", "bwz", codec_size, 8.0 * codec_size / n,
+           (double)fasta_size / codec_size, codec_compress, codec_load, (codec_load > 0) ? megabytes / codec_load : 0.0);
+    printf("Compressed output written to: %s (decompression verified)\n", codec_file);
+}
+
+// Pattern queries
+/**
+ * Builds an FM-index from the BWT file just written for the sequence and answers
+ * count (and optionally locate) queries for every pattern. Count throughput is timed
+ * separately by repeating the whole batch until it is measurable.
+ */
+void run_pattern_queries(const char* sequence_file, BwtFormat bwt_format, const char* alphabet, char** patterns,
+                         int num_patterns, bool locate) {
+    char bwt_filename[256];
+    bwt_file_name(sequence_file, bwt_format, bwt_filename, sizeof(bwt_filename));
+    FILE* packed = (bwt_format == BWT_FORMAT_PACKED) ? fopen(bwt_filename, "rb") : NULL;
+    if (packed) fclose(packed);
+    else if (bwt_format == BWT_FORMAT_PACKED) {
+        bwt_file_name(sequence_file, BWT_FORMAT_RAW, bwt_filename, sizeof(bwt_filename)); // packing did not pay
+    }
+    char* bwt = read_bwt_file(bwt_filename);
+
+    clock_t start = clock();
+    FMIndex* fm = build_fm_index(bwt, alphabet, FM_SAMPLE_RATE);
+    double build_time = (double)(clock() - start) / CLOCKS_PER_SEC;
+    free(bwt);
+
+    printf("FM-index Construction Time (from %s): %.4f seconds\n", bwt_filename, build_time);
+    report_fm_space_usage(fm);
+    printf("**************************************************\n");
+
+    for (int p = 0; p < num_patterns; p++) {
+        if (!locate) {
+            printf("Pattern '%s': %lld occurrences\n", patterns[p], (long long)fm_count(fm, patterns[p]));
+            continue;
+        }
+
+        TextPos count = 0;
+        TextPos* positions = fm_locate(fm, patterns[p], &count);
+        printf("Pattern '%s': %lld occurrences\n", patterns[p], (long long)count);
+        if (count > 0) {
+            printf("Positions: ");
+            for (TextPos i = 0; i < count && i < MAX_PRINTED_POSITIONS; i++) {
+                printf("%lld", (long long)positions[i]);
+                if (i < count - 1) printf(", ");
+            }
+            if (count > MAX_PRINTED_POSITIONS) printf("... (%lld more)", (long long)count - MAX_PRINTED_POSITIONS);
+            printf("\n");
+        }
+        free(positions);
+    }
+
+    // count throughput
+    long long queries = 0;
+    long long total_hits = 0;
+    double elapsed = 0.0;
+    while (elapsed < SCALING_MIN_SECONDS) {
+        start = clock();
+        for (int p = 0; p < num_patterns; p++) {
+            total_hits += fm_count(fm, patterns[p]);
+        }
+        elapsed += (double)(clock() - start) / CLOCKS_PER_SEC;
+        queries += num_patterns;
+    }
+    printf("Count queries: %lld in %.4f seconds (%.1f ns/query, %lld hits)\n",
+           queries, elapsed, elapsed * 1e9 / queries, total_hits);
+
+    free_fm_index(fm);
+}
+
+// Tree pattern queries
+/**
+ * Answers count (and optionally locate) queries for every pattern directly on the suffix tree:
+ * O(m) descent to the pattern's locus, then a walk over the leaves below it. The batch runs on a
+ * pool of threads sharing the read-only tree; throughput is the whole batch repeated until measurable.
+ */
+void run_tree_queries(const SuffixTree* st, char** patterns, int num_patterns, bool locate, int num_threads) {
+    TextPos* counts = (TextPos*)malloc(num_patterns * sizeof(TextPos));
+    TextPos** positions = locate ? (TextPos**)malloc(num_patterns * sizeof(TextPos*)) : NULL;
+    if (!counts || (locate && !positions)) {
+        perror("Could not allocate memory for query results");
+        exit(1);
+    }
+
+    match_patterns(st, patterns, num_patterns, locate, num_threads, counts, positions);
+    for (int p = 0; p < num_patterns; p++) {
+        printf("Pattern '%s': %lld occurrences\n", patterns[p], (long long)counts[p]);
+        if (locate && counts[p] > 0) {
+            printf("Positions: ");
+            for (TextPos i = 0; i < counts[p] && i < MAX_PRINTED_POSITIONS; i++) {
+                printf("%lld", (long long)positions[p][i]);
+                if (i < counts[p] - 1) printf(", ");
+            }
+            if (counts[p] > MAX_PRINTED_POSITIONS) printf("... (%lld more)", (long long)counts[p] - MAX_PRINTED_POSITIONS);
+            printf("\n");
+        }
+        if (locate) free(positions[p]);
+    }
+
+    // throughput
+    long long queries = 0;
+    long long total_hits = 0;
+    double elapsed = 0.0;
+    while (elapsed < SCALING_MIN_SECONDS) {
+        double start = wall_seconds();
+        match_patterns(st, patterns, num_patterns, false, num_threads, counts, NULL);
+        elapsed += wall_seconds() - start;
+        queries += num_patterns;
+        for (int p = 0; p < num_patterns; p++) {
+            total_hits += counts[p];
+        }
+    }
+    printf("Tree queries: %lld in %.4f seconds on %d threads (%.0f queries/s, %lld hits)\n",
+           queries, elapsed, num_threads, queries / elapsed, total_hits);
+
+    free(counts);
+    free(positions);
+}
+
+// Repeat mining
+/**
+ * Streams every maximal and supermaximal repeat of length >= min_length occurring >= min_count times
+ * to <sequence file>_repeats.tsv in one bottom-up pass, and reports how many were found.
+ */
+void run_repeat_mining(const SuffixTree* st, const char* sequence_file, int min_length, int min_count) {
+    char repeats_filename[256];
+    repeats_file_name(sequence_file, repeats_filename, sizeof(repeats_filename));
+
+    long long maximal = 0;
+    long long supermaximal = 0;
+    clock_t start = clock();
+    if (mine_repeats(st, min_length, min_count, repeats_filename, &maximal, &supermaximal) != 0) {
+        return;
+    }
+    double mining_time = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    printf("Repeats (length >= %d, count >= %d): %lld maximal, %lld supermaximal\n",
+           min_length, min_count, maximal, supermaximal);
+    printf("Repeat Mining Time: %.4f seconds\n", mining_time);
+    printf("Repeats written to: %s\n", repeats_filename);
+}
+
+// Tandem repeats
+/**
+ * Writes every primitive tandem array of total length >= min_length to <sequence file>_tandems.tsv.
+ */
+void run_tandem_repeats(const SuffixTree* st, const char* sequence_file, int min_length) {
+    char tandems_filename[256];
+    tandems_file_name(sequence_file, tandems_filename, sizeof(tandems_filename));
+
+    long long tandems = 0;
+    clock_t start = clock();
+    if (find_tandem_repeats(st, min_length, tandems_filename, &tandems) != 0) {
+        return;
+    }
+    double search_time = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    printf("Tandem repeats (length >= %d): %lld primitive tandem arrays\n", min_length, tandems);
+    printf("Tandem Repeat Search Time: %.4f seconds\n", search_time);
+    printf("Tandem repeats written to: %s\n", tandems_filename);
+}
+
+// Generalized suffix tree
+/**
+ * Builds one tree over every record of the sequence file and reports the BWT (across records and
+ * per record), the tree statistics and the longest repeats within and across records.
+ */
+void run_generalized(const char* sequence_file, const char* alphabet_file, BwtFormat bwt_format) {
+    char* alphabet = read_alphabet(alphabet_file);
+    int num_records = 0;
+    Sequence* records = read_fasta_records(sequence_file, alphabet, &num_records);
+    size_t total_length = 0;
+    for (int j = 0; j < num_records; j++) {
+        total_length += strlen(records[j].sequence);
+    }
+    printf("Sequence Records: %d (%zu characters with terminators)\n", num_records, total_length);
+
+    printf("Alphabet File: %s\n", alphabet_file);
+    puts(alphabet);
+    printf("**************************************************\n");
+
+    clock_t start = clock();
+    SuffixTree* st = build_generalized_suffix_tree(records, num_records, alphabet);
+    clock_t end = clock();
+    double construction_time = (double)(end - start) / CLOCKS_PER_SEC;
+    printf("Generalized Suffix Tree Construction Time: %.4f seconds\n", construction_time);
+    printf("Peak RSS: %ld KB\n", peak_rss_kb());
+    printf("**************************************************\n");
+
+    free_sequences(records, num_records);
+
+    report_space_usage(st);
+    printf("**************************************************\n");
+
+    compute_bwt_index(st, sequence_file, bwt_format);
+    compute_record_bwt_index(st, sequence_file);
+    printf("**************************************************\n");
+
+    print_tree_stats(st);
+    printf("**************************************************\n");
+
+    print_record_repeats(st);
+
+    free_suffix_tree(st);
+    free(alphabet);
+}
 
 int main(int argc, char* argv[]) {
-    // <executable> <input file containing sequence s> <input alphabet file>
-    // if (argc < 4) {
-    //     print_usage();
-    //     return 1;
-    // }
+    // <executable> [input file containing sequence s] [input alphabet file] [--index tree|sa|bwt] [--scaling]
+    //              [--pattern P]... [--pattern-file F] [--locate] [--save-tree] [--load-tree] [--online]
+    //              [--parallel] [--threads T] [--mem-limit MB] [--generalized]
+    //              [--engine fm|tree] [--mine-repeats L K] [--tandem-repeats L] [--bwt-format F] [--compress]
+    char *sequence_file = "chr12.fas";
+    char *alphabet_file = "DNA_alphabet.txt";
+    bool run_scaling = false;
+    bool compress = false;
+    IndexType index = INDEX_TREE;
+    char** patterns = NULL;
+    int num_patterns = 0;
+    bool locate = false;
+    bool save_tree = false;
+    bool load_tree = false;
+    bool online = false;
+    bool parallel = false;
+    int num_threads = 0;
+    size_t mem_limit = 0; // bytes, 0 = build in memory
+    bool generalized = false;
+    BwtFormat bwt_format = BWT_DEFAULT_FORMAT;
+    QueryEngine engine = ENGINE_FM;
+    int repeat_min_length = 0; // 0 = do not mine repeats
+    int repeat_min_count = 0;
+    int tandem_min_length = 0; // 0 = do not search for tandem repeats
+    int positional = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--scaling") == 0) {
+            run_scaling = true;
+        } else if (strcmp(argv[i], "--compress") == 0) {
+            compress = true;
+        } else if (strcmp(argv[i], "--index") == 0 && i + 1 < argc) {
+            i++;
+            if (strcmp(argv[i], "tree") == 0) {
+                index = INDEX_TREE;
+            } else if (strcmp(argv[i], "sa") == 0) {
+                index = INDEX_SA;
+            } else if (strcmp(argv[i], "bwt") == 0) {
+                index = INDEX_BWT;
+            } else {
+                print_usage();
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--pattern") == 0 && i + 1 < argc) {
+            patterns = realloc(patterns, (num_patterns + 1) * sizeof(char*));
+            if (!patterns) {
+                perror("Failed to realloc patterns");
+                exit(1);
+            }
+            patterns[num_patterns++] = argv[++i];
+        } else if (strcmp(argv[i], "--pattern-file") == 0 && i + 1 < argc) {
+            int file_patterns = 0;
+            char** from_file = read_patterns(argv[++i], &file_patterns);
+            patterns = realloc(patterns, (num_patterns + file_patterns) * sizeof(char*));
+            if (!patterns && num_patterns + file_patterns > 0) {
+                perror("Failed to realloc patterns");
+                exit(1);
+            }
+            memcpy(patterns + num_patterns, from_file, file_patterns * sizeof(char*));
+            num_patterns += file_patterns;
+            free(from_file);
+        } else if (strcmp(argv[i], "--locate") == 0) {
+            locate = true;
+        } else if (strcmp(argv[i], "--save-tree") == 0) {
+            save_tree = true;
+        } else if (strcmp(argv[i], "--load-tree") == 0) {
+            load_tree = true;
+        } else if (strcmp(argv[i], "--online") == 0) {
+            online = true;
+        } else if (strcmp(argv[i], "--parallel") == 0) {
+            parallel = true;
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            num_threads = atoi(argv[++i]);
+            if (num_threads < 1) {
+                fprintf(stderr, "Error: --threads must be at least 1\n");
+                exit(1);
+            }
+        } else if (strcmp(argv[i], "--engine") == 0 && i + 1 < argc) {
+            i++;
+            if (strcmp(argv[i], "fm") == 0) {
+                engine = ENGINE_FM;
+            } else if (strcmp(argv[i], "tree") == 0) {
+                engine = ENGINE_TREE;
+            } else {
+                print_usage();
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--mine-repeats") == 0 && i + 2 < argc) {
+            repeat_min_length = atoi(argv[++i]);
+            repeat_min_count = atoi(argv[++i]);
+            if (repeat_min_length < 1 || repeat_min_count < 2) {
+                fprintf(stderr, "Error: --mine-repeats needs a length of at least 1 and a count of at least 2\n");
+                exit(1);
+            }
+        } else if (strcmp(argv[i], "--tandem-repeats") == 0 && i + 1 < argc) {
+            tandem_min_length = atoi(argv[++i]);
+            if (tandem_min_length < 2) {
+                fprintf(stderr, "Error: --tandem-repeats needs a length of at least 2\n");
+                exit(1);
+            }
+        } else if (strcmp(argv[i], "--generalized") == 0) {
+            generalized = true;
+        } else if (strcmp(argv[i], "--bwt-format") == 0 && i + 1 < argc) {
+            if (parse_bwt_format(argv[++i], &bwt_format) != 0) {
+                fprintf(stderr, "Error: --bwt-format must be text, raw, packed or rle\n");
+                exit(1);
+            }
+        } else if (strcmp(argv[i], "--mem-limit") == 0 && i + 1 < argc) {
+            long megabytes = atol(argv[++i]);
+            if (megabytes < 1) {
+                fprintf(stderr, "Error: --mem-limit must be at least 1 (MB)\n");
+                exit(1);
+            }
+            mem_limit = (size_t)megabytes * 1024 * 1024;
+        } else if (strncmp(argv[i], "--", 2) == 0) {
+            print_usage();
+            return 1;
+        } else if (positional == 0) {
+            sequence_file = argv[i];
+            positional++;
+        } else if (positional == 1) {
+            alphabet_file = argv[i];
+            positional++;
+        }
+    }
+
+    if (generalized) {
+        run_generalized(sequence_file, alphabet_file, bwt_format);
+        return 0;
+    }
+
+    // get alphabet file (first: the sequence is validated against it while it is read)
+    const char* alphabet = read_alphabet(alphabet_file);
 
     // get sequence file
-    char *sequence_file = (argc > 1) ? argv[1] : "chr12.fas";
-    Sequence* sequence = read_string_sequence(sequence_file, NUM_SEQ_STRINGS);
+    size_t input_size = 0;
+    double load_start = wall_seconds();
+    Sequence* sequence = read_string_sequence(sequence_file, NUM_SEQ_STRINGS, alphabet, &input_size);
+    double load_time = wall_seconds() - load_start;
     const char* seq_name = sequence[0].name;
     const char* seq_str = sequence[0].sequence;
     printf("Sequence Name: %s\n", seq_name);
+    printf("FASTA Load Time: %.4f seconds (%.1f MB/s)\n", load_time,
+           (load_time > 0) ? input_size / (1024.0 * 1024.0) / load_time : 0.0);
 
-    // get alphabet file
-    char *alphabet_file = (argc > 2) ? argv[2] : "DNA_alphabet.txt";
     printf("Alphabet File: %s\n", alphabet_file);
-    const char* alphabet = read_alphabet(alphabet_file);
     puts(alphabet);
     printf("**************************************************\n");
-    
-    clock_t start = clock();
-    Node* root = build_suffix_tree(seq_str, alphabet, false);
-    clock_t end = clock();
-    double construction_time = (double)(end - start) / CLOCKS_PER_SEC;
-    printf("Suffix Tree Construction Time: %.4f seconds\n", construction_time);
+
+    if (run_scaling) {
+        run_scaling_benchmark(seq_str, alphabet, index);
+        return 0;
+    }
+
+    if (compress) {
+        run_codec_benchmark(sequence_file, seq_name, seq_str, alphabet, input_size);
+        return 0;
+    }
+
+    if (index == INDEX_BWT && mem_limit == 0) {
+        clock_t start = clock();
+        char* bwt = build_bwt_direct(seq_str, alphabet);
+        clock_t end = clock();
+        double construction_time = (double)(end - start) / CLOCKS_PER_SEC;
+        TextPos n = (TextPos)strlen(bwt);
+        printf("BWT Construction Time (direct, SA-IS): %.4f seconds\n", construction_time);
+        printf("Peak RSS: %ld KB\n", peak_rss_kb());
+        printf("**************************************************\n");
+
+        write_bwt_file(sequence_file, bwt, n, bwt_format);
+        free(bwt);
+
+        if (repeat_min_length > 0 || tandem_min_length > 0) {
+            printf("Repeat mining and tandem repeats need the suffix tree; skipped for --index bwt\n");
+        }
+        if (num_patterns > 0) {
+            printf("**************************************************\n");
+            if (engine == ENGINE_TREE) {
+                printf("The tree query engine needs the suffix tree; answering with the FM-index\n");
+            }
+            run_pattern_queries(sequence_file, bwt_format, alphabet, patterns, num_patterns, locate);
+        }
+
+        return 0;
+    }
+
+    if (index == INDEX_SA || mem_limit > 0) {
+        SuffixArray* array;
+        clock_t start = clock();
+        if (mem_limit > 0) {
+            // out-of-core: the index is built in partitions on disk, then mapped for the queries
+            char index_file[FILENAME_MAX];
+            index_file_name(sequence_file, index_file, sizeof(index_file));
+            if (build_suffix_array_on_disk(seq_str, alphabet, index_file, mem_limit) != 0) {
+                exit(1);
+            }
+            clock_t end = clock();
+            double construction_time = (double)(end - start) / CLOCKS_PER_SEC;
+            printf("Suffix Array + LCP Construction Time (out-of-core): %.4f seconds\n", construction_time);
+            printf("Peak RSS during construction: %ld KB\n", peak_rss_kb());
+
+            array = load_suffix_array(index_file, seq_str, alphabet, mem_limit);
+            if (!array) {
+                exit(1);
+            }
+        }
+        else {
+            array = build_suffix_array(seq_str, alphabet);
+            clock_t end = clock();
+            double construction_time = (double)(end - start) / CLOCKS_PER_SEC;
+            printf("Suffix Array + LCP Construction Time: %.4f seconds\n", construction_time);
+        }
+        printf("Peak RSS: %ld KB\n", peak_rss_kb());
+        printf("**************************************************\n");
+
+        report_space_usage_sa(array);
+        printf("**************************************************\n");
+
+        compute_bwt_index_sa(array, sequence_file, bwt_format);
+        printf("**************************************************\n");
+
+        // stats
+        print_tree_stats_sa(array);
+        printf("**************************************************\n");
+
+        // Find longest repeats
+        LongestRepeat repeats = find_repeats_sa(array);
+        print_repeats(&repeats, seq_str);
+
+        // Clean up
+        free(repeats.positions);
+        free_suffix_array(array);
+
+        if (num_patterns > 0) {
+            printf("**************************************************\n");
+            if (engine == ENGINE_TREE) {
+                printf("The tree query engine needs the suffix tree; answering with the FM-index\n");
+            }
+            run_pattern_queries(sequence_file, bwt_format, alphabet, patterns, num_patterns, locate);
+        }
+
+        return 0;
+    }
+
+    char tree_file[256];
+    tree_file_name(sequence_file, tree_file, sizeof(tree_file));
+
+    // reuse a saved tree if it matches the sequence, otherwise construct it
+    SuffixTree* st = NULL;
+    if (load_tree) {
+        clock_t start = clock();
+        st = load_suffix_tree(tree_file, seq_str, alphabet);
+        clock_t end = clock();
+        if (st) {
+            double load_time = (double)(end - start) / CLOCKS_PER_SEC;
+            printf("Suffix Tree Load Time (mapped %s): %.4f seconds\n", tree_file, load_time);
+        }
+    }
+
+    if (!st && online) {
+        // Ukkonen: the tree grows while the FASTA file is parsed, so the time includes reading it
+        clock_t start = clock();
+        st = build_suffix_tree_online(sequence_file, alphabet);
+        clock_t end = clock();
+        double construction_time = (double)(end - start) / CLOCKS_PER_SEC;
+        printf("Suffix Tree Construction Time (online Ukkonen, including FASTA parsing): %.4f seconds\n", construction_time);
+
+        if (save_tree) {
+            save_suffix_tree(st, tree_file);
+        }
+    }
+    else if (!st && parallel) {
+        if (num_threads == 0) num_threads = default_threads();
+        double start = wall_seconds();
+        st = build_suffix_tree_parallel(seq_str, alphabet, num_threads);
+        double construction_time = wall_seconds() - start;
+        printf("Suffix Tree Construction Time (parallel, %d threads): %.4f seconds\n", num_threads, construction_time);
+
+        if (save_tree) {
+            save_suffix_tree(st, tree_file);
+        }
+    }
+    else if (!st) {
+        clock_t start = clock();
+        st = build_suffix_tree(seq_str, alphabet, false);
+        clock_t end = clock();
+        double construction_time = (double)(end - start) / CLOCKS_PER_SEC;
+        printf("Suffix Tree Construction Time: %.4f seconds\n", construction_time);
+
+        if (save_tree) {
+            save_suffix_tree(st, tree_file);
+        }
+    }
+
+    // number the leaves once so counts and positions below any node are O(1) slices
+    clock_t annotate_start = clock();
+    annotate_leaf_intervals(st);
+    double annotate_time = (double)(clock() - annotate_start) / CLOCKS_PER_SEC;
+    printf("Leaf Interval Annotation Time: %.4f seconds\n", annotate_time);
+    printf("Peak RSS: %ld KB\n", peak_rss_kb());
     printf("**************************************************\n");
 
-    report_space_usage(root, seq_str, alphabet);
+    report_space_usage(st);
     printf("**************************************************\n");
 
-    //dfs_enumerate(root, seq_str, alphabet);
-    compute_bwt_index(root, sequence_file, seq_str, alphabet);
+    //dfs_enumerate(st, st->nodes.root);
+    compute_bwt_index(st, sequence_file, bwt_format);
     printf("**************************************************\n");
 
     // stats
-    print_tree_stats(root, seq_str, alphabet, strlen(seq_str), 0);
+    print_tree_stats(st);
     printf("**************************************************\n");
 
     // Find longest repeats
-    LongestRepeat repeats = find_repeats(root, seq_str, alphabet);
+    LongestRepeat repeats = find_repeats(st);
     print_repeats(&repeats, seq_str);
+
+    if (repeat_min_length > 0) {
+        printf("**************************************************\n");
+        run_repeat_mining(st, sequence_file, repeat_min_length, repeat_min_count);
+    }
+
+    if (tandem_min_length > 0) {
+        printf("**************************************************\n");
+        run_tandem_repeats(st, sequence_file, tandem_min_length);
+    }
     
+    if (num_patterns > 0 && engine == ENGINE_TREE) {
+        printf("**************************************************\n");
+        run_tree_queries(st, patterns, num_patterns, locate, (num_threads > 0) ? num_threads : default_threads());
+    }
+
     // Clean up
     free(repeats.positions);    
+    free_suffix_tree(st);
+
+    if (num_patterns > 0 && engine == ENGINE_FM) {
+        printf("**************************************************\n");
+        run_pattern_queries(sequence_file, bwt_format, alphabet, patterns, num_patterns, locate);
+    }
 
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,70 @@
+#include "packed_text.h"
+
+// PackText
+bool pack_text(PackedText* text, const char* sequence_string, const char* alphabet, const int16_t char_rank[256]) {
+    memset(text, 0, sizeof(PackedText));
+
+    // $ plus A, C, G, T (and optionally N) in sorted order
+    if (strcmp(alphabet, "$ACGT") != 0 && strcmp(alphabet, "$ACGNT") != 0) return false;
+    TextPos n = (TextPos)strlen(sequence_string);
+    if (n == 0 || sequence_string[n - 1] != '$' || memchr(sequence_string, '$', n - 1)) return false;
+
+    const char* bases = "ACGT";
+    for (int c = 0; c < 4; c++) {
+        text->code_rank[c] = (uint8_t)char_rank[(unsigned char)bases[c]];
+    }
+    text->n_rank = char_rank['N'];
+
+    size_t num_words = (size_t)(n + 31) / 32 + 1;
+    text->words = (uint64_t*)calloc(num_words, sizeof(uint64_t));
+    if (!text->words) {
+        perror("Could not allocate memory for packed text");
+        exit(1);
+    }
+
+    // code of every byte: A, C, G, T -> 0...3, N and $ -> 0
+    uint8_t code[256] = {0};
+    code['C'] = 1;
+    code['G'] = 2;
+    code['T'] = 3;
+
+    for (TextPos i = 0; i < n - 1; i++) {
+        unsigned char c = (unsigned char)sequence_string[i];
+        text->words[i >> 5] |= (uint64_t)code[c] << ((i & 31) * 2);
+
+        if (c == 'N') {
+            if (!text->n_mask) {
+                text->n_mask = (uint64_t*)calloc((size_t)n / 64 + 2, sizeof(uint64_t));
+                if (!text->n_mask) {
+                    perror("Could not allocate memory for packed text");
+                    exit(1);
+                }
+            }
+            text->n_mask[i >> 6] |= (uint64_t)1 << (i & 63);
+        }
+    }
+    text->length = n;
+
+    return true;
+}
+
+void release_packed_text(PackedText* text) {
+    free(text->words);
+    free(text->n_mask);
+    text->words = NULL;
+    text->n_mask = NULL;
+}
+
+// UnpackText
+void unpack_text(const PackedText* text, const char* alphabet, char* output) {
+    for (TextPos i = 0; i < text->length; i++) {
+        output[i] = alphabet[packed_rank(text, i)];
+    }
+    output[text->length] = '\0';
+}
+
+size_t packed_text_bytes(const PackedText* text) {
+    size_t bytes = ((size_t)(text->length + 31) / 32 + 1) * sizeof(uint64_t);
+    if (text->n_mask) bytes += ((size_t)text->length / 64 + 2) * sizeof(uint64_t);
+    return bytes;
+}
@@ -0,0 +1,83 @@
+#ifndef PACKED_TEXT_H
+#define PACKED_TEXT_H
+
+#include "types.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdint.h>
+
+// PackText
+/**
+ * Packs a DNA sequence 2 bits per base. Only alphabets of exactly A, C, G, T (optionally N) plus $
+ * qualify, and $ must be the last character only (so generalized concatenations stay unpacked).
+ * @text: packed text to fill (text->words stays NULL if the sequence does not qualify)
+ * @sequence_string: full sequence string (ends with $), already validated against the alphabet
+ * @alphabet: alphabet the sequence is comprised of (including $)
+ * @char_rank: rank table of the alphabet
+ * @returns - true if the text was packed
+ */
+bool pack_text(PackedText* text, const char* sequence_string, const char* alphabet, const int16_t char_rank[256]);
+
+// frees the packed words (no-op for a text that was not packed)
+void release_packed_text(PackedText* text);
+
+// UnpackText
+/**
+ * Decodes a packed text back to characters.
+ * @output: buffer of at least text->length + 1 bytes, receives the null-terminated sequence string
+ */
+void unpack_text(const PackedText* text, const char* alphabet, char* output);
+
+// bytes held by the packed text
+size_t packed_text_bytes(const PackedText* text);
+
+// 32 codes starting at position i (codes past the end read as 0)
+static inline uint64_t packed_codes(const PackedText* text, TextPos i) {
+    TextPos w = i >> 5;
+    int shift = (int)(i & 31) * 2;
+    uint64_t codes = text->words[w] >> shift;
+    if (shift) codes |= text->words[w + 1] << (64 - shift);
+    return codes;
+}
+
+// 32 N bits starting at position i
+static inline uint32_t packed_n_bits(const PackedText* text, TextPos i) {
+    TextPos w = i >> 6;
+    int shift = (int)(i & 63);
+    uint64_t bits = text->n_mask[w] >> shift;
+    if (shift) bits |= text->n_mask[w + 1] << (64 - shift);
+    return (uint32_t)bits;
+}
+
+// alphabet index (child branch) of the character at position i: a shift and a mask, no table of bytes
+static inline int packed_rank(const PackedText* text, TextPos i) {
+    if (i == text->length - 1) return 0; // $
+    if (text->n_mask && (text->n_mask[i >> 6] >> (i & 63) & 1)) return text->n_rank;
+    return text->code_rank[(text->words[i >> 5] >> ((i & 31) * 2)) & 3];
+}
+
+// PackedMatchLength
+/**
+ * Length of the common prefix of the texts at positions a and b, at most @max, 32 bases per step:
+ * the first differing base is the lowest set bit pair of the XOR of the two code words (or the lowest
+ * differing N bit). $ is unique, so a common prefix never reaches it: @max is clipped before it.
+ */
+static inline TextPos packed_match_length(const PackedText* text, TextPos a, TextPos b, TextPos max) {
+    if (a == b) return max;
+    TextPos last = (a > b) ? a : b;
+    if (max > text->length - 1 - last) max = text->length - 1 - last;
+
+    for (TextPos k = 0; k < max; k += 32) {
+        uint64_t diff = packed_codes(text, a + k) ^ packed_codes(text, b + k);
+        int first = diff ? __builtin_ctzll(diff) >> 1 : 32;
+        if (text->n_mask) {
+            uint32_t n_diff = packed_n_bits(text, a + k) ^ packed_n_bits(text, b + k);
+            if (n_diff && __builtin_ctz(n_diff) < first) first = __builtin_ctz(n_diff);
+        }
+        if (first < 32) return (k + first < max) ? k + first : max;
+    }
+    return max;
+}
+
+#endif
@@ -0,0 +1,565 @@
+#include "parallel_tree.h"
+
+// helper functions: private references (SUBTREE_LEAF | suffix index, or private internal node number)
+bool sub_is_leaf(NodeId node) {
+    return node != NO_NODE && (node & SUBTREE_LEAF);
+}
+
+NodeId sub_next_sibling(const ParallelWorker* w, NodeId node) {
+    return sub_is_leaf(node) ? w->tree->leaf_next_sibling[node & ~SUBTREE_LEAF] : w->nodes.next_sibling[node];
+}
+
+void sub_set_next_sibling(ParallelWorker* w, NodeId node, NodeId sibling) {
+    if (sub_is_leaf(node)) {
+        w->tree->leaf_next_sibling[node & ~SUBTREE_LEAF] = sibling;
+    } else {
+        w->nodes.next_sibling[node] = sibling;
+    }
+}
+
+// links a child under a private internal node; children arrive in lexicographic order, so it goes after the tail
+void sub_add_child(ParallelWorker* w, NodeId node, int branch, NodeId child) {
+    if (sub_is_leaf(child)) {
+        w->tree->leaf_parent[child & ~SUBTREE_LEAF] = node;
+        w->tree->leaf_branch[child & ~SUBTREE_LEAF] = (uint8_t)branch;
+    } else {
+        w->nodes.parent[child] = node;
+        w->nodes.branch[child] = (uint8_t)branch;
+    }
+    sub_set_next_sibling(w, child, NO_NODE);
+
+    if (w->nodes.first_child[node] == NO_NODE) {
+        w->nodes.first_child[node] = child;
+    } else {
+        sub_set_next_sibling(w, w->nodes.last_child[node], child);
+    }
+    w->nodes.last_child[node] = child;
+    w->nodes.child_count[node]++;
+}
+
+// puts a private internal node in place of a child (same branch, same position among the siblings)
+void sub_replace_child(ParallelWorker* w, NodeId node, NodeId old_child, NodeId new_child) {
+    w->nodes.parent[new_child] = node;
+    w->nodes.branch[new_child] = sub_is_leaf(old_child) ? w->tree->leaf_branch[old_child & ~SUBTREE_LEAF]
+                                                        : w->nodes.branch[old_child];
+    w->nodes.next_sibling[new_child] = sub_next_sibling(w, old_child);
+
+    if (w->nodes.first_child[node] == old_child) {
+        w->nodes.first_child[node] = new_child;
+    } else {
+        NodeId prev = w->nodes.first_child[node];
+        while (sub_next_sibling(w, prev) != old_child) {
+            prev = sub_next_sibling(w, prev);
+        }
+        sub_set_next_sibling(w, prev, new_child);
+    }
+    if (w->nodes.last_child[node] == old_child) {
+        w->nodes.last_child[node] = new_child;
+    }
+}
+
+// hands out the next private internal node, growing the worker's table as needed
+NodeId sub_create_node(ParallelWorker* w, TextPos depth, TextPos rep) {
+    SubtreeTable* t = &w->nodes;
+    if (t->count >= t->capacity) {
+        TextPos new_capacity = (t->capacity > 0) ? t->capacity * 2 : 1024;
+        t->depth = realloc(t->depth, new_capacity * sizeof(TextPos));
+        t->rep = realloc(t->rep, new_capacity * sizeof(TextPos));
+        t->parent = realloc(t->parent, new_capacity * sizeof(NodeId));
+        t->first_child = realloc(t->first_child, new_capacity * sizeof(NodeId));
+        t->last_child = realloc(t->last_child, new_capacity * sizeof(NodeId));
+        t->next_sibling = realloc(t->next_sibling, new_capacity * sizeof(NodeId));
+        t->branch = realloc(t->branch, new_capacity * sizeof(uint8_t));
+        t->child_count = realloc(t->child_count, new_capacity * sizeof(uint32_t));
+        if (!t->depth || !t->rep || !t->parent || !t->first_child || !t->last_child || !t->next_sibling || !t->branch || !t->child_count) {
+            perror("Could not grow worker node table");
+            exit(1);
+        }
+        t->capacity = new_capacity;
+    }
+
+    NodeId i = (NodeId)t->count++;
+    t->depth[i] = depth;
+    t->rep[i] = rep;
+    t->parent[i] = NO_NODE;
+    t->first_child[i] = NO_NODE;
+    t->last_child[i] = NO_NODE;
+    t->next_sibling[i] = NO_NODE;
+    t->branch[i] = 0;
+    t->child_count[i] = 0;
+    return i;
+}
+
+// helper function: size of the largest bucket
+TextPos largest_bucket(const ParallelWorker* w) {
+    TextPos max_bucket = 0;
+    for (int b = 0; b < w->num_buckets; b++) {
+        TextPos size = w->bucket_start[b + 1] - w->bucket_start[b];
+        if (size > max_bucket) max_bucket = size;
+    }
+    return max_bucket;
+}
+
+// helper function: text or suffix array range of a worker in the phases split statically (LCP)
+void worker_range(const ParallelWorker* w, TextPos n, TextPos* lo, TextPos* hi) {
+    *lo = (TextPos)((long long)n * w->id / w->num_threads);
+    *hi = (TextPos)((long long)n * (w->id + 1) / w->num_threads);
+}
+
+// phase 0a: claim buckets until none are left, sort their sampled suffixes by v-prefix and name them from 1
+void* sort_sample_worker(void* arg) {
+    ParallelWorker* w = (ParallelWorker*)arg;
+    TextPos largest = 0;
+    for (int b = 0; b < w->num_buckets; b++) {
+        TextPos size = w->sample_start[b + 1] - w->sample_start[b];
+        if (size > largest) largest = size;
+    }
+    TextPos* scratch = (TextPos*)malloc((largest / 2 + 1) * sizeof(TextPos));
+    if (!scratch) {
+        perror("Could not allocate worker buffers");
+        exit(1);
+    }
+
+    for (;;) {
+        int b = __atomic_fetch_add(w->next_bucket, 1, __ATOMIC_RELAXED);
+        if (b >= w->num_buckets) break;
+        TextPos* pos = w->sample_positions + w->sample_start[b];
+        TextPos count = w->sample_start[b + 1] - w->sample_start[b];
+        sort_sample_prefixes(w->sample, pos, count, w->prefix_len, scratch);
+        w->sample_names[b] = name_sample_prefixes(w->sample, pos, count, w->prefix_len, w->names);
+    }
+
+    free(scratch);
+    return NULL;
+}
+
+// phase 0b: claim buckets until none are left and shift their names past the names of the buckets before them
+void* offset_sample_worker(void* arg) {
+    ParallelWorker* w = (ParallelWorker*)arg;
+    for (;;) {
+        int b = __atomic_fetch_add(w->next_bucket, 1, __ATOMIC_RELAXED);
+        if (b >= w->num_buckets) break;
+        TextPos offset = w->sample_names[b];
+        if (offset == 0) continue;
+        for (TextPos p = w->sample_start[b]; p < w->sample_start[b + 1]; p++) {
+            w->names[sample_slot(w->sample, w->sample_positions[p])] += offset;
+        }
+    }
+
+    return NULL;
+}
+
+// phase 1: claim buckets until none are left and sort their suffixes
+void* sort_buckets_worker(void* arg) {
+    ParallelWorker* w = (ParallelWorker*)arg;
+    TextPos* scratch = (TextPos*)malloc((largest_bucket(w) + 1) * sizeof(TextPos));
+    if (!scratch) {
+        perror("Could not allocate worker buffers");
+        exit(1);
+    }
+
+    for (;;) {
+        int b = __atomic_fetch_add(w->next_bucket, 1, __ATOMIC_RELAXED);
+        if (b >= w->num_buckets) break;
+        sort_suffixes(w->sample, w->positions + w->bucket_start[b], w->bucket_start[b + 1] - w->bucket_start[b],
+                      w->prefix_len, scratch);
+    }
+
+    free(scratch);
+    return NULL;
+}
+
+// phase 2a: inverse suffix array over this worker's range of positions
+void* lcp_rank_worker(void* arg) {
+    ParallelWorker* w = (ParallelWorker*)arg;
+    TextPos lo, hi;
+    worker_range(w, w->tree->str_len, &lo, &hi);
+    for (TextPos r = lo; r < hi; r++) {
+        w->rank[w->positions[r]] = r;
+    }
+    return NULL;
+}
+
+// phase 2b: Kasai over this worker's range of text positions
+void* lcp_worker(void* arg) {
+    ParallelWorker* w = (ParallelWorker*)arg;
+    TextPos n = w->tree->str_len;
+    TextPos lo, hi;
+    worker_range(w, n, &lo, &hi);
+    kasai_lcp_range(w->sequence, w->positions, w->rank, w->lcp, n, lo, hi);
+    return NULL;
+}
+
+// BuildBucket
+/**
+ * Builds the subtree of one bucket bottom-up from its sorted suffixes and their LCPs, as
+ * build_generalized_suffix_tree does for the whole tree: each leaf hangs off the node on the rightmost
+ * path at its LCP with the previous leaf, which splits the last edge when no node sits at that depth yet.
+ * @w: worker building the bucket
+ * @lo, @hi: range of the bucket in positions (already sorted)
+ * @returns - private reference of the bucket's subtree root
+ */
+NodeId build_bucket(ParallelWorker* w, TextPos lo, TextPos hi) {
+    const char* s = w->sequence;
+    const int16_t* rank = w->char_rank;
+    const TextPos* pos = w->positions;
+    const TextPos* lcp = w->lcp;
+
+    if (hi - lo == 1) {
+        w->tree->leaf_parent[pos[lo]] = NO_NODE;
+        w->tree->leaf_next_sibling[pos[lo]] = NO_NODE;
+        return SUBTREE_LEAF | (NodeId)pos[lo];
+    }
+
+    // the root sits at the smallest LCP inside the bucket
+    TextPos root_depth = lcp[lo + 1];
+    for (TextPos r = lo + 2; r < hi; r++) {
+        if (lcp[r] < root_depth) root_depth = lcp[r];
+    }
+    NodeId root = sub_create_node(w, root_depth, pos[lo]);
+
+    NodeId* stack = w->stack;
+    TextPos top = 0;
+    stack[0] = root;
+    NodeId prev = NO_NODE;
+
+    for (TextPos r = lo; r < hi; r++) {
+        TextPos depth = (r == lo) ? root_depth : lcp[r];
+
+        NodeId last = prev;
+        while (w->nodes.depth[stack[top]] > depth) {
+            last = stack[top--];
+        }
+        if (w->nodes.depth[stack[top]] < depth) {
+            TextPos last_rep = sub_is_leaf(last) ? (TextPos)(last & ~SUBTREE_LEAF) : w->nodes.rep[last];
+            NodeId x = sub_create_node(w, depth, last_rep);
+            sub_replace_child(w, stack[top], last, x);
+            sub_add_child(w, x, rank[(unsigned char)s[last_rep + depth]], last);
+            stack[++top] = x;
+        }
+
+        NodeId parent = stack[top];
+        NodeId leaf = SUBTREE_LEAF | (NodeId)pos[r];
+        sub_add_child(w, parent, rank[(unsigned char)s[pos[r] + w->nodes.depth[parent]]], leaf);
+        prev = leaf;
+    }
+
+    return root;
+}
+
+// phase 3: claim buckets until none are left and build their subtrees
+void* build_buckets_worker(void* arg) {
+    ParallelWorker* w = (ParallelWorker*)arg;
+    w->stack = (NodeId*)malloc((largest_bucket(w) + 1) * sizeof(NodeId));
+    w->buckets_done = (int*)malloc(w->num_buckets * sizeof(int));
+    if (!w->stack || !w->buckets_done) {
+        perror("Could not allocate worker buffers");
+        exit(1);
+    }
+
+    for (;;) {
+        int b = __atomic_fetch_add(w->next_bucket, 1, __ATOMIC_RELAXED);
+        if (b >= w->num_buckets) break;
+        if (w->bucket_start[b] == w->bucket_start[b + 1]) continue;
+
+        w->bucket_root[b] = build_bucket(w, w->bucket_start[b], w->bucket_start[b + 1]);
+        w->bucket_worker[b] = w->id;
+        w->buckets_done[w->num_done++] = b;
+    }
+
+    return NULL;
+}
+
+// private reference -> NodeId in the final table
+NodeId final_id(const ParallelWorker* w, NodeId node) {
+    if (node == NO_NODE) return NO_NODE;
+    if (sub_is_leaf(node)) return (NodeId)(node & ~SUBTREE_LEAF);
+    return (NodeId)(w->tree->str_len + w->base + node);
+}
+
+// phase 4: copy the worker's nodes into its range of the final table and renumber its leaves' links
+void* renumber_worker(void* arg) {
+    ParallelWorker* w = (ParallelWorker*)arg;
+    NodeTable* tree = w->tree;
+    const SubtreeTable* t = &w->nodes;
+
+    for (TextPos i = 0; i < t->count; i++) {
+        TextPos f = w->base + i;
+        tree->depth[f] = t->depth[i];
+        tree->parent[f] = final_id(w, t->parent[i]);
+        tree->suff_link[f] = NO_NODE;
+        tree->first_child[f] = final_id(w, t->first_child[i]);
+        tree->next_sibling[f] = final_id(w, t->next_sibling[i]);
+        tree->branch[f] = t->branch[i];
+        tree->child_count[f] = t->child_count[i];
+        tree->dense_slot[f] = -1;
+        // a bucket root's edge is set once it is linked under the top of the tree
+        tree->edge_start[f] = (t->parent[i] == NO_NODE) ? 0 : t->rep[i] + t->depth[t->parent[i]];
+    }
+
+    for (int k = 0; k < w->num_done; k++) {
+        int b = w->buckets_done[k];
+        for (TextPos p = w->bucket_start[b]; p < w->bucket_start[b + 1]; p++) {
+            TextPos j = w->positions[p];
+            tree->leaf_parent[j] = final_id(w, tree->leaf_parent[j]);
+            tree->leaf_next_sibling[j] = final_id(w, tree->leaf_next_sibling[j]);
+        }
+    }
+
+    return NULL;
+}
+
+// helper function: run one phase on every worker and wait for all of them
+void run_workers(ParallelWorker* workers, pthread_t* threads, int num_threads, void* (*phase)(void*)) {
+    for (int t = 0; t < num_threads; t++) {
+        if (pthread_create(&threads[t], NULL, phase, &workers[t]) != 0) {
+            perror("Could not start worker thread");
+            exit(1);
+        }
+    }
+    for (int t = 0; t < num_threads; t++) {
+        pthread_join(threads[t], NULL);
+    }
+}
+
+// helper function: number of equal leading characters of two bucket keys (top_digit = sigma^(k-1))
+int key_lcp(int a, int b, int sigma, int top_digit) {
+    int lcp = 0;
+    for (int scale = top_digit; scale > 0 && (a / scale) % sigma == (b / scale) % sigma; scale /= sigma) {
+        lcp++;
+    }
+    return lcp;
+}
+
+// BuildSuffixTreeParallel
+SuffixTree* build_suffix_tree_parallel(const char* sequence_string, const char* alphabet, int num_threads) {
+    if (num_threads < 1) num_threads = 1;
+
+    SuffixTree* st = create_suffix_tree(sequence_string, alphabet);
+    NodeTable* tree = &st->nodes;
+    const char* s = sequence_string; // the tree may hold the text packed
+    TextPos n = st->str_len;
+    int sigma = st->alphabet_size;
+
+    // k: longest prefix with at most PARALLEL_MAX_BUCKETS keys (at least 1, at most n)
+    int k = 1;
+    long long num_keys = sigma;
+    while (k < n && num_keys * sigma <= PARALLEL_MAX_BUCKETS) {
+        num_keys *= sigma;
+        k++;
+    }
+    int top_digit = (int)(num_keys / sigma);
+
+    // bucket every suffix by the ranks of its first k characters ($ = 0 pads past the end), and the suffixes
+    // of the difference cover sample by the same keys
+    CoverSample* sample = init_cover_sample(s, st->char_rank, n, COVER_MIN_PERIOD);
+    TextPos m = sample->sample_size;
+    int cover_mask = sample->period - 1;
+    TextPos* bucket_start = (TextPos*)calloc(num_keys + 1, sizeof(TextPos));
+    TextPos* sample_start = (TextPos*)calloc(num_keys + 1, sizeof(TextPos));
+    TextPos* positions = (TextPos*)malloc(n * sizeof(TextPos));
+    TextPos* sample_positions = (TextPos*)malloc((m + 1) * sizeof(TextPos));
+    NodeId* bucket_root = (NodeId*)malloc(num_keys * sizeof(NodeId));
+    int* bucket_worker = (int*)malloc(num_keys * sizeof(int));
+    if (!bucket_start || !sample_start || !positions || !sample_positions || !bucket_root || !bucket_worker) {
+        perror("Could not allocate memory for prefix buckets");
+        exit(1);
+    }
+
+    int key = 0;
+    for (TextPos i = n - 1; i >= 0; i--) {
+        key = key / sigma + st->char_rank[(unsigned char)s[i]] * top_digit;
+        bucket_start[key + 1]++;
+        if (sample->cover_index[i & cover_mask] >= 0) sample_start[key + 1]++;
+    }
+    for (int b = 0; b < num_keys; b++) {
+        bucket_start[b + 1] += bucket_start[b];
+        sample_start[b + 1] += sample_start[b];
+    }
+    TextPos* fill = (TextPos*)malloc(num_keys * sizeof(TextPos));
+    TextPos* sample_fill = (TextPos*)malloc(num_keys * sizeof(TextPos));
+    if (!fill || !sample_fill) {
+        perror("Could not allocate memory for prefix buckets");
+        exit(1);
+    }
+    memcpy(fill, bucket_start, num_keys * sizeof(TextPos));
+    memcpy(sample_fill, sample_start, num_keys * sizeof(TextPos));
+    key = 0;
+    for (TextPos i = n - 1; i >= 0; i--) {
+        key = key / sigma + st->char_rank[(unsigned char)s[i]] * top_digit;
+        positions[fill[key]++] = i;
+        if (sample->cover_index[i & cover_mask] >= 0) sample_positions[sample_fill[key]++] = i;
+    }
+    free(fill);
+    free(sample_fill);
+
+    int next_bucket = 0;
+    ParallelWorker* workers = (ParallelWorker*)calloc(num_threads, sizeof(ParallelWorker));
+    pthread_t* threads = (pthread_t*)malloc(num_threads * sizeof(pthread_t));
+    TextPos* sample_names = (TextPos*)malloc(num_keys * sizeof(TextPos));
+    TextPos* names = (TextPos*)malloc((m + 1) * sizeof(TextPos));
+    if (!workers || !threads || !sample_names || !names) {
+        perror("Could not allocate memory for worker threads");
+        exit(1);
+    }
+    for (int t = 0; t < num_threads; t++) {
+        ParallelWorker* w = &workers[t];
+        w->id = t;
+        w->num_threads = num_threads;
+        w->sequence = s;
+        w->char_rank = st->char_rank;
+        w->alphabet_size = sigma;
+        w->prefix_len = k;
+        w->sample = sample;
+        w->sample_positions = sample_positions;
+        w->sample_start = sample_start;
+        w->sample_names = sample_names;
+        w->names = names;
+        w->positions = positions;
+        w->bucket_start = bucket_start;
+        w->num_buckets = (int)num_keys;
+        w->next_bucket = &next_bucket;
+        w->bucket_root = bucket_root;
+        w->bucket_worker = bucket_worker;
+        w->tree = tree;
+    }
+
+    // phase 0a/0b: workers sort and name the sampled suffixes bucket by bucket (buckets in key order are in
+    // v-prefix order, so each bucket's names follow the names of the buckets before it); SA-IS of the reduced
+    // string then ranks them
+    run_workers(workers, threads, num_threads, sort_sample_worker);
+    TextPos num_names = 0;
+    for (int b = 0; b < num_keys; b++) {
+        TextPos bucket_names = sample_names[b];
+        sample_names[b] = num_names;
+        num_names += bucket_names;
+    }
+    next_bucket = 0;
+    run_workers(workers, threads, num_threads, offset_sample_worker);
+    free(sample_positions);
+    free(sample_start);
+    free(sample_names);
+    rank_cover_sample(sample, names, num_names);
+
+    // phase 1: workers sort the buckets against the shared difference cover sample
+    next_bucket = 0;
+    run_workers(workers, threads, num_threads, sort_buckets_worker);
+    free_cover_sample(sample);
+
+    // phase 2: the buckets in key order are the suffix array; its LCPs give every bucket its shape.
+    // Workers invert it over ranges of the array, then run Kasai over ranges of the text
+    TextPos* lcp = (TextPos*)malloc(n * sizeof(TextPos));
+    TextPos* rank = (TextPos*)malloc(n * sizeof(TextPos));
+    if (!lcp || !rank) {
+        perror("Could not allocate memory for LCP array");
+        exit(1);
+    }
+    for (int t = 0; t < num_threads; t++) {
+        workers[t].lcp = lcp;
+        workers[t].rank = rank;
+    }
+    run_workers(workers, threads, num_threads, lcp_rank_worker);
+    run_workers(workers, threads, num_threads, lcp_worker);
+    free(rank);
+
+    // phase 3: workers build bucket subtrees
+    next_bucket = 0;
+    run_workers(workers, threads, num_threads, build_buckets_worker);
+    free(lcp);
+
+    // phase 4: give every worker a contiguous id range after the root and renumber in parallel
+    TextPos internal = 1;
+    for (int t = 0; t < num_threads; t++) {
+        workers[t].base = internal;
+        internal += workers[t].nodes.count;
+    }
+    if (internal > tree->internal_capacity) {
+        fprintf(stderr, "Error: Node table is full (%lld internal nodes)\n", (long long)tree->internal_capacity);
+        exit(1);
+    }
+    run_workers(workers, threads, num_threads, renumber_worker);
+    tree->internal_count = internal;
+    TextPos top_first = internal; // internal index of the first node of the top trie
+
+    // phase 5: link bucket roots (in key order) under the root through the compacted trie of their keys
+    // (sequential: at most PARALLEL_MAX_BUCKETS keys of k characters, independent of n)
+    NodeId* stack = (NodeId*)malloc((k + 2) * sizeof(NodeId));
+    if (!stack) {
+        perror("Could not allocate memory for top trie");
+        exit(1);
+    }
+    int stack_top = 0;
+    stack[0] = tree->root;
+    NodeId prev = NO_NODE;
+    int prev_key = -1;
+
+    for (int b = 0; b < num_keys; b++) {
+        if (bucket_start[b] == bucket_start[b + 1]) continue;
+
+        NodeId x = final_id(&workers[bucket_worker[b]], bucket_root[b]);
+        int h = (prev_key < 0) ? 0 : key_lcp(prev_key, b, sigma, top_digit);
+
+        NodeId last = prev;
+        while (node_depth(tree, stack[stack_top]) > h) {
+            last = stack[stack_top--];
+        }
+        if (node_depth(tree, stack[stack_top]) < h) {
+            // split the edge to the rightmost child at depth h
+            NodeId w = create_internal_node(tree);
+            tree->depth[w - n] = h;
+            replace_child(tree, stack[stack_top], last, w);
+            set_parent(tree, w, stack[stack_top]);
+            add_child(tree, w, st->char_rank[(unsigned char)s[leftmost_leaf(tree, last) + h]], last);
+            set_parent(tree, last, w);
+            stack[++stack_top] = w;
+        }
+
+        NodeId parent = stack[stack_top];
+        add_child(tree, parent, st->char_rank[(unsigned char)s[positions[bucket_start[b]] + node_depth(tree, parent)]], x);
+        set_parent(tree, x, parent);
+
+        prev = x;
+        prev_key = b;
+    }
+    free(stack);
+
+    // top trie and bucket root edges start below their (now final) parents
+    for (TextPos i = top_first; i < tree->internal_count; i++) {
+        NodeId w = (NodeId)(n + i);
+        tree->edge_start[i] = leftmost_leaf(tree, w) + node_depth(tree, node_parent(tree, w));
+    }
+    for (int b = 0; b < num_keys; b++) {
+        if (bucket_start[b + 1] - bucket_start[b] < 2) continue;
+        NodeId x = final_id(&workers[bucket_worker[b]], bucket_root[b]);
+        tree->edge_start[x - n] = positions[bucket_start[b]] + node_depth(tree, node_parent(tree, x));
+    }
+
+    // bucket subtrees arrived with raw child counts: give high-fanout nodes their dense tables
+    for (TextPos i = 0; i < tree->internal_count; i++) {
+        if (tree->child_count[i] > DENSE_FANOUT && tree->dense_slot[i] < 0) {
+            make_dense(tree, (NodeId)(n + i));
+        }
+    }
+
+    for (int t = 0; t < num_threads; t++) {
+        SubtreeTable* table = &workers[t].nodes;
+        free(table->depth);
+        free(table->rep);
+        free(table->parent);
+        free(table->first_child);
+        free(table->last_child);
+        free(table->next_sibling);
+        free(table->branch);
+        free(table->child_count);
+        free(workers[t].buckets_done);
+        free(workers[t].stack);
+    }
+    free(workers);
+    free(threads);
+    free(bucket_start);
+    free(positions);
+    free(bucket_root);
+    free(bucket_worker);
+
+    return st;
+}
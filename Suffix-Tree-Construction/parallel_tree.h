@@ -0,0 +1,34 @@
+#ifndef PARALLEL_TREE_H
+#define PARALLEL_TREE_H
+
+#include "types.h"
+#include "suffix_tree.h"
+#include "suffix_array.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#define PARALLEL_MAX_BUCKETS 65536 // k is the longest prefix with at most this many possible keys
+
+// BuildSuffixTreeParallel
+/**
+ * Builds the suffix tree with a pool of threads, partitioning suffixes by their first k characters.
+ * The difference cover sample is sorted and named bucket by bucket by the workers too (only SA-IS of its
+ * reduced string is sequential). Workers sort the buckets independently (sort_suffixes against the shared
+ * sample, so long repeats cost no more than short ones); the sorted buckets in key order are the suffix
+ * array, whose LCP array (Kasai over one range of the text per worker) lets workers build each bucket's
+ * subtree bottom-up.
+ * The subtrees are renumbered into one node table in parallel and linked under the root through the
+ * compacted trie of the bucket prefixes.
+ * The tree has the same shape and leaf order as the sequential one; suffix links are not built
+ * (only the sequential builders need them), so they are NO_NODE except at the root.
+ * @sequence_string: full sequence string (ends with $)
+ * @alphabet: alphabet the sequence is comprised of (including $)
+ * @num_threads: number of worker threads
+ * @returns - suffix tree; free_suffix_tree releases it
+ */
+SuffixTree* build_suffix_tree_parallel(const char* sequence_string, const char* alphabet, int num_threads);
+
+#endif
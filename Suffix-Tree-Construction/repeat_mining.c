@@ -0,0 +1,114 @@
+#include "repeat_mining.h"
+#include "input_stream.h"
+
+// RepeatsFileName
+void repeats_file_name(const char* sequence_file, char* output_filename, size_t size) {
+    snprintf(output_filename, size, "%.*s_repeats.tsv",
+             (int)input_file_stem_length(sequence_file),
+             sequence_file);
+}
+
+// helper function: left character of a leaf as a mask bit ($, i.e., bit 0, for the start of the sequence)
+uint64_t left_char_bit(const SuffixTree* st, NodeId leaf) {
+    if (leaf == 0) return 1;
+    return (uint64_t)1 << text_rank(st, leaf - 1);
+}
+
+// helper function: mines an internal node once all its children are finished (context: RepeatWalk)
+void mine_node(const SuffixTree* st, NodeId node, TextPos level, void* context) {
+    const NodeTable* tree = &st->nodes;
+    RepeatWalk* walk = (RepeatWalk*)context;
+    TextPos n = tree->str_len;
+    if (is_leaf(tree, node)) return;
+    NodeId i = node - n;
+
+    uint64_t mask = 0;
+    bool diverse = false;
+    bool supermaximal = true; // only leaf children, with pairwise different left characters
+    TextPos leaves = 0;
+    for (NodeId child = first_child(tree, node); child != NO_NODE; child = next_sibling(tree, child)) {
+        uint64_t child_mask;
+        if (is_leaf(tree, child)) {
+            child_mask = left_char_bit(st, child);
+            if (mask & child_mask & ~(uint64_t)1) supermaximal = false;
+            leaves++;
+        } else {
+            NodeId c = child - n;
+            child_mask = walk->left_mask[c];
+            diverse = diverse || walk->left_diverse[c];
+            supermaximal = false;
+            leaves += walk->count[c];
+        }
+        if (mask & child_mask & 1) diverse = true; // two different sequence/record starts
+        mask |= child_mask;
+    }
+    diverse = diverse || (mask & (mask - 1)) != 0;
+
+    NodeId first = first_child(tree, node);
+    walk->left_mask[i] = mask;
+    walk->left_diverse[i] = diverse;
+    walk->count[i] = leaves;
+    walk->start[i] = is_leaf(tree, first) ? (TextPos)first : walk->start[first - n];
+
+    TextPos length = tree->depth[i];
+    if (!is_root(tree, node) && diverse && length >= walk->min_length && leaves >= walk->min_count) {
+        fprintf(walk->file, "%s\t%lld\t%lld\t%lld\n", supermaximal ? "supermaximal" : "maximal", (long long)length,
+                (long long)leaves, (long long)walk->start[i]);
+        walk->num_maximal++;
+        if (supermaximal) walk->num_supermaximal++;
+    }
+}
+
+// MineRepeats
+int mine_repeats(const SuffixTree* st, TextPos min_length, TextPos min_count, const char* filename,
+                 long long* num_maximal, long long* num_supermaximal) {
+    const NodeTable* tree = &st->nodes;
+    *num_maximal = 0;
+    *num_supermaximal = 0;
+
+    if (st->alphabet_size > 64) {
+        fprintf(stderr, "Error: repeat mining supports alphabets of up to 64 characters (got %d)\n", st->alphabet_size);
+        return -1;
+    }
+
+    FILE* file = fopen(filename, "w");
+    if (!file) {
+        perror("Error opening repeats file");
+        return -1;
+    }
+    setvbuf(file, NULL, _IOFBF, 1 << 20);
+    fprintf(file, "type\tlength\tcount\tstart\n");
+
+    // per internal node, filled when the node is left (all children first): no per-repeat state
+    RepeatWalk walk;
+    walk.file = file;
+    walk.min_length = min_length;
+    walk.min_count = min_count;
+    walk.left_mask = (uint64_t*)malloc(tree->internal_count * sizeof(uint64_t));
+    walk.left_diverse = (uint8_t*)malloc(tree->internal_count * sizeof(uint8_t));
+    walk.count = (TextPos*)malloc(tree->internal_count * sizeof(TextPos));
+    walk.start = (TextPos*)malloc(tree->internal_count * sizeof(TextPos));
+    walk.num_maximal = 0;
+    walk.num_supermaximal = 0;
+    if (!walk.left_mask || !walk.left_diverse || !walk.count || !walk.start) {
+        perror("Could not allocate memory for repeat mining");
+        exit(1);
+    }
+
+    visit_tree(st, tree->root, NULL, mine_node, &walk);
+    *num_maximal = walk.num_maximal;
+    *num_supermaximal = walk.num_supermaximal;
+
+    free(walk.left_mask);
+    free(walk.left_diverse);
+    free(walk.count);
+    free(walk.start);
+
+    int ok = !ferror(file);
+    if (fclose(file) != 0) ok = 0;
+    if (!ok) {
+        perror("Error writing repeats file");
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,41 @@
+#ifndef REPEAT_MINING_H
+#define REPEAT_MINING_H
+
+#include "types.h"
+#include "suffix_tree.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdint.h>
+
+// RepeatsFileName
+/**
+ * Gets the name of the repeats file of a sequence file: <sequence file without extension>_repeats.tsv
+ * @sequence_file: name of the file the sequence was read from
+ * @output_filename: buffer receiving the name
+ * @size: size of the buffer
+ */
+void repeats_file_name(const char* sequence_file, char* output_filename, size_t size);
+
+// MineRepeats
+/**
+ * Streams every maximal repeat with length >= @min_length and >= @min_count occurrences to a TSV file
+ * (type, length, count, start), in one bottom-up pass over the tree without recursion or per-repeat allocations.
+ * Every internal node is right-maximal; it is a maximal repeat if its leaves are left-diverse (preceded by
+ * at least two different characters, the start of the sequence counting as its own character), and a
+ * supermaximal repeat if moreover all its children are leaves with pairwise different left characters.
+ * Left characters are folded up the tree as one 64-bit mask per internal node ($ only precedes the start of
+ * the sequence or of a record, so its bit stands for those; two of them are different left characters).
+ * start is the leftmost occurrence in lexicographic order; leaf_slice gives all of them on an annotated tree.
+ * @st: tree to mine (alphabets of up to 64 characters)
+ * @min_length: shortest repeat reported
+ * @min_count: fewest occurrences reported
+ * @filename: TSV file to write
+ * @num_maximal: receives the number of maximal repeats written
+ * @num_supermaximal: receives how many of them are supermaximal
+ * @returns - 0 on success, -1 if the file could not be written or the alphabet is too large
+ */
+int mine_repeats(const SuffixTree* st, TextPos min_length, TextPos min_count, const char* filename,
+                 long long* num_maximal, long long* num_supermaximal);
+
+#endif
@@ -0,0 +1,675 @@
+#include "suffix_array.h"
+#include "input_parser.h"
+#include "tree_io.h"
+
+// character i of a text stored as uint8_t or TextPos ranks
+#define CHR(i) (char_size == sizeof(TextPos) ? ((const TextPos*)text)[i] : ((const uint8_t*)text)[i])
+
+// L/S type bits: S-type (1) if suffix i is smaller than suffix i + 1, L-type (0) otherwise
+#define TGET(i) ((types[(i) / 8] >> ((i) % 8)) & 1)
+#define TSET(i, b) (types[(i) / 8] = (b) ? (types[(i) / 8] | (1 << ((i) % 8))) : (types[(i) / 8] & ~(1 << ((i) % 8))))
+#define IS_LMS(i) ((i) > 0 && TGET(i) && !TGET((i) - 1))
+
+// helper function: start (or end) of every character's bucket in the suffix array
+void get_buckets(const void* text, TextPos* buckets, TextPos n, TextPos max_char, int char_size, bool end) {
+    memset(buckets, 0, (max_char + 1) * sizeof(TextPos));
+    for (TextPos i = 0; i < n; i++) {
+        buckets[CHR(i)]++;
+    }
+
+    TextPos sum = 0;
+    for (TextPos c = 0; c <= max_char; c++) {
+        sum += buckets[c];
+        buckets[c] = end ? sum : sum - buckets[c];
+    }
+}
+
+// helper function: place L-type suffixes left to right from the already placed suffixes
+void induce_l_types(const uint8_t* types, TextPos* sa, const void* text, TextPos* buckets, TextPos n, TextPos max_char, int char_size) {
+    get_buckets(text, buckets, n, max_char, char_size, false);
+    for (TextPos i = 0; i < n; i++) {
+        TextPos j = sa[i] - 1;
+        if (j >= 0 && !TGET(j)) {
+            sa[buckets[CHR(j)]++] = j;
+        }
+    }
+}
+
+// helper function: place S-type suffixes right to left from the already placed suffixes
+void induce_s_types(const uint8_t* types, TextPos* sa, const void* text, TextPos* buckets, TextPos n, TextPos max_char, int char_size) {
+    get_buckets(text, buckets, n, max_char, char_size, true);
+    for (TextPos i = n - 1; i >= 0; i--) {
+        TextPos j = sa[i] - 1;
+        if (j >= 0 && TGET(j)) {
+            sa[--buckets[CHR(j)]] = j;
+        }
+    }
+}
+
+// SA-IS
+void sa_is(const void* text, TextPos* sa, TextPos n, TextPos max_char, int char_size) {
+    if (n == 1) {
+        sa[0] = 0;
+        return;
+    }
+
+    uint8_t* types = (uint8_t*)calloc(n / 8 + 1, sizeof(uint8_t));
+    TextPos* buckets = (TextPos*)malloc((max_char + 1) * sizeof(TextPos));
+    if (!types || !buckets) {
+        perror("Could not allocate memory for SA-IS");
+        exit(1);
+    }
+
+    // classify suffixes (the sentinel is S-type, the one before it L-type)
+    TSET(n - 2, 0);
+    TSET(n - 1, 1);
+    for (TextPos i = n - 3; i >= 0; i--) {
+        TSET(i, CHR(i) < CHR(i + 1) || (CHR(i) == CHR(i + 1) && TGET(i + 1)));
+    }
+
+    // stage 1: sort LMS substrings by inducing from LMS suffixes placed at their bucket ends
+    get_buckets(text, buckets, n, max_char, char_size, true);
+    for (TextPos i = 0; i < n; i++) {
+        sa[i] = -1;
+    }
+    for (TextPos i = 1; i < n; i++) {
+        if (IS_LMS(i)) {
+            sa[--buckets[CHR(i)]] = i;
+        }
+    }
+    induce_l_types(types, sa, text, buckets, n, max_char, char_size);
+    induce_s_types(types, sa, text, buckets, n, max_char, char_size);
+
+    // compact the sorted LMS substrings into the first n1 slots
+    TextPos n1 = 0;
+    for (TextPos i = 0; i < n; i++) {
+        if (IS_LMS(sa[i])) {
+            sa[n1++] = sa[i];
+        }
+    }
+
+    // name LMS substrings: equal substrings get equal names
+    for (TextPos i = n1; i < n; i++) {
+        sa[i] = -1;
+    }
+    TextPos name = 0;
+    TextPos prev = -1;
+    for (TextPos i = 0; i < n1; i++) {
+        TextPos pos = sa[i];
+        bool diff = false;
+        for (TextPos d = 0; d < n; d++) {
+            if (prev == -1 || CHR(pos + d) != CHR(prev + d) || TGET(pos + d) != TGET(prev + d)) {
+                diff = true;
+                break;
+            }
+            else if (d > 0 && (IS_LMS(pos + d) || IS_LMS(prev + d))) {
+                break;
+            }
+        }
+        if (diff) {
+            name++;
+            prev = pos;
+        }
+        // LMS positions are at least 2 apart, so pos / 2 is a collision-free slot
+        sa[n1 + pos / 2] = name - 1;
+    }
+    for (TextPos i = n - 1, j = n - 1; i >= n1; i--) {
+        if (sa[i] >= 0) {
+            sa[j--] = sa[i];
+        }
+    }
+
+    // stage 2: sort the reduced string (recursively if names are not yet unique)
+    TextPos* reduced = sa + n - n1;
+    if (name < n1) {
+        sa_is(reduced, sa, n1, name - 1, sizeof(TextPos));
+    }
+    else {
+        for (TextPos i = 0; i < n1; i++) {
+            sa[reduced[i]] = i;
+        }
+    }
+
+    // stage 3: induce the full suffix array from the sorted LMS suffixes
+    get_buckets(text, buckets, n, max_char, char_size, true);
+    for (TextPos i = 1, j = 0; i < n; i++) {
+        if (IS_LMS(i)) {
+            reduced[j++] = i; // map reduced positions back to the text
+        }
+    }
+    for (TextPos i = 0; i < n1; i++) {
+        sa[i] = reduced[sa[i]];
+    }
+    for (TextPos i = n1; i < n; i++) {
+        sa[i] = -1;
+    }
+    for (TextPos i = n1 - 1; i >= 0; i--) {
+        TextPos j = sa[i];
+        sa[i] = -1;
+        sa[--buckets[CHR(j)]] = j;
+    }
+    induce_l_types(types, sa, text, buckets, n, max_char, char_size);
+    induce_s_types(types, sa, text, buckets, n, max_char, char_size);
+
+    free(buckets);
+    free(types);
+}
+
+// Kasai LCP
+void compute_lcp_array(SuffixArray* array) {
+    array->lcp = (TextPos*)malloc(array->str_len * sizeof(TextPos));
+    if (!array->lcp) {
+        perror("Could not allocate memory for LCP array");
+        exit(1);
+    }
+    kasai_lcp(array->sequence, array->sa, array->lcp, array->str_len);
+}
+
+// Kasai LCP of a bare suffix array
+void kasai_lcp(const char* s, const TextPos* sa, TextPos* lcp, TextPos n) {
+    TextPos* rank = (TextPos*)malloc(n * sizeof(TextPos));
+    if (!rank) {
+        perror("Could not allocate memory for LCP array");
+        exit(1);
+    }
+
+    for (TextPos i = 0; i < n; i++) {
+        rank[sa[i]] = i;
+    }
+    kasai_lcp_range(s, sa, rank, lcp, n, 0, n);
+
+    free(rank);
+}
+
+// Kasai LCP of a range of text positions
+void kasai_lcp_range(const char* s, const TextPos* sa, const TextPos* rank, TextPos* lcp, TextPos n, TextPos lo, TextPos hi) {
+    TextPos h = 0;
+    for (TextPos i = lo; i < hi; i++) {
+        if (rank[i] == 0) {
+            lcp[0] = 0;
+            h = 0;
+            continue;
+        }
+        TextPos j = sa[rank[i] - 1];
+        while (i + h < n && j + h < n && s[i + h] == s[j + h]) {
+            h++;
+        }
+        lcp[rank[i]] = h;
+        if (h > 0) h--;
+    }
+}
+
+// helper function: is residue d in the difference cover {0...r-1} + multiples of r?
+bool in_cover(int d, int r) {
+    return d < r || d % r == 0;
+}
+
+// helper function: sample slot of a sampled position
+TextPos sample_slot(const CoverSample* sample, TextPos i) {
+    return sample->class_start[sample->cover_index[i & (sample->period - 1)]] + (i >> sample->shift);
+}
+
+// helper function: order of two suffixes by their first v characters only (0 if those are equal)
+int compare_prefixes(const CoverSample* sample, TextPos p, TextPos q, TextPos depth) {
+    const char* s = sample->sequence;
+    const int16_t* rank = sample->char_rank;
+    for (TextPos t = depth; t < sample->period; t++) {
+        int cp = rank[(unsigned char)s[p + t]];
+        int cq = rank[(unsigned char)s[q + t]];
+        if (cp != cq) return (cp < cq) ? -1 : 1;
+    }
+    return 0;
+}
+
+// helper function: order of two distinct suffixes sharing their first `depth` characters
+int compare_sampled(const CoverSample* sample, TextPos p, TextPos q, TextPos depth) {
+    const char* s = sample->sequence;
+    const int16_t* rank = sample->char_rank;
+    int mask = sample->period - 1;
+    // the first `depth` characters are equal, and within the next v offsets both suffixes are sampled
+    // ($ is unique, so near the end the characters differ first)
+    for (TextPos t = depth; ; t++) {
+        int cp = rank[(unsigned char)s[p + t]];
+        int cq = rank[(unsigned char)s[q + t]];
+        if (cp != cq) return (cp < cq) ? -1 : 1;
+        if (sample->cover_index[(p + t + 1) & mask] >= 0 && sample->cover_index[(q + t + 1) & mask] >= 0) {
+            return (sample->rank[sample_slot(sample, p + t + 1)] < sample->rank[sample_slot(sample, q + t + 1)]) ? -1 : 1;
+        }
+    }
+}
+
+// helper function: merge sort of suffixes (insertion sort below 16), scratch holds count / 2 positions
+void merge_sort_suffixes(const CoverSample* sample, TextPos* pos, TextPos count, TextPos depth, TextPos* scratch,
+                         int (*compare)(const CoverSample*, TextPos, TextPos, TextPos)) {
+    if (count <= 16) {
+        for (TextPos i = 1; i < count; i++) {
+            TextPos x = pos[i];
+            TextPos j = i;
+            while (j > 0 && compare(sample, x, pos[j - 1], depth) < 0) {
+                pos[j] = pos[j - 1];
+                j--;
+            }
+            pos[j] = x;
+        }
+        return;
+    }
+
+    TextPos half = count / 2;
+    merge_sort_suffixes(sample, pos, half, depth, scratch, compare);
+    merge_sort_suffixes(sample, pos + half, count - half, depth, scratch, compare);
+    if (compare(sample, pos[half - 1], pos[half], depth) <= 0) return;
+
+    // the left run moves to scratch; the merged output never overtakes the unread right run
+    memcpy(scratch, pos, half * sizeof(TextPos));
+    TextPos i = 0, j = half, k = 0;
+    while (i < half && j < count) {
+        pos[k++] = (compare(sample, pos[j], scratch[i], depth) < 0) ? pos[j++] : scratch[i++];
+    }
+    while (i < half) {
+        pos[k++] = scratch[i++];
+    }
+}
+
+// CoverSampleBytes
+size_t cover_sample_bytes(TextPos n, int period, size_t* kept) {
+    int r = 1;
+    while (r * r < period) r *= 2;
+    int cover_size = 0;
+    size_t sample_size = 0;
+    for (int d = 0; d < period; d++) {
+        if (!in_cover(d, r)) continue;
+        cover_size++;
+        if (d < n) sample_size += (size_t)(n - 1 - d) / period + 1;
+    }
+
+    size_t tables = period * sizeof(int) + cover_size * sizeof(TextPos) + sizeof(CoverSample);
+    *kept = tables + (sample_size + 1) * sizeof(TextPos);
+    // names, reduced suffix array and SA-IS buckets (sorting needs only the positions and half as much scratch)
+    return tables + 3 * (sample_size + 1) * sizeof(TextPos) + sample_size / 8 + 1;
+}
+
+// InitCoverSample
+CoverSample* init_cover_sample(const char* s, const int16_t* char_rank, TextPos n, int period) {
+    CoverSample* sample = (CoverSample*)malloc(sizeof(CoverSample));
+    if (!sample) {
+        perror("Could not allocate memory for difference cover sample");
+        exit(1);
+    }
+    sample->sequence = s;
+    sample->char_rank = char_rank;
+    sample->str_len = n;
+    sample->period = period;
+    sample->shift = 0;
+    while ((1 << sample->shift) < period) sample->shift++;
+    sample->rank = NULL;
+    int r = 1;
+    while (r * r < period) r *= 2;
+
+    sample->cover_index = (int*)malloc(period * sizeof(int));
+    if (!sample->cover_index) {
+        perror("Could not allocate memory for difference cover sample");
+        exit(1);
+    }
+    sample->cover_size = 0;
+    for (int d = 0; d < period; d++) {
+        sample->cover_index[d] = in_cover(d, r) ? sample->cover_size++ : -1;
+    }
+
+    // slots: residue classes in cover order, each in text order
+    sample->class_start = (TextPos*)malloc(sample->cover_size * sizeof(TextPos));
+    if (!sample->class_start) {
+        perror("Could not allocate memory for difference cover sample");
+        exit(1);
+    }
+    TextPos m = 0;
+    for (int d = 0; d < period; d++) {
+        if (sample->cover_index[d] < 0) continue;
+        sample->class_start[sample->cover_index[d]] = m;
+        if (d < n) m += (n - 1 - d) / period + 1;
+    }
+    sample->sample_size = m;
+    return sample;
+}
+
+// SortSamplePrefixes
+void sort_sample_prefixes(const CoverSample* sample, TextPos* pos, TextPos count, TextPos depth, TextPos* scratch) {
+    merge_sort_suffixes(sample, pos, count, depth, scratch, compare_prefixes);
+}
+
+// NameSamplePrefixes
+TextPos name_sample_prefixes(const CoverSample* sample, const TextPos* pos, TextPos count, TextPos depth, TextPos* names) {
+    TextPos name = 0;
+    for (TextPos k = 0; k < count; k++) {
+        if (k == 0 || compare_prefixes(sample, pos[k - 1], pos[k], depth) != 0) name++;
+        names[sample_slot(sample, pos[k])] = name;
+    }
+    return name;
+}
+
+// RankCoverSample
+void rank_cover_sample(CoverSample* sample, TextPos* names, TextPos num_names) {
+    TextPos m = sample->sample_size;
+
+    // unique names are already the ranks; otherwise sort the reduced string and turn it into ranks in place
+    names[m] = 0;
+    if (num_names < m) {
+        TextPos* sa = (TextPos*)malloc((m + 1) * sizeof(TextPos));
+        if (!sa) {
+            perror("Could not allocate memory for difference cover sample");
+            exit(1);
+        }
+        sa_is(names, sa, m + 1, num_names, sizeof(TextPos));
+        for (TextPos k = 1; k <= m; k++) {
+            names[sa[k]] = k;
+        }
+        free(sa);
+    }
+    sample->rank = names;
+}
+
+// BuildCoverSample
+CoverSample* build_cover_sample(const char* s, const int16_t* char_rank, TextPos n, int period) {
+    CoverSample* sample = init_cover_sample(s, char_rank, n, period);
+    TextPos m = sample->sample_size;
+
+    TextPos* pos = (TextPos*)malloc((m + 1) * sizeof(TextPos));
+    TextPos* scratch = (TextPos*)malloc((m / 2 + 1) * sizeof(TextPos));
+    if (!pos || !scratch) {
+        perror("Could not allocate memory for difference cover sample");
+        exit(1);
+    }
+    TextPos slots = 0;
+    for (int d = 0; d < period; d++) {
+        if (sample->cover_index[d] < 0) continue;
+        for (TextPos i = d; i < n; i += period) {
+            pos[slots++] = i;
+        }
+    }
+    sort_sample_prefixes(sample, pos, m, 0, scratch);
+    free(scratch);
+
+    // names in v-prefix order (from 1; the 0 after the last slot is the sentinel SA-IS needs)
+    TextPos* names = (TextPos*)malloc((m + 1) * sizeof(TextPos));
+    if (!names) {
+        perror("Could not allocate memory for difference cover sample");
+        exit(1);
+    }
+    TextPos num_names = name_sample_prefixes(sample, pos, m, 0, names);
+    free(pos);
+
+    rank_cover_sample(sample, names, num_names);
+    return sample;
+}
+
+// FreeCoverSample
+void free_cover_sample(CoverSample* sample) {
+    if (!sample) return;
+    free(sample->cover_index);
+    free(sample->class_start);
+    free(sample->rank);
+    free(sample);
+}
+
+// SortSuffixes
+void sort_suffixes(const CoverSample* sample, TextPos* pos, TextPos count, TextPos depth, TextPos* scratch) {
+    merge_sort_suffixes(sample, pos, count, depth, scratch, compare_sampled);
+}
+
+// BuildSuffixArray
+SuffixArray* build_suffix_array(const char* sequence_string, const char* alphabet) {
+    SuffixArray* array = (SuffixArray*)malloc(sizeof(SuffixArray));
+    if (!array) {
+        perror("Could not allocate memory for suffix array");
+        exit(1);
+    }
+
+    array->sequence = strdup(sequence_string);
+    array->alphabet = strdup(alphabet);
+    if (!array->sequence || !array->alphabet) {
+        perror("Could not copy sequence/alphabet into suffix array");
+        exit(1);
+    }
+    size_t length = strlen(sequence_string);
+    if (length >= (size_t)POS_MAX) {
+        fprintf(stderr, "Error: Sequence is too long for this build (%zu characters); rebuild with make POS64=1\n", length);
+        exit(1);
+    }
+    array->str_len = (TextPos)length;
+    array->alphabet_size = strlen(alphabet);
+    build_char_rank(array->char_rank, sequence_string, alphabet);
+
+    // SA-IS runs on ranks so the sentinel $ is the unique smallest character
+    TextPos n = array->str_len;
+    uint8_t* text = (uint8_t*)malloc(n * sizeof(uint8_t));
+    array->sa = (TextPos*)malloc(n * sizeof(TextPos));
+    if (!text || !array->sa) {
+        perror("Could not allocate memory for suffix array");
+        exit(1);
+    }
+    for (TextPos i = 0; i < n; i++) {
+        text[i] = (uint8_t)array->char_rank[(unsigned char)sequence_string[i]];
+    }
+
+    sa_is(text, array->sa, n, array->alphabet_size - 1, sizeof(uint8_t));
+    free(text);
+
+    array->lcp = NULL;
+    array->file = NULL;
+    array->window = n;
+    compute_lcp_array(array);
+
+    return array;
+}
+
+// BuildBWTDirect
+char* build_bwt_direct(const char* sequence_string, const char* alphabet) {
+    size_t length = strlen(sequence_string);
+    if (length >= (size_t)POS_MAX) {
+        fprintf(stderr, "Error: Sequence is too long for this build (%zu characters); rebuild with make POS64=1\n", length);
+        exit(1);
+    }
+    TextPos n = (TextPos)length;
+    int16_t char_rank[256];
+    build_char_rank(char_rank, sequence_string, alphabet);
+
+    // SA-IS runs on ranks so the sentinel $ is the unique smallest character
+    uint8_t* text = (uint8_t*)malloc(n * sizeof(uint8_t));
+    TextPos* sa = (TextPos*)malloc(n * sizeof(TextPos));
+    if (!text || !sa) {
+        perror("Could not allocate memory for BWT");
+        exit(1);
+    }
+    for (TextPos i = 0; i < n; i++) {
+        text[i] = (uint8_t)char_rank[(unsigned char)sequence_string[i]];
+    }
+    sa_is(text, sa, n, (TextPos)strlen(alphabet) - 1, sizeof(uint8_t));
+    free(text);
+
+    // overwrite the suffix array with the BWT: byte i lies at or before sa[i], in an entry already read
+    char* bwt = (char*)sa;
+    for (TextPos i = 0; i < n; i++) {
+        TextPos suffix_id = sa[i];
+        bwt[i] = sequence_string[(suffix_id == 0) ? n - 1 : suffix_id - 1];
+    }
+    bwt[n] = '\0';
+    char* shrunk = (char*)realloc(bwt, n + 1);
+    return shrunk ? shrunk : bwt;
+}
+
+// helper function: window of a section from position start on (element 0 is position start)
+/**
+ * Owned arrays are one window. From a file, up to array->window positions are read into the section's buffer.
+ * @section: sa or lcp of the array (the buffer when read from file)
+ * @offset: offset of the section in the index file
+ * @window_end: receives the end of the window
+ */
+const TextPos* section_window(const SuffixArray* array, TextPos* section, uint64_t offset, TextPos start, TextPos* window_end) {
+    if (!array->file) {
+        *window_end = array->str_len;
+        return section + start;
+    }
+    TextPos count = (array->str_len - start < array->window) ? array->str_len - start : array->window;
+    if (fseek(array->file, (long)(offset + (uint64_t)start * sizeof(TextPos)), SEEK_SET) != 0 ||
+        fread(section, sizeof(TextPos), count, array->file) != (size_t)count) {
+        perror("Error reading index file");
+        exit(1);
+    }
+    *window_end = start + count;
+    return section;
+}
+
+// FreeSuffixArray
+void free_suffix_array(SuffixArray* array) {
+    if (!array) return;
+
+    if (array->file) fclose(array->file);
+    free(array->sa);
+    free(array->lcp);
+    free(array->sequence);
+    free(array->alphabet);
+    free(array);
+}
+
+// Stats
+void print_tree_stats_sa(const SuffixArray* array) {
+    TextPos n = array->str_len;
+
+    // Initialize statistics variables
+    TextPos internal_nodes = 0;
+    long long total_internal_depth = 0;
+    TextPos max_depth = 0;
+
+    // Stack of string-depths of the open lcp-intervals (root interval at the bottom)
+    TextPos* stack = (TextPos*)malloc((n + 1) * sizeof(TextPos));
+    TextPos stack_top = 0;
+    stack[0] = 0;
+
+    const TextPos* lcp = NULL;
+    TextPos window_start = 1;
+    TextPos window_end = 1;
+    for (TextPos i = 1; i <= n; i++) {
+        if (i == window_end && i < n) {
+            window_start = i;
+            lcp = section_window(array, array->lcp, array->lcp_offset, i, &window_end);
+        }
+        TextPos h = (i < n) ? lcp[i - window_start] : 0; // close everything but the root at the end
+
+        // every interval deeper than h ends here: it is one internal node
+        while (stack[stack_top] > h) {
+            TextPos depth = stack[stack_top--];
+            internal_nodes++;
+            total_internal_depth += depth;
+            if (depth > max_depth) {
+                max_depth = depth;
+            }
+        }
+        if (stack[stack_top] < h) {
+            stack[++stack_top] = h;
+        }
+    }
+
+    // Calculate average depth (avoid division by zero)
+    double avg_depth = (internal_nodes > 0) ? (double)total_internal_depth / internal_nodes : 0.0;
+
+    // Print the statistics
+    printf("\nSuffix Tree Statistics:\n");
+    printf("-----------------------\n");
+    printf("Internal nodes: %lld\n", (long long)internal_nodes);
+    printf("Leaves: %lld\n", (long long)n);
+    printf("Total nodes: %lld\n", (long long)internal_nodes + n + 1); // + root
+    printf("Average string-depth of internal nodes: %.2f\n", avg_depth);
+    printf("String-depth of deepest internal node: %lld\n", (long long)max_depth);
+
+    free(stack);
+}
+
+// BWT index
+void compute_bwt_index_sa(const SuffixArray* array, const char* sequence_file, BwtFormat format) {
+    TextPos n = array->str_len;
+    char* BWT = (char*)malloc((n + 1) * sizeof(char)); // +1 for null terminator
+    if (!BWT) {
+        perror("Could not allocate memory for BWT");
+        exit(1);
+    }
+
+    const TextPos* sa = NULL;
+    TextPos window_start = 0;
+    TextPos window_end = 0;
+    for (TextPos i = 0; i < n; i++) {
+        if (i == window_end) {
+            window_start = i;
+            sa = section_window(array, array->sa, array->sa_offset, i, &window_end);
+        }
+        TextPos suffix_id = sa[i - window_start];
+        TextPos bwt_pos = (suffix_id == 0) ? n - 1 : suffix_id - 1;
+        BWT[i] = array->sequence[bwt_pos];
+    }
+
+    write_bwt_file(sequence_file, BWT, n, format);
+    free(BWT);
+}
+
+// reporting space used by the suffix and LCP arrays relative to the seq string size
+void report_space_usage_sa(const SuffixArray* array) {
+    size_t input_bytes = array->str_len;
+    size_t sa_bytes = input_bytes * sizeof(TextPos);
+    size_t lcp_bytes = array->lcp ? input_bytes * sizeof(TextPos) : 0;
+    size_t index_memory = sa_bytes + lcp_bytes;
+
+    printf("Space Usage:\n");
+    printf("Input size: %zu bytes\n", input_bytes);
+    printf("Suffix array: %zu bytes (%zu bytes each)\n", sa_bytes, sizeof(TextPos));
+    printf("LCP array: %zu bytes (%zu bytes each)\n", lcp_bytes, sizeof(TextPos));
+    printf("Index memory: %zu bytes (~%.2f MB)\n",
+           index_memory, index_memory/(1024.0*1024.0));
+    printf("Space constant: ~%.1f bytes per input byte\n", (double)index_memory / input_bytes);
+    if (array->file) {
+        printf("Index is read from disk (%zu bytes) %lld positions at a time: only one window of each array is resident\n",
+               array->file_size, (long long)array->window);
+    }
+}
+
+// finding longest repeated substrings
+LongestRepeat find_repeats_sa(const SuffixArray* array) {
+    LongestRepeat result = {0, NULL, 0};
+    TextPos n = array->str_len;
+
+    // the first maximum LCP and the run of equal values after it, in one pass
+    TextPos first = 0;
+    TextPos last = 0;
+    const TextPos* lcp = NULL;
+    TextPos window_start = 1;
+    TextPos window_end = 1;
+    for (TextPos i = 1; i < n; i++) {
+        if (i == window_end) {
+            window_start = i;
+            lcp = section_window(array, array->lcp, array->lcp_offset, i, &window_end);
+        }
+        TextPos h = lcp[i - window_start];
+        if (h > result.length) {
+            result.length = h;
+            first = i;
+            last = i;
+        }
+        else if (last == i - 1 && result.length > 0 && h >= result.length) {
+            last = i;
+        }
+    }
+    if (result.length == 0) return result;
+
+    // the interval of suffixes sharing the repeat: [first - 1 .. last]
+    result.count = last - first + 2;
+    result.positions = (TextPos*)malloc(result.count * sizeof(TextPos));
+    if (!result.positions) {
+        perror("Could not allocate memory for repeat positions");
+        exit(1);
+    }
+    for (TextPos i = 0; i < result.count; ) {
+        const TextPos* sa = section_window(array, array->sa, array->sa_offset, first - 1 + i, &window_end);
+        for (TextPos j = 0; first - 1 + i < window_end && i < result.count; j++) {
+            result.positions[i++] = sa[j];
+        }
+    }
+
+    return result;
+}
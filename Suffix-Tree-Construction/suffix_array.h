@@ -0,0 +1,158 @@
+#ifndef SUFFIX_ARRAY_H
+#define SUFFIX_ARRAY_H
+
+#include "types.h"
+#include "suffix_tree.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdint.h>
+
+// SA-IS
+/**
+ * Sorts all suffixes of a text in linear time by induced sorting (Nong, Zhang & Chan).
+ * The text must end with a unique character that is smaller than every other character (i.e., $ = rank 0).
+ * Besides @sa, only a bit per character for the L/S types and the bucket array are allocated;
+ * recursion runs on the reduced string stored inside @sa itself.
+ * @text: characters as ranks, uint8_t if @char_size is 1, TextPos if @char_size is sizeof(TextPos)
+ * @sa: [n] output suffix array
+ * @n: length of text (including the sentinel)
+ * @max_char: largest rank in the text
+ * @char_size: size in bytes of one character of the text
+ */
+void sa_is(const void* text, TextPos* sa, TextPos n, TextPos max_char, int char_size);
+
+// Kasai LCP
+/**
+ * Computes the LCP array from the suffix array in linear time (Kasai et al.):
+ * walking suffixes in text order, the LCP with the lexicographic predecessor drops by at most 1 per step.
+ * @array: suffix array whose lcp field is filled
+ */
+void compute_lcp_array(SuffixArray* array);
+
+// Kasai LCP of a bare suffix array
+/**
+ * Same as compute_lcp_array for a suffix array that is not wrapped in a SuffixArray.
+ * @s: text (ends with $)
+ * @sa: [n] suffix array of s
+ * @lcp: [n] output LCP array (lcp[0] = 0)
+ * @n: length of s (including $)
+ */
+void kasai_lcp(const char* s, const TextPos* sa, TextPos* lcp, TextPos n);
+
+// Kasai LCP of a range of text positions
+/**
+ * The steps of kasai_lcp for the suffixes starting at @lo...@hi-1, from h = 0 at @lo. Ranges write
+ * disjoint LCP entries, so threads can fill one LCP array over a split of 0...n-1; each range start
+ * costs at most one extra comparison of an LCP's length.
+ * @rank: [n] inverse of sa
+ */
+void kasai_lcp_range(const char* s, const TextPos* sa, const TextPos* rank, TextPos* lcp, TextPos n, TextPos lo, TextPos hi);
+
+#define COVER_MIN_PERIOD 64
+#define COVER_MAX_PERIOD 4096
+
+// CoverSampleBytes
+/**
+ * Peak bytes used by build_cover_sample for period v, and the bytes it keeps once built (@kept).
+ */
+size_t cover_sample_bytes(TextPos n, int period, size_t* kept);
+
+// BuildCoverSample
+/**
+ * Ranks the suffixes of a difference cover sample: D = {0...r-1} and the multiples of r below v,
+ * r = sqrt(v), about 2 sqrt(v) residues of every v. Sampled suffixes are sorted by their first v
+ * characters and named; the names of each residue class, in text order, are concatenated into a
+ * reduced string, whose suffix array (SA-IS) orders the sampled suffixes (the last name of every class
+ * contains the $, so it is unique and comparisons never run into the next class).
+ * @s: text (ends with $)
+ * @char_rank: rank of every character of s
+ * @n: length of s (including $)
+ * @period: v, a power of two from COVER_MIN_PERIOD to COVER_MAX_PERIOD
+ * @returns - sample for sort_suffixes, released by free_cover_sample (keeps pointers to s and char_rank)
+ */
+CoverSample* build_cover_sample(const char* s, const int16_t* char_rank, TextPos n, int period);
+
+// Steps of build_cover_sample, for builders that sort and name the sampled suffixes in parallel
+/**
+ * init_cover_sample sets up the cover and residue classes (rank is still NULL); sample_slot is the slot of a
+ * sampled position in @names and rank.
+ * sort_sample_prefixes sorts sampled suffixes that share their first @depth characters by their first v.
+ * name_sample_prefixes gives a sorted run of them names 1, 2, ... (equal v-prefixes share a name) in the
+ * slots of @names and returns the number of names.
+ * rank_cover_sample takes @names ([sample_size + 1], names 1...@num_names in every slot, in v-prefix order)
+ * and turns them into the ranks of the sampled suffixes; the sample owns @names afterwards.
+ */
+CoverSample* init_cover_sample(const char* s, const int16_t* char_rank, TextPos n, int period);
+TextPos sample_slot(const CoverSample* sample, TextPos i);
+void sort_sample_prefixes(const CoverSample* sample, TextPos* pos, TextPos count, TextPos depth, TextPos* scratch);
+TextPos name_sample_prefixes(const CoverSample* sample, const TextPos* pos, TextPos count, TextPos depth, TextPos* names);
+void rank_cover_sample(CoverSample* sample, TextPos* names, TextPos num_names);
+
+// FreeCoverSample
+void free_cover_sample(CoverSample* sample);
+
+// SortSuffixes
+/**
+ * Sorts suffixes that share their first @depth characters by merge sort, comparing two of them up to
+ * the first offset where both are sampled and then by sample rank: O(m log m) comparisons of at most
+ * about 2 sqrt(v) characters each, however repetitive the text. Safe to call from several threads.
+ * @sample: difference cover sample of the text
+ * @pos: [count] suffixes to sort
+ * @count: number of suffixes
+ * @depth: length of their known common prefix
+ * @scratch: buffer of at least count positions
+ */
+void sort_suffixes(const CoverSample* sample, TextPos* pos, TextPos count, TextPos depth, TextPos* scratch);
+
+// BuildSuffixArray
+/**
+ * Builds the suffix array (SA-IS) and LCP array (Kasai) of a sequence.
+ * Suffixes are ordered by alphabet rank, the same order as the leaves of the suffix tree.
+ * @sequence_string: full sequence string (ends with $)
+ * @alphabet: alphabet the sequence is comprised of (including $)
+ * @returns - suffix array owning its arrays, sequence and alphabet; free_suffix_array releases it
+ */
+SuffixArray* build_suffix_array(const char* sequence_string, const char* alphabet);
+
+// FreeSuffixArray
+void free_suffix_array(SuffixArray* array);
+
+// Stats
+/**
+ * Reports the same statistics as print_tree_stats, from the lcp-intervals of the LCP array:
+ * every internal node of the suffix tree is an lcp-interval [i..j] whose string-depth is the
+ * minimum LCP inside it, so one pass with a stack of open intervals visits every internal node.
+ */
+void print_tree_stats_sa(const SuffixArray* array);
+
+// BWT index
+/**
+ * Writes the same BWT as compute_bwt_index: B[i] = s[SA[i] - 1], or $ when SA[i] = 0.
+ */
+void compute_bwt_index_sa(const SuffixArray* array, const char* sequence_file, BwtFormat format);
+
+// BWT without a tree
+/**
+ * Computes the BWT directly by induced sorting: SA-IS fills a suffix array, which is then overwritten
+ * in place by the BWT (character i is written at or before the bytes of SA[i], which are already read)
+ * and shrunk to n + 1 bytes. No tree, LCP array or leaf order is built, so the peak is the sequence,
+ * its n byte ranks and the n * sizeof(TextPos) suffix array, about 6n bytes in the compact build.
+ * Matches compute_bwt_index byte for byte.
+ * @sequence_string: full sequence string (ends with $)
+ * @alphabet: alphabet the sequence is comprised of (including $)
+ * @returns - null-terminated BWT of n characters
+ */
+char* build_bwt_direct(const char* sequence_string, const char* alphabet);
+
+// reporting space used by the suffix and LCP arrays relative to the seq string size
+void report_space_usage_sa(const SuffixArray* array);
+
+// finding longest repeated substrings
+/**
+ * The longest repeat is the maximum LCP value; its occurrences are the suffixes of the
+ * first lcp-interval reaching that value, listed in lexicographic order like find_repeats.
+ */
+LongestRepeat find_repeats_sa(const SuffixArray* array);
+
+#endif
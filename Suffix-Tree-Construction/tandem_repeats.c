@@ -0,0 +1,270 @@
+#include "tandem_repeats.h"
+#include "input_stream.h"
+
+// helper function: sparse table over the block minima of lce->lcp (rank and lcp already filled)
+void build_lce_blocks(LCEIndex* lce) {
+    TextPos n = lce->n;
+    lce->num_blocks = (n + LCE_BLOCK - 1) / LCE_BLOCK;
+    lce->levels = 1;
+    while (((TextPos)1 << lce->levels) <= lce->num_blocks) lce->levels++;
+
+    lce->block_min = (TextPos*)malloc((size_t)lce->levels * lce->num_blocks * sizeof(TextPos));
+    if (!lce->block_min) {
+        perror("Could not allocate memory for LCE index");
+        exit(1);
+    }
+
+    for (TextPos j = 0; j < lce->num_blocks; j++) {
+        TextPos end = (j + 1) * LCE_BLOCK < n ? (j + 1) * LCE_BLOCK : n;
+        TextPos min = lce->lcp[j * LCE_BLOCK];
+        for (TextPos r = j * LCE_BLOCK + 1; r < end; r++) {
+            if (lce->lcp[r] < min) min = lce->lcp[r];
+        }
+        lce->block_min[j] = min;
+    }
+    for (int k = 1; k < lce->levels; k++) {
+        const TextPos* prev = lce->block_min + (size_t)(k - 1) * lce->num_blocks;
+        TextPos* row = lce->block_min + (size_t)k * lce->num_blocks;
+        for (TextPos j = 0; j + ((TextPos)1 << k) <= lce->num_blocks; j++) {
+            TextPos a = prev[j];
+            TextPos b = prev[j + ((TextPos)1 << (k - 1))];
+            row[j] = (a < b) ? a : b;
+        }
+    }
+}
+
+// helper function: LCP of the first leaf below a node with the leaf before it (context: LCEIndex with ranks)
+bool neighbour_lcp(const SuffixTree* st, NodeId node, TextPos level, void* context) {
+    const NodeTable* tree = &st->nodes;
+    LCEIndex* lce = (LCEIndex*)context;
+    if (is_root(tree, node)) return true;
+
+    NodeId parent = node_parent(tree, node);
+    if (first_child(tree, parent) != node) {
+        TextPos rank = is_leaf(tree, node) ? lce->rank[node] : st->leaf_first[node - tree->str_len];
+        lce->lcp[rank] = node_depth(tree, parent);
+    }
+    return true;
+}
+
+// LCE index from the suffix tree
+void init_lce_index_tree(LCEIndex* lce, const SuffixTree* st) {
+    const NodeTable* tree = &st->nodes;
+    TextPos n = tree->str_len;
+
+    lce->n = n;
+    lce->rank = (TextPos*)malloc(n * sizeof(TextPos));
+    lce->lcp = (TextPos*)malloc(n * sizeof(TextPos));
+    if (!lce->rank || !lce->lcp) {
+        perror("Could not allocate memory for LCE index");
+        exit(1);
+    }
+    for (TextPos r = 0; r < n; r++) {
+        lce->rank[st->leaf_order[r]] = r;
+    }
+
+    // a node that is not its parent's first child starts a leaf that shares exactly its parent's depth
+    // with the leaf before it
+    lce->lcp[0] = 0;
+    visit_tree(st, tree->root, neighbour_lcp, NULL, lce);
+
+    build_lce_blocks(lce);
+}
+
+// LCE index from a suffix array
+void init_lce_index_sa(LCEIndex* lce, const SuffixArray* array) {
+    TextPos n = array->str_len;
+
+    lce->n = n;
+    lce->rank = (TextPos*)malloc(n * sizeof(TextPos));
+    lce->lcp = (TextPos*)malloc(n * sizeof(TextPos));
+    if (!lce->rank || !lce->lcp) {
+        perror("Could not allocate memory for LCE index");
+        exit(1);
+    }
+    for (TextPos r = 0; r < n; r++) {
+        lce->rank[array->sa[r]] = r;
+    }
+    memcpy(lce->lcp, array->lcp, n * sizeof(TextPos));
+
+    build_lce_blocks(lce);
+}
+
+void free_lce_index(LCEIndex* lce) {
+    free(lce->rank);
+    free(lce->lcp);
+    free(lce->block_min);
+    lce->rank = NULL;
+    lce->lcp = NULL;
+    lce->block_min = NULL;
+}
+
+// LCE
+TextPos lce_query(const LCEIndex* lce, TextPos x, TextPos y) {
+    TextPos lo = lce->rank[x];
+    TextPos hi = lce->rank[y];
+    if (lo > hi) {
+        TextPos temp = lo;
+        lo = hi;
+        hi = temp;
+    }
+    lo++; // minimum of lcp[lo + 1...hi]
+
+    TextPos first_block = lo / LCE_BLOCK;
+    TextPos last_block = hi / LCE_BLOCK;
+    TextPos min = lce->lcp[lo];
+    if (last_block - first_block < 2) {
+        for (TextPos r = lo + 1; r <= hi; r++) {
+            if (lce->lcp[r] < min) min = lce->lcp[r];
+        }
+        return min;
+    }
+
+    // partial blocks at both ends, whole blocks in between from the sparse table
+    for (TextPos r = lo + 1; r < (first_block + 1) * LCE_BLOCK; r++) {
+        if (lce->lcp[r] < min) min = lce->lcp[r];
+    }
+    for (TextPos r = last_block * LCE_BLOCK; r <= hi; r++) {
+        if (lce->lcp[r] < min) min = lce->lcp[r];
+    }
+    TextPos from = first_block + 1;
+    TextPos count = last_block - from;
+    int k = 63 - __builtin_clzll((unsigned long long)count);
+    const TextPos* row = lce->block_min + (size_t)k * lce->num_blocks;
+    if (row[from] < min) min = row[from];
+    if (row[last_block - ((TextPos)1 << k)] < min) min = row[last_block - ((TextPos)1 << k)];
+    return min;
+}
+
+// helper function: common prefix of the suffixes at x < y; most are short, so compare a few characters first
+TextPos forward_extension(const char* s, const LCEIndex* lce, TextPos x, TextPos y) {
+    TextPos k = 0;
+    while (k < LCE_DIRECT && s[x + k] == s[y + k]) k++; // $ is unique, so this stops at the end
+    return (k < LCE_DIRECT) ? k : lce_query(lce, x, y);
+}
+
+// helper function: common suffix of s[0...x-1] and s[0...y-1] (x < y), from the reversed sequence's index
+TextPos backward_extension(const char* s, const LCEIndex* reverse_lce, TextPos m, TextPos x, TextPos y) {
+    TextPos k = 0;
+    while (k < LCE_DIRECT && k < x && s[x - 1 - k] == s[y - 1 - k]) k++;
+    if (k < LCE_DIRECT) return k;
+    TextPos l = lce_query(reverse_lce, m - x, m - y);
+    return (l < x) ? l : x;
+}
+
+// TandemsFileName
+void tandems_file_name(const char* sequence_file, char* output_filename, size_t size) {
+    snprintf(output_filename, size, "%.*s_tandems.tsv",
+             (int)input_file_stem_length(sequence_file),
+             sequence_file);
+}
+
+// FindTandemRepeats
+int find_tandem_repeats(const SuffixTree* st, TextPos min_length, const char* filename, long long* num_tandems) {
+    TextPos m = st->str_len - 1; // characters before $
+    *num_tandems = 0;
+
+    if (!st->leaf_order) {
+        fprintf(stderr, "Error: tandem repeats need the leaf intervals (annotate_leaf_intervals)\n");
+        return -1;
+    }
+
+    // the direct comparisons run on bytes: unpack a packed text for the duration of the search
+    char* unpacked = NULL;
+    if (st->packed.words) {
+        unpacked = (char*)malloc(st->str_len + 1);
+        if (!unpacked) {
+            perror("Could not allocate memory for the unpacked sequence");
+            exit(1);
+        }
+        unpack_text(&st->packed, st->alphabet, unpacked);
+    }
+    const char* s = unpacked ? unpacked : st->sequence;
+
+    FILE* file = fopen(filename, "w");
+    if (!file) {
+        perror("Error opening tandem repeats file");
+        free(unpacked);
+        return -1;
+    }
+    setvbuf(file, NULL, _IOFBF, 1 << 20);
+    fprintf(file, "start\tperiod\tcopies\tlength\n");
+
+    LCEIndex lce;
+    init_lce_index_tree(&lce, st);
+
+    // backward extensions are forward extensions of the reversed sequence: s[x - 1 - k] = reversed[m - x + k]
+    char* reversed = (char*)malloc(m + 2);
+    if (!reversed) {
+        perror("Could not allocate memory for the reversed sequence");
+        exit(1);
+    }
+    for (TextPos i = 0; i < m; i++) {
+        reversed[i] = s[m - 1 - i];
+    }
+    reversed[m] = '$';
+    reversed[m + 1] = '\0';
+    SuffixArray* reversed_array = build_suffix_array(reversed, st->alphabet);
+    free(reversed);
+    LCEIndex reverse_lce;
+    init_lce_index_sa(&reverse_lce, reversed_array);
+    free_suffix_array(reversed_array);
+
+    // smallest prime factor of every period, for the primitivity checks
+    TextPos max_period = m / 2;
+    TextPos* smallest_factor = (TextPos*)calloc(max_period + 1, sizeof(TextPos));
+    if (!smallest_factor) {
+        perror("Could not allocate memory for tandem repeats");
+        exit(1);
+    }
+    for (TextPos q = 2; q <= max_period; q++) {
+        if (smallest_factor[q] != 0) continue;
+        for (long long multiple = q; multiple <= max_period; multiple += q) {
+            if (smallest_factor[multiple] == 0) smallest_factor[multiple] = q;
+        }
+    }
+
+    for (TextPos p = 1; p <= max_period; p++) {
+        if (2 * p > m) break;
+
+        for (TextPos i = 0; i + p < m; i += p) {
+            TextPos forward = forward_extension(s, &lce, i, i + p);
+            TextPos backward = (i > 0) ? backward_extension(s, &reverse_lce, m, i, i + p) : 0;
+            if (backward + forward < p) continue;
+
+            TextPos start = i - backward;
+            TextPos length = backward + forward + p;
+
+            // runs of one period overlap by less than p, so the next one starts beyond end - p
+            i = ((start + length - p) / p) * p;
+
+            if (length < min_length) continue;
+
+            // smallest period divides p: check p / q for every prime factor q
+            bool primitive = true;
+            for (TextPos rest = p; rest > 1 && primitive; ) {
+                TextPos q = smallest_factor[rest];
+                TextPos d = p / q;
+                if (forward_extension(s, &lce, start, start + d) >= length - d) primitive = false;
+                while (rest % q == 0) rest /= q;
+            }
+            if (!primitive) continue;
+
+            fprintf(file, "%lld\t%lld\t%lld\t%lld\n", (long long)start, (long long)p, (long long)(length / p), (long long)length);
+            (*num_tandems)++;
+        }
+    }
+
+    free(smallest_factor);
+    free(unpacked);
+    free_lce_index(&lce);
+    free_lce_index(&reverse_lce);
+
+    int ok = !ferror(file);
+    if (fclose(file) != 0) ok = 0;
+    if (!ok) {
+        perror("Error writing tandem repeats file");
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,63 @@
+#ifndef TANDEM_REPEATS_H
+#define TANDEM_REPEATS_H
+
+#include "types.h"
+#include "suffix_tree.h"
+#include "suffix_array.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdint.h>
+
+#define LCE_DIRECT 16 // characters compared directly before an LCE query falls back to the index
+
+// LCE index from the suffix tree
+/**
+ * Ranks are the inverse of leaf_order and the LCP of neighbouring leaves is the string-depth of the
+ * node where the walk over the leaves turns to the next sibling. Requires annotate_leaf_intervals.
+ * @lce: index to fill
+ */
+void init_lce_index_tree(LCEIndex* lce, const SuffixTree* st);
+
+// LCE index from a suffix array
+/**
+ * @lce: index to fill (ranks from sa, lcp copied)
+ * @array: suffix array with its LCP array
+ */
+void init_lce_index_sa(LCEIndex* lce, const SuffixArray* array);
+
+void free_lce_index(LCEIndex* lce);
+
+// LCE
+/**
+ * Length of the longest common prefix of the suffixes starting at @x and @y (x != y) in O(LCE_BLOCK).
+ */
+TextPos lce_query(const LCEIndex* lce, TextPos x, TextPos y);
+
+// TandemsFileName
+/**
+ * Gets the name of the tandem repeats file of a sequence file: <sequence file without extension>_tandems.tsv
+ * @sequence_file: name of the file the sequence was read from
+ * @output_filename: buffer receiving the name
+ * @size: size of the buffer
+ */
+void tandems_file_name(const char* sequence_file, char* output_filename, size_t size);
+
+// FindTandemRepeats
+/**
+ * Streams every primitive tandem array (maximal run s[start...start + length - 1] with smallest period
+ * `period` and length >= 2 * period) of total length >= @min_length to a TSV file (start, period, copies, length).
+ * Main-Lorentz style with LCE queries: a run of period p covers two consecutive multiples i, i + p of p, where
+ * the forward extension (LCE of i and i + p, from the tree's leaf ranks) and the backward extension (LCE in
+ * the reversed sequence, from its suffix array) add up to at least p. Checking every multiple of every p
+ * takes n/1 + n/2 + ... = O(n log n) constant-time LCE queries. A run is primitive if no p/q (q a prime
+ * factor of p) is also a period of it. Requires annotate_leaf_intervals; single-sequence trees only.
+ * @st: annotated tree of the sequence
+ * @min_length: shortest run reported
+ * @filename: TSV file to write
+ * @num_tandems: receives the number of runs written
+ * @returns - 0 on success, -1 if the file could not be written or the tree is not annotated
+ */
+int find_tandem_repeats(const SuffixTree* st, TextPos min_length, const char* filename, long long* num_tandems);
+
+#endif
@@ -0,0 +1,275 @@
+#include "tree_io.h"
+#include "input_stream.h"
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// helper function: round a size up to the 8-byte section alignment
+size_t align8(size_t size) {
+    return (size + 7) & ~(size_t)7;
+}
+
+// helper function: the tree's arrays in file order, as slots to read or assign, with their sizes in bytes
+void tree_sections(SuffixTree* st, void** slots[TREE_FILE_SECTIONS], size_t sizes[TREE_FILE_SECTIONS]) {
+    NodeTable* tree = &st->nodes;
+    size_t n = tree->str_len;
+    size_t internal = tree->internal_count;
+    size_t dense = (size_t)tree->dense_count * tree->alphabet_size;
+    int i = 0;
+
+    slots[i] = (void**)&st->sequence;           sizes[i++] = n + 1;
+    slots[i] = (void**)&st->alphabet;           sizes[i++] = st->alphabet_size + 1;
+    slots[i] = (void**)&tree->leaf_parent;      sizes[i++] = n * sizeof(NodeId);
+    slots[i] = (void**)&tree->leaf_next_sibling; sizes[i++] = n * sizeof(NodeId);
+    slots[i] = (void**)&tree->leaf_branch;      sizes[i++] = n * sizeof(uint8_t);
+    slots[i] = (void**)&tree->depth;            sizes[i++] = internal * sizeof(TextPos);
+    slots[i] = (void**)&tree->edge_start;       sizes[i++] = internal * sizeof(TextPos);
+    slots[i] = (void**)&tree->parent;           sizes[i++] = internal * sizeof(NodeId);
+    slots[i] = (void**)&tree->suff_link;        sizes[i++] = internal * sizeof(NodeId);
+    slots[i] = (void**)&tree->first_child;      sizes[i++] = internal * sizeof(NodeId);
+    slots[i] = (void**)&tree->next_sibling;     sizes[i++] = internal * sizeof(NodeId);
+    slots[i] = (void**)&tree->branch;           sizes[i++] = internal * sizeof(uint8_t);
+    slots[i] = (void**)&tree->child_count;      sizes[i++] = internal * sizeof(uint32_t);
+    slots[i] = (void**)&tree->dense_slot;       sizes[i++] = internal * sizeof(TextPos);
+    slots[i] = (void**)&tree->dense_children;   sizes[i++] = dense * sizeof(NodeId);
+    slots[i] = NULL;                            sizes[i++] = 0; // reserved
+}
+
+// TreeFileName
+void tree_file_name(const char* sequence_file, char* output_filename, size_t size) {
+    snprintf(output_filename, size, "%.*s.stree",
+             (int)input_file_stem_length(sequence_file),
+             sequence_file);
+}
+
+// Hashing
+uint64_t sequence_hash(const char* sequence_string) {
+    uint64_t h = 0xcbf29ce484222325ULL; // FNV offset basis
+    for (const unsigned char* p = (const unsigned char*)sequence_string; *p; p++) {
+        h ^= *p;
+        h *= 0x100000001b3ULL; // FNV prime
+    }
+    return h;
+}
+
+uint64_t checksum_words(uint64_t h, const uint8_t* data, size_t size) {
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        memcpy(&word, data + i, 8);
+        h = ((h << 5) | (h >> 59)) ^ word;
+        h *= 0x9e3779b97f4a7c15ULL;
+    }
+    if (i < size) {
+        uint64_t word = 0;
+        memcpy(&word, data + i, size - i);
+        h = ((h << 5) | (h >> 59)) ^ word;
+        h *= 0x9e3779b97f4a7c15ULL;
+    }
+    return h;
+}
+
+// SaveSuffixTree
+int save_suffix_tree(const SuffixTree* st, const char* filename) {
+    // the file keeps the sequence as bytes (so it maps like any other): unpack a packed text into a view
+    SuffixTree view = *st;
+    char* unpacked = NULL;
+    if (st->packed.words) {
+        unpacked = (char*)malloc(st->str_len + 1);
+        if (!unpacked) {
+            perror("Could not allocate memory for the unpacked sequence");
+            exit(1);
+        }
+        unpack_text(&st->packed, st->alphabet, unpacked);
+        view.sequence = unpacked;
+    }
+    st = &view;
+
+    void** slots[TREE_FILE_SECTIONS];
+    size_t sizes[TREE_FILE_SECTIONS];
+    tree_sections((SuffixTree*)st, slots, sizes); // only reads through the slots
+
+    TreeFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, TREE_FILE_MAGIC, sizeof(header.magic));
+    header.version = TREE_FILE_VERSION;
+    header.endian_check = TREE_FILE_ENDIAN_CHECK;
+    header.node_id_size = sizeof(NodeId);
+    header.section_count = TREE_FILE_SECTIONS;
+    header.str_len = st->str_len;
+    header.alphabet_size = st->alphabet_size;
+    header.internal_count = st->nodes.internal_count;
+    header.dense_count = st->nodes.dense_count;
+    header.sequence_hash = sequence_hash(st->sequence);
+    memcpy(header.char_rank, st->char_rank, sizeof(header.char_rank));
+
+    // lay out the sections and checksum them as they will appear in the file
+    uint64_t offset = align8(sizeof(TreeFileHeader));
+    uint64_t checksum = 0;
+    for (int i = 0; i < TREE_FILE_SECTIONS; i++) {
+        header.section_offset[i] = offset;
+        if (sizes[i] > 0) {
+            checksum = checksum_words(checksum, (const uint8_t*)*slots[i], sizes[i]);
+        }
+        offset += align8(sizes[i]);
+    }
+    header.checksum = checksum;
+    header.file_size = offset;
+
+    FILE* file = fopen(filename, "wb");
+    if (!file) {
+        perror("Error opening tree file");
+        free(unpacked);
+        return -1;
+    }
+
+    static const uint8_t padding[8] = {0};
+    int ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    ok = ok && fwrite(padding, 1, align8(sizeof(header)) - sizeof(header), file) == align8(sizeof(header)) - sizeof(header);
+    for (int i = 0; ok && i < TREE_FILE_SECTIONS; i++) {
+        if (sizes[i] == 0) continue;
+        ok = fwrite(*slots[i], 1, sizes[i], file) == sizes[i];
+        ok = ok && fwrite(padding, 1, align8(sizes[i]) - sizes[i], file) == align8(sizes[i]) - sizes[i];
+    }
+    free(unpacked);
+
+    if (fclose(file) != 0 || !ok) {
+        perror("Error writing tree file");
+        return -1;
+    }
+
+    printf("Suffix tree written to: %s (%llu bytes)\n", filename, (unsigned long long)header.file_size);
+    return 0;
+}
+
+// helper function: map (or read) a whole file read-only
+void* map_tree_file(const char* filename, size_t* size) {
+#ifdef _WIN32
+    FILE* file = fopen(filename, "rb");
+    if (!file) return NULL;
+
+    fseek(file, 0, SEEK_END);
+    long length = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    void* data = (length > 0) ? malloc(length) : NULL;
+    if (!data || fread(data, 1, length, file) != (size_t)length) {
+        free(data);
+        fclose(file);
+        return NULL;
+    }
+    fclose(file);
+    *size = length;
+    return data;
+#else
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) return NULL;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+        close(fd);
+        return NULL;
+    }
+    void* data = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // the mapping keeps the file alive
+    if (data == MAP_FAILED) return NULL;
+
+    *size = info.st_size;
+    return data;
+#endif
+}
+
+// Unmap
+void unmap_tree_file(void* mapping, size_t size) {
+#ifdef _WIN32
+    (void)size;
+    free(mapping);
+#else
+    munmap(mapping, size);
+#endif
+}
+
+// LoadSuffixTree
+SuffixTree* load_suffix_tree(const char* filename, const char* sequence_string, const char* alphabet) {
+    size_t size = 0;
+    uint8_t* data = (uint8_t*)map_tree_file(filename, &size);
+    if (!data) {
+        fprintf(stderr, "Tree file %s could not be opened\n", filename);
+        return NULL;
+    }
+
+    const TreeFileHeader* header = (const TreeFileHeader*)data;
+    const char* reason = NULL;
+    if (size < sizeof(TreeFileHeader) || memcmp(header->magic, TREE_FILE_MAGIC, sizeof(header->magic)) != 0) {
+        reason = "not a tree file";
+    }
+    else if (header->version != TREE_FILE_VERSION || header->section_count != TREE_FILE_SECTIONS) {
+        reason = "unsupported version";
+    }
+    else if (header->endian_check != TREE_FILE_ENDIAN_CHECK || header->node_id_size != sizeof(NodeId)) {
+        reason = "built for a different byte order or NodeId width";
+    }
+    else if (header->file_size != size) {
+        reason = "truncated";
+    }
+    else if (header->str_len != (int64_t)strlen(sequence_string) || header->sequence_hash != sequence_hash(sequence_string)) {
+        reason = "stale (built from a different sequence)";
+    }
+    else if (header->alphabet_size != (int32_t)strlen(alphabet)) {
+        reason = "stale (built with a different alphabet)";
+    }
+    else if (header->checksum != checksum_words(0, data + align8(sizeof(TreeFileHeader)), size - align8(sizeof(TreeFileHeader)))) {
+        reason = "checksum mismatch";
+    }
+
+    SuffixTree* st = NULL;
+    if (!reason) {
+        st = (SuffixTree*)calloc(1, sizeof(SuffixTree));
+        if (!st) {
+            perror("Could not allocate memory for suffix tree");
+            exit(1);
+        }
+        st->str_len = header->str_len;
+        st->alphabet_size = header->alphabet_size;
+        memcpy(st->char_rank, header->char_rank, sizeof(st->char_rank));
+
+        NodeTable* tree = &st->nodes;
+        tree->str_len = header->str_len;
+        tree->alphabet_size = header->alphabet_size;
+        tree->root = (NodeId)header->str_len;
+        tree->internal_count = header->internal_count;
+        tree->internal_capacity = header->internal_count; // read-only: no room to grow
+        tree->dense_count = header->dense_count;
+        tree->dense_capacity = header->dense_count;
+
+        // point every array into the mapping, checking each section lies inside the file
+        void** slots[TREE_FILE_SECTIONS];
+        size_t sizes[TREE_FILE_SECTIONS];
+        tree_sections(st, slots, sizes);
+        for (int i = 0; i < TREE_FILE_SECTIONS && !reason; i++) {
+            uint64_t offset = header->section_offset[i];
+            if (offset % 8 != 0 || offset > size || sizes[i] > size - offset) {
+                reason = "corrupt section table";
+            }
+            else if (slots[i]) {
+                *slots[i] = data + offset;
+            }
+        }
+        if (!reason && (st->sequence[st->str_len] != '\0' || strcmp(st->alphabet, alphabet) != 0)) {
+            reason = "stale (built with a different alphabet)";
+        }
+    }
+
+    if (reason) {
+        fprintf(stderr, "Tree file %s rejected: %s\n", filename, reason);
+        free(st);
+        unmap_tree_file(data, size);
+        return NULL;
+    }
+
+    st->mapping = data;
+    st->mapping_size = size;
+    return st;
+}
@@ -0,0 +1,80 @@
+#ifndef TREE_IO_H
+#define TREE_IO_H
+
+#include "types.h"
+#include "packed_text.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdint.h>
+
+#define TREE_FILE_MAGIC "STREEIDX"
+#define TREE_FILE_VERSION 3
+#define TREE_FILE_ENDIAN_CHECK 0x01020304u
+
+// TreeFileName
+/**
+ * Gets the name of the tree file of a sequence file: <sequence file without extension>.stree
+ * @sequence_file: name of the file the sequence was read from
+ * @output_filename: buffer receiving the name
+ * @size: size of the buffer
+ */
+void tree_file_name(const char* sequence_file, char* output_filename, size_t size);
+
+// helper function: round a size up to the 8-byte section alignment
+size_t align8(size_t size);
+
+// Hashing
+/**
+ * FNV-1a hash of a sequence string, stored in the tree file to detect a stale index.
+ */
+uint64_t sequence_hash(const char* sequence_string);
+
+/**
+ * Continues a checksum over a byte range, one 64-bit word at a time (a partial last word is zero-padded).
+ * @h: checksum so far (0 to start)
+ * @data: bytes to add
+ * @size: number of bytes
+ */
+uint64_t checksum_words(uint64_t h, const uint8_t* data, size_t size);
+
+// SaveSuffixTree
+/**
+ * Writes a constructed tree to a tree file: a TreeFileHeader followed by the sequence, the alphabet
+ * and the node table arrays (only the internal nodes and dense blocks in use), each at an 8-byte
+ * aligned offset. Ids are indices, so nothing needs relocating when the file is loaded.
+ * @st: tree to save
+ * @filename: name of the tree file
+ * @returns - 0 on success, -1 if the file could not be written
+ */
+int save_suffix_tree(const SuffixTree* st, const char* filename);
+
+// LoadSuffixTree
+/**
+ * Maps a tree file read-only and returns a tree whose arrays point into the mapping, without construction.
+ * Only the pages a query touches are faulted in, apart from the single checksum pass over the file.
+ * The file is rejected (NULL) if it is missing, corrupt (magic, version, layout or checksum), was built
+ * with a different NodeId width or byte order, or was built from another sequence or alphabet.
+ * @filename: name of the tree file
+ * @sequence_string: sequence the caller expects the tree to index (ends with $)
+ * @alphabet: alphabet the caller expects (including $)
+ * @returns - read-only tree released by free_suffix_tree, or NULL (the caller rebuilds)
+ */
+SuffixTree* load_suffix_tree(const char* filename, const char* sequence_string, const char* alphabet);
+
+// Map
+/**
+ * Maps a whole file read-only (reads it into a heap copy where mmap is unavailable).
+ * @filename: name of the file
+ * @size: receives the size of the file
+ * @returns - start of the mapping, or NULL if the file is missing or empty
+ */
+void* map_tree_file(const char* filename, size_t* size);
+
+// Unmap
+/**
+ * Releases a mapping made by map_tree_file or load_suffix_tree (a heap copy where mmap is unavailable).
+ */
+void unmap_tree_file(void* mapping, size_t size);
+
+#endif
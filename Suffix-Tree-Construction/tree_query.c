@@ -0,0 +1,133 @@
+#include "tree_query.h"
+
+// helper function: ascending order for qsort
+int compare_leaf_positions(const void* a, const void* b) {
+    TextPos x = *(const TextPos*)a;
+    TextPos y = *(const TextPos*)b;
+    return (x > y) - (x < y);
+}
+
+// Locus
+NodeId find_locus(const SuffixTree* st, const char* pattern) {
+    const NodeTable* tree = &st->nodes;
+    NodeId node = tree->root;
+
+    TextPos m = (TextPos)strlen(pattern);
+
+    for (TextPos i = 0; i < m; ) {
+        int c = st->char_rank[(unsigned char)pattern[i]];
+        if (c <= 0) return NO_NODE; // not in the alphabet (or $)
+
+        NodeId child = get_child(tree, node, c);
+        if (child == NO_NODE) return NO_NODE;
+
+        // the first character already matched by the branch
+        TextPos start = edge_start(tree, child);
+        TextPos end = edge_end(tree, child);
+        i++;
+        TextPos max = (end - start < m - i) ? end - start : m - i;
+        if (st->packed.words) {
+            for (TextPos k = 0; k < max; k++) {
+                if (packed_rank(&st->packed, start + 1 + k) != st->char_rank[(unsigned char)pattern[i + k]]) return NO_NODE;
+            }
+        } else if (match_length(st->sequence + start + 1, pattern + i, max) < max) {
+            return NO_NODE;
+        }
+        i += max;
+        node = child;
+    }
+
+    return node;
+}
+
+// helper function for the leaf range: counts a leaf and records it if positions are wanted (context: LongestRepeat)
+bool query_leaf(const SuffixTree* st, NodeId node, TextPos level, void* context) {
+    if (is_leaf(&st->nodes, node)) {
+        LongestRepeat* leaves = (LongestRepeat*)context;
+        if (leaves->positions) leaves->positions[leaves->count] = (TextPos)node;
+        leaves->count++;
+    }
+    return true;
+}
+
+// Leaf range
+TextPos collect_leaves(const SuffixTree* st, NodeId node, TextPos* positions) {
+    const NodeTable* tree = &st->nodes;
+
+    // annotated trees: an O(1) count and a contiguous slice
+    if (st->leaf_order && (!positions || !is_leaf(tree, node))) {
+        TextPos count = leaf_count(st, node);
+        if (positions) memcpy(positions, leaf_slice(st, node), count * sizeof(TextPos));
+        return count;
+    }
+
+    LongestRepeat leaves = {0, positions, 0};
+    visit_tree(st, node, query_leaf, NULL, &leaves);
+    return leaves.count;
+}
+
+// worker thread: claim batches of patterns until none are left
+void* query_worker(void* arg) {
+    QueryBatch* batch = (QueryBatch*)arg;
+
+    for (;;) {
+        int first = __atomic_fetch_add(&batch->next_pattern, QUERY_BATCH_SIZE, __ATOMIC_RELAXED);
+        if (first >= batch->num_patterns) break;
+        int last = (first + QUERY_BATCH_SIZE < batch->num_patterns) ? first + QUERY_BATCH_SIZE : batch->num_patterns;
+
+        for (int p = first; p < last; p++) {
+            NodeId locus = find_locus(batch->st, batch->patterns[p]);
+            if (locus == NO_NODE) {
+                batch->counts[p] = 0;
+                if (batch->locate) batch->positions[p] = NULL;
+                continue;
+            }
+
+            batch->counts[p] = collect_leaves(batch->st, locus, NULL);
+            if (batch->locate) {
+                TextPos* positions = (TextPos*)malloc(batch->counts[p] * sizeof(TextPos));
+                if (!positions) {
+                    perror("Could not allocate memory for pattern positions");
+                    exit(1);
+                }
+                collect_leaves(batch->st, locus, positions);
+                qsort(positions, batch->counts[p], sizeof(TextPos), compare_leaf_positions);
+                batch->positions[p] = positions;
+            }
+        }
+    }
+
+    return NULL;
+}
+
+// Batched queries
+void match_patterns(const SuffixTree* st, char** patterns, int num_patterns, bool locate, int num_threads,
+                    TextPos* counts, TextPos** positions) {
+    if (num_threads < 1) num_threads = 1;
+
+    QueryBatch batch;
+    batch.st = st;
+    batch.patterns = patterns;
+    batch.num_patterns = num_patterns;
+    batch.locate = locate;
+    batch.next_pattern = 0;
+    batch.counts = counts;
+    batch.positions = positions;
+
+    pthread_t* threads = (pthread_t*)malloc(num_threads * sizeof(pthread_t));
+    if (!threads) {
+        perror("Could not allocate memory for query threads");
+        exit(1);
+    }
+    for (int t = 0; t < num_threads; t++) {
+        if (pthread_create(&threads[t], NULL, query_worker, &batch) != 0) {
+            perror("Could not start query thread");
+            exit(1);
+        }
+    }
+    for (int t = 0; t < num_threads; t++) {
+        pthread_join(threads[t], NULL);
+    }
+
+    free(threads);
+}
@@ -0,0 +1,48 @@
+#ifndef TREE_QUERY_H
+#define TREE_QUERY_H
+
+#include "types.h"
+#include "suffix_tree.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#define QUERY_BATCH_SIZE 64 // patterns a query thread claims at a time
+
+// Locus
+/**
+ * Descends from the root along a pattern, one child lookup per edge and edge labels compared a word at a time (O(m)).
+ * @pattern: null-terminated pattern
+ * @returns - highest node whose path label starts with the pattern (its leaves are the occurrences),
+ *            or NO_NODE if the pattern does not occur
+ */
+NodeId find_locus(const SuffixTree* st, const char* pattern);
+
+// Leaf range
+/**
+ * Leaves below a node in lexicographic order: a slice of leaf_order on an annotated tree
+ * (annotate_leaf_intervals; counting is then O(1)), otherwise a visit_tree walk over the subtree.
+ * @node: node whose subtree is walked
+ * @positions: receives the leaves (suffix start positions), or NULL to only count them
+ * @returns - number of leaves below the node
+ */
+TextPos collect_leaves(const SuffixTree* st, NodeId node, TextPos* positions);
+
+// Batched queries
+/**
+ * Matches every pattern against a shared read-only tree with a pool of threads.
+ * Threads claim QUERY_BATCH_SIZE patterns at a time from a shared counter, so long and short
+ * patterns balance out across threads.
+ * @patterns: null-terminated patterns
+ * @num_patterns: number of patterns
+ * @locate: also collect the positions of every occurrence (sorted)
+ * @num_threads: number of worker threads
+ * @counts: [num_patterns] receives the number of occurrences of each pattern
+ * @positions: [num_patterns] receives the positions of each pattern (NULL if none); may be NULL when not locating
+ */
+void match_patterns(const SuffixTree* st, char** patterns, int num_patterns, bool locate, int num_threads,
+                    TextPos* counts, TextPos** positions);
+
+#endif
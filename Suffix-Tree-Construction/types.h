@@ -2,6 +2,8 @@
 #define TYPES_H
 
 #include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
 
 typedef enum bool {
     false,
@@ -14,20 +16,440 @@ typedef struct sequence {
     char *sequence;  // sequence data
  } Sequence;
 
- typedef struct node {
-    int id; // 0...n-1 (for leaves, the suffix order), n...x (internal nodes)
-    struct node* suff_link; // ptr to suffix link node
-    struct node* parent;
-    struct node** children; // array of children of size dependent on size of alphabet
-    int depth; // length of the string that leads from root to the node
-    int edge_label[2]; // [start_index, end_index], i.e., label of incoming edge from parent
- } Node;
+ // Width of text positions, lengths, depths and node ids, chosen at build time: 32-bit by default (compact),
+ // 64-bit with -DSUFFIX_TREE_64 (make POS64=1) for inputs of 2^31 characters or more. Every builder and
+ // query uses these types, so the choice costs nothing at run time in either mode.
+ // Index of a node in a NodeTable: 0...n-1 for leaves (the suffix order), n...x for internal nodes
+ #ifdef SUFFIX_TREE_64
+ typedef int64_t TextPos;
+ typedef uint64_t NodeId;
+ #define POS_MAX INT64_MAX
+ #define NO_NODE ((NodeId)UINT64_MAX)
+ #else
+ typedef int32_t TextPos;
+ typedef uint32_t NodeId;
+ #define POS_MAX INT32_MAX
+ #define NO_NODE ((NodeId)UINT32_MAX)
+ #endif
 
+ // internal nodes with more children than this get a dense child table
+ #define DENSE_FANOUT 8
+
+ // Suffix tree nodes stored as structure-of-arrays, linked through NodeId indices instead of pointers.
+ // Leaf i stores no children: its depth is n - i and its edge label is [i + parent.depth, n - 1].
+ // Children hang off first_child as a sibling list sorted by branch character (lexicographic order);
+ // nodes with more than DENSE_FANOUT children also get a dense alphabet_size block for O(1) lookup.
+ typedef struct {
+    TextPos str_len; // n, i.e., number of leaves
+    int alphabet_size; // number of distinct branch characters (including $)
+    NodeId root; // id of the root (the first internal node, n)
+    TextPos internal_count; // internal nodes handed out so far (including the root)
+    TextPos internal_capacity; // internal nodes the arrays have room for
+
+    // [n] arrays indexed by leaf id
+    NodeId* leaf_parent;
+    NodeId* leaf_next_sibling;
+    uint8_t* leaf_branch; // index in the alphabet of the first character of the incoming edge
+
+    // [internal_capacity] arrays indexed by id - n
+    TextPos* depth; // length of the string that leads from root to the node
+    TextPos* edge_start; // start index of incoming edge label; end index follows from the parent's depth
+    NodeId* parent;
+    NodeId* suff_link; // NO_NODE until known
+    NodeId* first_child; // lexicographically smallest child
+    NodeId* next_sibling;
+    uint8_t* branch;
+    uint32_t* child_count; // wide enough for the terminators of any number of records
+    TextPos* dense_slot; // block in dense_children, -1 while the node's fanout is small
+
+    NodeId* dense_children; // alphabet_size child slots per dense block, NO_NODE if empty
+    TextPos dense_count; // dense blocks handed out
+    TextPos dense_capacity; // dense blocks the pool has room for
+ } NodeTable;
+
+ // DNA text packed 2 bits per base: 32 codes per word, first character in the low bits. A, C, G, T are
+ // codes 0...3 in alphabet order. The sentinel $ (only ever the last character) is stored as code 0 and
+ // recognised by its position; N, when the alphabet has it, is code 0 with its bit set in n_mask.
+ typedef struct {
+    TextPos length; // n, including $
+    uint64_t* words; // [(n + 31) / 32 + 1] (one padding word for unaligned 32-code loads), NULL if not packed
+    uint64_t* n_mask; // [n / 64 + 2] bit per position set for N, NULL if the text has no N
+    uint8_t code_rank[4]; // alphabet index of each code (the child branch directly)
+    int n_rank; // alphabet index of N
+ } PackedText;
+
+ // A suffix tree and everything it was built from. Trees share no state with each other,
+ // so any number of them can be built, queried and freed concurrently from independent threads.
+ typedef struct {
+    char* sequence; // owned copy of the sequence string (ends with $), NULL when the text is packed
+    PackedText packed; // DNA text at 2 bits per base (packed.words NULL for other alphabets): read through text_rank
+    TextPos str_len; // length of sequence (including $)
+    char* alphabet; // owned copy of the alphabet (including $)
+    int alphabet_size;
+    int16_t char_rank[256]; // index in the alphabet of every byte value, -1 if not in the alphabet
+    NodeTable nodes; // node storage, internal node counter and root
+    void* mapping; // tree file the arrays point into (see tree_io.h), NULL if built in memory
+    size_t mapping_size;
+    // generalized trees: the sequence is every record followed by its own $ (0 records = a single sequence)
+    int num_records;
+    TextPos* record_start; // [num_records + 1] start of each record in sequence; record j ends with $ at record_start[j + 1] - 1
+    char** record_names; // [num_records] owned copies of the record names
+    // leaf intervals (annotate_leaf_intervals), NULL until annotated: the leaves below internal node n + i
+    // are leaf_order[leaf_first[i]...leaf_last[i]]
+    TextPos* leaf_order; // [n] leaves in lexicographic order (the suffix array)
+    TextPos* leaf_first; // [internal_count]
+    TextPos* leaf_last; // [internal_count] inclusive
+ } SuffixTree;
+
+ // Online (Ukkonen) construction state. The final length n is unknown while characters arrive, so nodes
+ // cannot use NodeTable ids yet: internal nodes are numbered 0, 1, ... (root = 0) and leaves are their
+ // suffix index tagged with UKK_LEAF. Leaf edges stay open ([j + parent depth, current end]) until
+ // ukkonen_finish appends $ and converts everything into a NodeTable in one pass.
+ #define UKK_LEAF ((NodeId)1 << (sizeof(NodeId) * 8 - 1))
+
+ typedef struct {
+    char* text; // characters received so far
+    TextPos length;
+    TextPos capacity; // room in text and the leaf arrays
+    char* alphabet; // owned copy of the alphabet (including $)
+    int alphabet_size;
+    int16_t char_rank[256];
+
+    // [capacity] arrays indexed by suffix index
+    NodeId* leaf_parent;
+    NodeId* leaf_next_sibling;
+    uint8_t* leaf_branch;
+
+    // [internal_capacity] arrays indexed by internal node number
+    TextPos* depth;
+    TextPos* edge_start;
+    NodeId* parent;
+    NodeId* suff_link;
+    NodeId* first_child; // sibling lists sorted by branch character
+    NodeId* next_sibling;
+    uint8_t* branch;
+    uint32_t* child_count;
+    TextPos internal_count;
+    TextPos internal_capacity;
+
+    // active point
+    NodeId active_node;
+    TextPos active_edge; // text position of the first character of the active edge
+    TextPos active_length;
+    TextPos remainder; // suffixes still to be inserted explicitly
+ } UkkonenBuilder;
+
+ // Difference cover sample: the ranks among themselves of the suffixes starting at i with i mod v in D,
+ // where every difference modulo v is a difference of two elements of D. Any two suffixes p and q reach
+ // sampled positions p + j and q + j for some j < v, so comparing them takes at most j characters and
+ // one rank lookup however long their common prefix is.
  typedef struct {
-    int length;
-    int* positions;
-    int count;
+    const char* sequence; // not owned
+    const int16_t* char_rank; // not owned
+    TextPos str_len;
+    int period; // v, a power of two
+    int shift; // log2(v)
+    int cover_size; // |D|
+    int* cover_index; // [v] index of d in D, -1 if d is not in D
+    TextPos* class_start; // [cover_size] first sample slot of each residue class
+    TextPos* rank; // [sample_size + 1] rank of each sampled suffix, slot class_start[cover_index[i mod v]] + i / v
+    TextPos sample_size;
+ } CoverSample;
+
+ // Subtrees built by one worker of the parallel builder, in private numbering: internal nodes 0, 1, ...
+ // and leaves tagged with SUBTREE_LEAF (suffix index). Leaf links are written straight into the final
+ // NodeTable's leaf arrays (every leaf belongs to exactly one bucket) and renumbered once all workers finish.
+ #define SUBTREE_LEAF ((NodeId)1 << (sizeof(NodeId) * 8 - 1))
+
+ typedef struct {
+    TextPos* depth;
+    TextPos* rep; // a suffix in the node's subtree: the incoming edge starts at rep + parent depth
+    NodeId* parent;
+    NodeId* first_child; // sibling lists sorted by branch character
+    NodeId* last_child; // children arrive in lexicographic order, so they are appended here
+    NodeId* next_sibling;
+    uint8_t* branch;
+    uint32_t* child_count;
+    TextPos count;
+    TextPos capacity;
+ } SubtreeTable;
+
+ // State of one worker thread of the parallel builder
+ typedef struct {
+    int id;
+    int num_threads;
+    const char* sequence;
+    const int16_t* char_rank;
+    int alphabet_size;
+    int prefix_len; // k, length of the bucket prefixes
+    const CoverSample* sample; // shared, read-only: orders the suffixes of a bucket
+    TextPos* sample_positions; // sampled suffixes grouped by bucket, sorted and named bucket by bucket
+    const TextPos* sample_start; // [num_buckets + 1]
+    TextPos* sample_names; // [num_buckets] names given in each bucket, then the names before the bucket
+    TextPos* names; // [sample_size + 1] names of the sampled suffixes (see rank_cover_sample)
+    TextPos* positions; // suffixes grouped by bucket (shared, each bucket is touched by one worker)
+    TextPos* rank; // [n] inverse of positions while the LCP array is computed
+    TextPos* lcp; // [n] LCP array of positions once every bucket is sorted
+    const TextPos* bucket_start; // [num_buckets + 1]
+    int num_buckets;
+    int* next_bucket; // shared work counter
+    NodeId* bucket_root; // [num_buckets] private root of each bucket's subtree
+    int* bucket_worker; // [num_buckets] worker that built each bucket
+    NodeTable* tree; // final table (leaf arrays written directly)
+
+    SubtreeTable nodes;
+    int* buckets_done; // buckets this worker built
+    int num_done;
+    TextPos base; // internal index of this worker's first node in the final table
+    NodeId* stack; // [largest bucket + 1] rightmost path of the subtree being built
+ } ParallelWorker;
+
+ // Batch of pattern queries shared by the threads of the tree query engine. Threads claim
+ // QUERY_BATCH_SIZE patterns at a time and write only the result slots of the patterns they claimed.
+ typedef struct {
+    const SuffixTree* st; // read-only, shared
+    char** patterns;
+    int num_patterns;
+    bool locate; // also collect the positions of every occurrence
+    int next_pattern; // shared work counter
+    TextPos* counts; // [num_patterns] occurrences of each pattern
+    TextPos** positions; // [num_patterns] sorted positions of each pattern (NULL if none or not locating)
+ } QueryBatch;
+
+ #define TREE_FILE_SECTIONS 16 // arrays stored in a tree file
+
+ // Header of a tree file: everything is stored as offsets from the start of the file, so the file
+ // can be mapped at any address. The checksum covers every byte after the header.
+ typedef struct {
+    char magic[8]; // "STREEIDX"
+    uint32_t version;
+    uint32_t endian_check; // 0x01020304 as written by the host that built the file
+    uint32_t node_id_size; // sizeof(NodeId) of the build
+    uint32_t section_count;
+    int64_t str_len;
+    int32_t alphabet_size;
+    int32_t reserved;
+    int64_t internal_count;
+    int64_t dense_count;
+    uint64_t sequence_hash; // FNV-1a of the sequence string the tree was built from
+    uint64_t checksum;
+    uint64_t file_size;
+    uint64_t section_offset[TREE_FILE_SECTIONS]; // 8-byte aligned
+    int16_t char_rank[256];
+ } TreeFileHeader;
+
+ // Suffix array with its LCP array: the leaf order of the suffix tree without the tree.
+ // sa[i] is the start of the ith smallest suffix; lcp[i] is the length of the longest common prefix
+ // of suffixes sa[i - 1] and sa[i] (lcp[0] = 0). Internal tree nodes correspond to lcp-intervals.
+ typedef struct {
+    char* sequence; // owned copy of the sequence string (ends with $)
+    TextPos str_len; // length of sequence (including $)
+    char* alphabet; // owned copy of the alphabet (including $)
+    int alphabet_size;
+    int16_t char_rank[256]; // index in the alphabet of every byte value, -1 if not in the alphabet
+    TextPos* sa; // [n] suffix start positions in lexicographic order (a window buffer when read from file)
+    TextPos* lcp; // [n] LCP of adjacent suffixes, NULL until computed (a window buffer when read from file)
+    FILE* file; // index file the sections are read from a window at a time (NULL when sa and lcp are owned arrays)
+    uint64_t sa_offset; // offsets of the sections in file
+    uint64_t lcp_offset;
+    size_t file_size;
+    TextPos window; // positions read at a time from file (n for owned arrays)
+ } SuffixArray;
+
+ // Header of an on-disk suffix array index: sa[n] and lcp[n] as TextPos sections at 8-byte aligned offsets
+ typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t endian_check; // reads back differently on a machine of the other byte order
+    uint32_t pos_size; // sizeof(TextPos) of the build
+    int32_t alphabet_size;
+    int64_t str_len;
+    uint64_t sequence_hash; // FNV-1a of the sequence string the index was built from
+    uint64_t checksum; // over everything after the header
+    uint64_t file_size;
+    uint64_t sa_offset;
+    uint64_t lcp_offset;
+ } IndexFileHeader;
+
+ // FM-index occurrence block for DNA: 64 BWT characters as 2-bit codes plus the count of every code
+ // before the block. 32 bytes in the compact build, so a rank query touches a single cache line (48 in the 64-bit build).
+ typedef struct {
+    TextPos counts[4]; // occurrences of each code in the BWT before this block
+    uint64_t bits[2]; // 2-bit codes of the block's 64 characters, first character in the low bits
+ } OccBlock;
+
+ // FM-index over a BWT: C array, occurrence tables and a sampled suffix array.
+ // Alphabets of up to 4 symbols (+ $) use packed OccBlocks; larger ones keep one byte per character
+ // with per-block counts. $ is never stored as a symbol: its single row is kept in dollar_row.
+ typedef struct {
+    TextPos str_len; // n, length of the BWT (including $)
+    char* alphabet; // owned copy of the alphabet (including $)
+    int num_symbols; // alphabet size excluding $
+    int16_t code[256]; // symbol code (alphabet index - 1) of every byte, -1 for $ and bytes not in the alphabet
+    TextPos dollar_row; // row whose BWT character is $
+    TextPos C[256]; // C[c] = number of characters in the text smaller than symbol c (including $)
+    TextPos num_blocks; // occurrence blocks of FM_BLOCK_SIZE characters (n / FM_BLOCK_SIZE + 1)
+
+    bool packed; // true: blocks hold everything; false: bwt_codes + block_counts
+    OccBlock* blocks; // [num_blocks] packed path
+    uint8_t* bwt_codes; // [n] byte path, code of each BWT character ($ stored as 0)
+    TextPos* block_counts; // [num_blocks * num_symbols] byte path
+
+    int sample_rate; // SA value kept for every text position divisible by sample_rate
+    TextPos* sa_samples; // SA values of the sampled rows, in row order
+    uint64_t* sampled; // bit per row: 1 if the row's SA value is sampled
+    TextPos* sampled_rank; // sampled rows before each 64-bit word of sampled
+ } FMIndex;
+
+ // Longest common extension queries over one text: rank of every suffix and the LCP of lexicographic
+ // neighbours, with a sparse table over the minima of LCE_BLOCK-sized blocks of lcp, so a query is a
+ // lookup in the table plus a scan of at most two partial blocks.
+ #define LCE_BLOCK 32
+
+ typedef struct {
+    TextPos n; // length of the text (including $)
+    TextPos* rank; // [n] position of every suffix in lexicographic order
+    TextPos* lcp; // [n] LCP of the suffix at each rank with the one before it (lcp[0] = 0)
+    TextPos num_blocks;
+    int levels; // rows of block_min
+    TextPos* block_min; // [levels * num_blocks] row k: minimum lcp over blocks j...j + 2^k - 1
+ } LCEIndex;
+
+ typedef struct {
+    TextPos length;
+    TextPos* positions;
+    TextPos count;
 } LongestRepeat;
 
+ // Accumulators of the tree walks built on visit_tree
+ typedef struct {
+    TextPos internal_nodes; // excluding the root
+    TextPos leaves;
+    TextPos total_nodes;
+    long long total_internal_depth;
+    TextPos max_depth;
+ } TreeStats;
+
+ typedef struct {
+    char* bwt; // [n] BWT characters in leaf order
+    TextPos count; // characters written so far
+ } BwtWalk;
+
+ // State of mine_repeats: summaries of finished internal nodes, indexed by id - n
+ typedef struct {
+    FILE* file;
+    TextPos min_length;
+    TextPos min_count;
+    uint64_t* left_mask; // left characters of the node's leaves as alphabet bits
+    uint8_t* left_diverse; // leaves preceded by two different characters (or two sequence/record starts)
+    TextPos* count; // leaves below the node
+    TextPos* start; // first leaf below the node in lexicographic order
+    long long num_maximal;
+    long long num_supermaximal;
+ } RepeatWalk;
+
+ // On-disk encodings of a BWT
+ typedef enum {
+    BWT_FORMAT_TEXT, // one character per line (compatibility)
+    BWT_FORMAT_RAW, // one byte per character
+    BWT_FORMAT_PACKED, // 2-bit codes for the four most frequent characters, the rest as exceptions
+    BWT_FORMAT_RLE // (run length, character) pairs
+ } BwtFormat;
+
+ // Header of a binary BWT file (raw, packed and run-length formats). After it come:
+ // raw: the n characters; packed: (n + 3) / 4 bytes of 2-bit codes (first character in the low bits),
+ // then count int64_t exception positions and count exception characters; rle: count runs, each a
+ // LEB128 varint length followed by the character.
+ typedef struct {
+    char magic[8]; // "BWTINDEX"
+    uint32_t version;
+    uint32_t endian_check; // reads back differently on a machine of the other byte order
+    uint32_t format; // BwtFormat
+    char symbols[4]; // packed: character of each 2-bit code
+    int64_t str_len; // n, characters of the BWT (including $)
+    int64_t count; // packed: exceptions, rle: runs
+ } BwtFileHeader;
+
+ // Buffered output of the BWT writers: one fwrite per filled buffer instead of a libc call per character
+ typedef struct {
+    FILE* file;
+    uint8_t* data;
+    size_t used;
+    size_t size;
+    uint64_t written; // bytes handed to fwrite so far
+    bool ok; // every fwrite succeeded
+ } OutputBuffer;
+
+ // Header of a compressed sequence file (.bwz, see write_codec_file). After it come the sequence name,
+ // the BWT row of each inversion stream (int64_t) and the blocks of the BWT, each: its BWT characters,
+ // codec symbols and rANS bytes (uint32_t each), the number of symbols used (uint16_t), their
+ // (symbol, frequency) pairs (uint16_t each) and the rANS bytes.
+ typedef struct {
+    char magic[8]; // "BWTCODEC"
+    uint32_t version;
+    uint32_t endian_check; // reads back differently on a machine of the other byte order
+    uint32_t block_size; // BWT characters per block
+    uint32_t name_length;
+    int64_t str_len; // n, characters of the sequence (including $)
+    int64_t num_blocks;
+    uint32_t checksum; // CRC-32 of the BWT
+    uint32_t num_streams; // inversion streams (see invert_bwt)
+ } CodecFileHeader;
+
+ // One block of a compressed sequence file, located in the file image read into memory
+ typedef struct {
+    TextPos offset; // first BWT character of the block
+    uint32_t length;
+    uint32_t num_symbols;
+    uint32_t coded_size;
+    uint16_t num_used;
+    const uint8_t* pairs; // num_used (symbol, frequency) pairs of uint16_t
+    const uint8_t* coded;
+    uint32_t crc; // CRC-32 of the decoded block
+ } CodecBlock;
+
+ // Decoding work shared by the threads of read_codec_file and invert_bwt. Blocks are claimed through
+ // next_block; the BWT and the inversion streams are split into one contiguous range per thread.
+ typedef struct {
+    int num_threads;
+    CodecBlock* blocks;
+    int64_t num_blocks;
+    int64_t next_block; // shared work counter
+    const char* bwt;
+    TextPos n;
+    TextPos (*counts)[256]; // [num_threads] occurrences of each character in each thread's range, then LF bases
+    TextPos* lf; // [n] LF mapping
+    const int64_t* stream_rows;
+    int num_streams;
+    char* text;
+    int failed; // set by any thread whose part does not decode
+ } CodecJob;
+
+ typedef struct {
+    CodecJob* job;
+    int id;
+ } CodecWorker;
+
+ // State of the FASTA loader between chunks of input (a whole mapped file, or decompressed blocks)
+ typedef struct {
+    uint8_t invalid[256]; // 1 for every byte that is not a sequence character
+    Sequence* records;
+    size_t count;
+    size_t capacity; // records allocated
+    size_t max_records;
+    size_t* record_start; // [capacity] offset of each record's sequence in buffer
+    char* buffer; // every sequence, each followed by "$\0"
+    size_t out; // next free byte of buffer
+    size_t buffer_size;
+    bool fixed_buffer; // sized from the file length up front, never grows
+    char* name; // header of the current record, possibly split across chunks
+    size_t name_length;
+    size_t name_capacity;
+    bool at_line_start;
+    bool in_header;
+    bool open_record; // the last record still needs its "$\0"
+    bool done; // max_records read
+ } FastaParser;
+
 
 #endif 
\ No newline at end of file
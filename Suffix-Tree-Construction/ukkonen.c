@@ -0,0 +1,401 @@
+#include "ukkonen.h"
+#include "input_parser.h"
+#include "input_stream.h"
+
+#define UKK_ROOT 0u
+
+// helper functions: builder node references (UKK_LEAF | suffix index, or internal node number)
+bool ukk_is_leaf(NodeId node) {
+    return node != NO_NODE && (node & UKK_LEAF);
+}
+
+TextPos ukk_depth(const UkkonenBuilder* b, NodeId node) {
+    return ukk_is_leaf(node) ? b->length - (TextPos)(node & ~UKK_LEAF) : b->depth[node];
+}
+
+NodeId ukk_parent(const UkkonenBuilder* b, NodeId node) {
+    return ukk_is_leaf(node) ? b->leaf_parent[node & ~UKK_LEAF] : b->parent[node];
+}
+
+void ukk_set_parent(UkkonenBuilder* b, NodeId node, NodeId parent) {
+    if (ukk_is_leaf(node)) {
+        b->leaf_parent[node & ~UKK_LEAF] = parent;
+    } else {
+        b->parent[node] = parent;
+    }
+}
+
+NodeId ukk_next_sibling(const UkkonenBuilder* b, NodeId node) {
+    return ukk_is_leaf(node) ? b->leaf_next_sibling[node & ~UKK_LEAF] : b->next_sibling[node];
+}
+
+void ukk_set_next_sibling(UkkonenBuilder* b, NodeId node, NodeId sibling) {
+    if (ukk_is_leaf(node)) {
+        b->leaf_next_sibling[node & ~UKK_LEAF] = sibling;
+    } else {
+        b->next_sibling[node] = sibling;
+    }
+}
+
+int ukk_branch(const UkkonenBuilder* b, NodeId node) {
+    return ukk_is_leaf(node) ? b->leaf_branch[node & ~UKK_LEAF] : b->branch[node];
+}
+
+void ukk_set_branch(UkkonenBuilder* b, NodeId node, int branch) {
+    if (ukk_is_leaf(node)) {
+        b->leaf_branch[node & ~UKK_LEAF] = (uint8_t)branch;
+    } else {
+        b->branch[node] = (uint8_t)branch;
+    }
+}
+
+// start of the incoming edge label (a leaf's label starts right below its parent's depth)
+TextPos ukk_edge_start(const UkkonenBuilder* b, NodeId node) {
+    if (ukk_is_leaf(node)) {
+        return (TextPos)(node & ~UKK_LEAF) + b->depth[b->leaf_parent[node & ~UKK_LEAF]];
+    }
+    return b->edge_start[node];
+}
+
+// length of the incoming edge label (leaf edges are open and grow with the text)
+TextPos ukk_edge_length(const UkkonenBuilder* b, NodeId node) {
+    return ukk_depth(b, node) - b->depth[ukk_parent(b, node)];
+}
+
+NodeId ukk_get_child(const UkkonenBuilder* b, NodeId node, int branch) {
+    for (NodeId child = b->first_child[node]; child != NO_NODE; child = ukk_next_sibling(b, child)) {
+        int child_branch = ukk_branch(b, child);
+        if (child_branch == branch) return child;
+        if (child_branch > branch) break; // sorted list
+    }
+    return NO_NODE;
+}
+
+// links a child under an internal node, keeping the sibling list sorted by branch character
+void ukk_add_child(UkkonenBuilder* b, NodeId node, int branch, NodeId child) {
+    ukk_set_branch(b, child, branch);
+    ukk_set_parent(b, child, node);
+
+    NodeId prev = NO_NODE;
+    NodeId curr = b->first_child[node];
+    while (curr != NO_NODE && ukk_branch(b, curr) < branch) {
+        prev = curr;
+        curr = ukk_next_sibling(b, curr);
+    }
+
+    ukk_set_next_sibling(b, child, curr);
+    if (prev == NO_NODE) {
+        b->first_child[node] = child;
+    } else {
+        ukk_set_next_sibling(b, prev, child);
+    }
+    b->child_count[node]++;
+}
+
+// puts new_child in the place of old_child among node's children (same branch character)
+void ukk_replace_child(UkkonenBuilder* b, NodeId node, NodeId old_child, NodeId new_child) {
+    ukk_set_branch(b, new_child, ukk_branch(b, old_child));
+    ukk_set_parent(b, new_child, node);
+    ukk_set_next_sibling(b, new_child, ukk_next_sibling(b, old_child));
+
+    if (b->first_child[node] == old_child) {
+        b->first_child[node] = new_child;
+    } else {
+        NodeId prev = b->first_child[node];
+        while (ukk_next_sibling(b, prev) != old_child) {
+            prev = ukk_next_sibling(b, prev);
+        }
+        ukk_set_next_sibling(b, prev, new_child);
+    }
+}
+
+// helper function: grows the text and leaf arrays to hold at least `needed` characters
+void ukk_reserve_text(UkkonenBuilder* b, TextPos needed) {
+    if (needed <= b->capacity) return;
+
+    TextPos new_capacity = b->capacity * 2;
+    if (new_capacity < needed) new_capacity = needed;
+
+    char* text = realloc(b->text, new_capacity + 1);
+    NodeId* leaf_parent = realloc(b->leaf_parent, new_capacity * sizeof(NodeId));
+    NodeId* leaf_next_sibling = realloc(b->leaf_next_sibling, new_capacity * sizeof(NodeId));
+    uint8_t* leaf_branch = realloc(b->leaf_branch, new_capacity * sizeof(uint8_t));
+    if (!text || !leaf_parent || !leaf_next_sibling || !leaf_branch) {
+        perror("Could not grow online builder text");
+        exit(1);
+    }
+
+    b->text = text;
+    b->leaf_parent = leaf_parent;
+    b->leaf_next_sibling = leaf_next_sibling;
+    b->leaf_branch = leaf_branch;
+    b->capacity = new_capacity;
+}
+
+// helper function: hands out the next internal node number, growing the arrays as needed
+NodeId ukk_create_internal_node(UkkonenBuilder* b) {
+    if (b->internal_count >= b->internal_capacity) {
+        TextPos new_capacity = b->internal_capacity * 2;
+        b->depth = realloc(b->depth, new_capacity * sizeof(TextPos));
+        b->edge_start = realloc(b->edge_start, new_capacity * sizeof(TextPos));
+        b->parent = realloc(b->parent, new_capacity * sizeof(NodeId));
+        b->suff_link = realloc(b->suff_link, new_capacity * sizeof(NodeId));
+        b->first_child = realloc(b->first_child, new_capacity * sizeof(NodeId));
+        b->next_sibling = realloc(b->next_sibling, new_capacity * sizeof(NodeId));
+        b->branch = realloc(b->branch, new_capacity * sizeof(uint8_t));
+        b->child_count = realloc(b->child_count, new_capacity * sizeof(uint32_t));
+        if (!b->depth || !b->edge_start || !b->parent || !b->suff_link || !b->first_child ||
+            !b->next_sibling || !b->branch || !b->child_count) {
+            perror("Could not grow online builder nodes");
+            exit(1);
+        }
+        b->internal_capacity = new_capacity;
+    }
+
+    NodeId i = (NodeId)b->internal_count++;
+    b->depth[i] = 0;
+    b->edge_start[i] = 0;
+    b->parent[i] = NO_NODE;
+    b->suff_link[i] = UKK_ROOT;
+    b->first_child[i] = NO_NODE;
+    b->next_sibling[i] = NO_NODE;
+    b->branch[i] = 0;
+    b->child_count[i] = 0;
+    return i;
+}
+
+// CreateUkkonenBuilder
+UkkonenBuilder* create_ukkonen_builder(const char* alphabet) {
+    UkkonenBuilder* b = (UkkonenBuilder*)calloc(1, sizeof(UkkonenBuilder));
+    if (!b) {
+        perror("Could not allocate memory for online builder");
+        exit(1);
+    }
+
+    b->alphabet = strdup(alphabet);
+    if (!b->alphabet) {
+        perror("Could not copy alphabet into online builder");
+        exit(1);
+    }
+    b->alphabet_size = strlen(alphabet);
+    build_char_rank(b->char_rank, "", alphabet);
+
+    b->capacity = 0;
+    ukk_reserve_text(b, 1024);
+    b->internal_capacity = 1024;
+    b->depth = malloc(b->internal_capacity * sizeof(TextPos));
+    b->edge_start = malloc(b->internal_capacity * sizeof(TextPos));
+    b->parent = malloc(b->internal_capacity * sizeof(NodeId));
+    b->suff_link = malloc(b->internal_capacity * sizeof(NodeId));
+    b->first_child = malloc(b->internal_capacity * sizeof(NodeId));
+    b->next_sibling = malloc(b->internal_capacity * sizeof(NodeId));
+    b->branch = malloc(b->internal_capacity * sizeof(uint8_t));
+    b->child_count = malloc(b->internal_capacity * sizeof(uint32_t));
+    if (!b->depth || !b->edge_start || !b->parent || !b->suff_link || !b->first_child ||
+        !b->next_sibling || !b->branch || !b->child_count) {
+        perror("Could not allocate memory for online builder nodes");
+        exit(1);
+    }
+
+    // root: parent and suffix link point to itself
+    NodeId root = ukk_create_internal_node(b);
+    b->parent[root] = root;
+    b->suff_link[root] = root;
+
+    b->active_node = root;
+    b->active_edge = 0;
+    b->active_length = 0;
+    b->remainder = 0;
+
+    return b;
+}
+
+// helper function: one Ukkonen phase, extending every pending suffix by text[pos]
+void ukk_extend(UkkonenBuilder* b, TextPos pos) {
+    const char* text = b->text;
+    int c = b->char_rank[(unsigned char)text[pos]];
+    NodeId last_new = NO_NODE; // internal node waiting for its suffix link
+
+    b->remainder++;
+    while (b->remainder > 0) {
+        if (b->active_length == 0) {
+            b->active_edge = pos;
+        }
+
+        int edge_branch = b->char_rank[(unsigned char)text[b->active_edge]];
+        NodeId child = ukk_get_child(b, b->active_node, edge_branch);
+        TextPos suffix = pos - b->remainder + 1;
+
+        if (child == NO_NODE) {
+            // rule 2: new leaf straight off the active node
+            ukk_add_child(b, b->active_node, edge_branch, UKK_LEAF | (NodeId)suffix);
+            if (last_new != NO_NODE) {
+                b->suff_link[last_new] = b->active_node;
+                last_new = NO_NODE;
+            }
+        }
+        else {
+            // skip/count down edges shorter than the active length
+            TextPos length = ukk_edge_length(b, child);
+            if (b->active_length >= length) {
+                b->active_edge += length;
+                b->active_length -= length;
+                b->active_node = child;
+                continue;
+            }
+
+            // rule 3: the character is already on the edge, the phase ends
+            if (b->char_rank[(unsigned char)text[ukk_edge_start(b, child) + b->active_length]] == c) {
+                if (last_new != NO_NODE && b->active_node != UKK_ROOT) {
+                    b->suff_link[last_new] = b->active_node;
+                    last_new = NO_NODE;
+                }
+                b->active_length++;
+                break;
+            }
+
+            // rule 2: split the edge and hang the new leaf off the split node
+            TextPos start = ukk_edge_start(b, child);
+            NodeId split = ukk_create_internal_node(b);
+            b->depth[split] = b->depth[b->active_node] + b->active_length;
+            b->edge_start[split] = start;
+            ukk_replace_child(b, b->active_node, child, split);
+
+            if (!ukk_is_leaf(child)) {
+                b->edge_start[child] = start + b->active_length;
+            }
+            ukk_add_child(b, split, b->char_rank[(unsigned char)text[start + b->active_length]], child);
+            ukk_add_child(b, split, c, UKK_LEAF | (NodeId)suffix);
+
+            if (last_new != NO_NODE) {
+                b->suff_link[last_new] = split;
+            }
+            last_new = split;
+        }
+
+        b->remainder--;
+        if (b->active_node == UKK_ROOT && b->active_length > 0) {
+            b->active_length--;
+            b->active_edge = pos - b->remainder + 1;
+        }
+        else if (b->active_node != UKK_ROOT) {
+            b->active_node = b->suff_link[b->active_node];
+        }
+    }
+}
+
+// UkkonenAppend
+void ukkonen_append(UkkonenBuilder* b, const char* chunk, int len) {
+    ukk_reserve_text(b, b->length + len + 1); // + room for $
+
+    for (int i = 0; i < len; i++) {
+        char ch = chunk[i];
+        if (b->char_rank[(unsigned char)ch] < 0 || ch == '$') {
+            fprintf(stderr, "Error: Invalid character %c at position %lld in sequence (not in alphabet)\n",
+                    ch, (long long)b->length);
+            exit(1);
+        }
+
+        b->text[b->length++] = ch;
+        ukk_extend(b, b->length - 1);
+    }
+}
+
+// UkkonenFinish
+SuffixTree* ukkonen_finish(UkkonenBuilder* b) {
+    // $ is unique, so every suffix ends at a leaf afterwards
+    ukk_reserve_text(b, b->length + 1);
+    b->text[b->length++] = '$';
+    b->text[b->length] = '\0';
+    ukk_extend(b, b->length - 1);
+
+    SuffixTree* st = create_suffix_tree(b->text, b->alphabet);
+    NodeTable* tree = &st->nodes;
+    NodeId n = (NodeId)b->length;
+
+    // builder references -> NodeIds: leaves keep their suffix index, internal node i becomes n + i
+    #define UKK_MAP(x) ((x) == NO_NODE ? NO_NODE : ukk_is_leaf(x) ? ((x) & ~UKK_LEAF) : n + (x))
+
+    for (TextPos i = 1; i < b->internal_count; i++) {
+        create_internal_node(tree); // the root (i = 0) already exists
+    }
+    for (TextPos i = 0; i < b->internal_count; i++) {
+        tree->depth[i] = b->depth[i];
+        tree->edge_start[i] = b->edge_start[i];
+        tree->parent[i] = UKK_MAP(b->parent[i]);
+        tree->suff_link[i] = UKK_MAP(b->suff_link[i]);
+        tree->first_child[i] = UKK_MAP(b->first_child[i]);
+        tree->next_sibling[i] = UKK_MAP(b->next_sibling[i]);
+        tree->branch[i] = b->branch[i];
+        tree->child_count[i] = b->child_count[i];
+    }
+    for (NodeId j = 0; j < n; j++) {
+        tree->leaf_parent[j] = UKK_MAP(b->leaf_parent[j]);
+        tree->leaf_next_sibling[j] = UKK_MAP(b->leaf_next_sibling[j]);
+        tree->leaf_branch[j] = b->leaf_branch[j];
+    }
+    for (TextPos i = 0; i < b->internal_count; i++) {
+        if (tree->child_count[i] > DENSE_FANOUT) {
+            make_dense(tree, n + i);
+        }
+    }
+
+    #undef UKK_MAP
+
+    free_ukkonen_builder(b);
+    return st;
+}
+
+// FreeUkkonenBuilder
+void free_ukkonen_builder(UkkonenBuilder* b) {
+    if (!b) return;
+
+    free(b->text);
+    free(b->alphabet);
+    free(b->leaf_parent);
+    free(b->leaf_next_sibling);
+    free(b->leaf_branch);
+    free(b->depth);
+    free(b->edge_start);
+    free(b->parent);
+    free(b->suff_link);
+    free(b->first_child);
+    free(b->next_sibling);
+    free(b->branch);
+    free(b->child_count);
+    free(b);
+}
+
+// BuildSuffixTreeOnline
+SuffixTree* build_suffix_tree_online(const char* filename, const char* alphabet) {
+    InputStream* in = open_input_stream(filename, 0); // gzip/BGZF inflated on the fly
+    if (!in) {
+        perror("Error opening file");
+        exit(1);
+    }
+
+    UkkonenBuilder* b = create_ukkonen_builder(alphabet);
+    bool in_sequence = false;
+    char* line = NULL; // whole lines, so a long header is never mistaken for sequence
+    size_t capacity = 0;
+    size_t length;
+
+    while ((length = input_stream_getline(&line, &capacity, in)) > 0) {
+        if (line[0] == '>') {
+            if (in_sequence) break; // only the first sequence, like read_string_sequence
+            in_sequence = true;
+            continue;
+        }
+        if (!in_sequence) continue;
+
+        while (length > 0 && (line[length - 1] == '\n' || line[length - 1] == '\r')) length--;
+        ukkonen_append(b, line, length);
+    }
+    free(line);
+
+    if (close_input_stream(in) != 0) {
+        fprintf(stderr, "Error: %s is corrupt or truncated\n", filename);
+        exit(1);
+    }
+    return ukkonen_finish(b);
+}
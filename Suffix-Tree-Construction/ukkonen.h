@@ -0,0 +1,49 @@
+#ifndef UKKONEN_H
+#define UKKONEN_H
+
+#include "types.h"
+#include "suffix_tree.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdint.h>
+
+// CreateUkkonenBuilder
+/**
+ * Creates an empty online builder (just the root).
+ * @alphabet: alphabet the sequence is comprised of (including $)
+ */
+UkkonenBuilder* create_ukkonen_builder(const char* alphabet);
+
+// UkkonenAppend
+/**
+ * Extends the implicit suffix tree by each character of a chunk (amortized O(1) per character).
+ * The tree always indexes everything appended so far, so it can be grown as data arrives.
+ * @b: builder to extend
+ * @chunk: characters to append (in the alphabet, no $)
+ * @len: number of characters
+ */
+void ukkonen_append(UkkonenBuilder* b, const char* chunk, int len);
+
+// UkkonenFinish
+/**
+ * Appends the $ terminator, which turns every remaining implicit suffix into a leaf, and converts
+ * the builder into a SuffixTree (internal node i becomes n + i). The builder is freed.
+ * @returns - suffix tree; free_suffix_tree releases it
+ */
+SuffixTree* ukkonen_finish(UkkonenBuilder* b);
+
+// FreeUkkonenBuilder
+void free_ukkonen_builder(UkkonenBuilder* b);
+
+// BuildSuffixTreeOnline
+/**
+ * Builds the suffix tree of the first sequence of a FASTA file while reading it:
+ * every sequence line is appended as soon as it is parsed, so parsing and construction overlap.
+ * @filename: FASTA file
+ * @alphabet: alphabet the sequence is comprised of (including $)
+ * @returns - suffix tree of the sequence + $
+ */
+SuffixTree* build_suffix_tree_online(const char* filename, const char* alphabet);
+
+#endif